@@ -0,0 +1,183 @@
+//
+//  bench.cpp
+//
+
+#include "bench.hpp"
+#include "graph.hpp"
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <sys/resource.h>
+
+namespace dg {
+
+/// Results of the benchmarked calls are folded in here so that they can't be optimized away
+static volatile uint64_t bench_sink = 0;
+
+uint64_t peak_rss_bytes(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    // reported in bytes on macOS
+    return usage.ru_maxrss;
+#else
+    // and in kilobytes on Linux
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+std::vector<bench_result_t> run_graph_benchmarks(const bench_params_t& params) {
+    std::vector<bench_result_t> results;
+    std::mt19937_64 rng(params.seed);
+    uint64_t n = params.node_count;
+    uint64_t max_length = std::max<uint64_t>(1, 2 * params.node_length - 1);
+    std::uniform_int_distribution<uint64_t> length_dist(1, max_length);
+    std::uniform_int_distribution<uint64_t> id_dist(1, std::max<uint64_t>(1, n));
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::bernoulli_distribution strand_dist(0.5);
+
+    // the sequences are generated up front so that only the graph is timed
+    std::vector<std::string> seqs(n);
+    for (auto& seq : seqs) {
+        seq.resize(length_dist(rng));
+        for (auto& c : seq) c = "ACGT"[base_dist(rng)];
+    }
+    std::vector<uint64_t> queries(params.query_count);
+    for (auto& id : queries) id = id_dist(rng);
+
+    graph_t graph;
+    results.push_back(bench_run("create_handle", n, [&]() {
+                for (uint64_t i = 0; i < n; ++i) {
+                    graph.create_handle(seqs[i], i + 1);
+                }
+            }));
+    // a backbone, with every tenth node skippable to make simple bubbles
+    uint64_t edge_count = 0;
+    for (uint64_t i = 1; i < n; ++i) {
+        edge_count += (i % 10 == 0 && i + 1 < n) ? 2 : 1;
+    }
+    results.push_back(bench_run("create_edge", edge_count, [&]() {
+                for (uint64_t i = 1; i < n; ++i) {
+                    graph.create_edge(graph.get_handle(i), graph.get_handle(i + 1));
+                    if (i % 10 == 0 && i + 1 < n) {
+                        graph.create_edge(graph.get_handle(i), graph.get_handle(i + 2));
+                    }
+                }
+            }));
+    // divide_handle edits the topology, so it gets a copy without paths
+    graph_t divide_graph;
+    if (params.divide_count) divide_graph = graph;
+    path_handle_t path = graph.create_path_handle("bench");
+    results.push_back(bench_run("append_occurrence", n, [&]() {
+                for (uint64_t i = 1; i <= n; ++i) {
+                    graph.append_occurrence(path, graph.get_handle(i));
+                }
+            }));
+    if (n == 0) return results;
+
+    results.push_back(bench_run("get_handle", queries.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto id : queries) {
+                    sum += as_integer(graph.get_handle(id, id & 1));
+                }
+                bench_sink += sum;
+            }));
+    std::vector<handle_t> handles;
+    handles.reserve(queries.size());
+    for (auto id : queries) {
+        handles.push_back(graph.get_handle(id, strand_dist(rng)));
+    }
+    results.push_back(bench_run("get_sequence", handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    sum += graph.get_sequence(h).size();
+                }
+                bench_sink += sum;
+            }));
+    results.push_back(bench_run("follow_edges", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                const HandleGraph& base = graph;
+                for (auto& h : handles) {
+                    for (bool go_left : {false, true}) {
+                        base.follow_edges(h, go_left, [&](const handle_t& next) {
+                                sum += as_integer(next);
+                                return true;
+                            });
+                    }
+                }
+                bench_sink += sum;
+            }));
+    results.push_back(bench_run("follow_edges_fast", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    for (bool go_left : {false, true}) {
+                        graph.follow_edges_fast(h, go_left, [&](const handle_t& next) {
+                                sum += as_integer(next);
+                            });
+                    }
+                }
+                bench_sink += sum;
+            }));
+    results.push_back(bench_run("path_walk", graph.get_occurrence_count(path), [&]() {
+                uint64_t sum = 0;
+                occurrence_handle_t occ = graph.get_first_occurrence(path);
+                while (true) {
+                    sum += as_integer(graph.get_occurrence(occ));
+                    if (!graph.has_next_occurrence(occ)) break;
+                    occ = graph.get_next_occurrence(occ);
+                }
+                bench_sink += sum;
+            }));
+    if (!params.divide_count) return results;
+    // split distinct nodes that are long enough to split
+    std::vector<uint64_t> to_divide;
+    for (auto id : queries) {
+        if (to_divide.size() >= params.divide_count) break;
+        if (seqs[id - 1].size() > 1) {
+            to_divide.push_back(id);
+            seqs[id - 1].clear();
+        }
+    }
+    results.push_back(bench_run("divide_handle", to_divide.size(), [&]() {
+                for (auto id : to_divide) {
+                    handle_t h = divide_graph.get_handle(id);
+                    divide_graph.divide_handle(h, divide_graph.get_length(h) / 2);
+                }
+            }));
+    return results;
+}
+
+void write_bench_table(std::ostream& out, const std::vector<bench_result_t>& results) {
+    std::stringstream ss;
+    ss << std::left << std::setw(20) << "operation"
+       << std::right << std::setw(12) << "ops"
+       << std::setw(14) << "ns/op"
+       << std::setw(16) << "ops/s"
+       << std::setw(16) << "peak_rss" << std::endl;
+    ss << std::fixed;
+    for (auto& r : results) {
+        ss << std::left << std::setw(20) << r.name
+           << std::right << std::setw(12) << r.ops
+           << std::setw(14) << std::setprecision(1) << r.ns_per_op()
+           << std::setw(16) << std::setprecision(0) << r.ops_per_second()
+           << std::setw(16) << r.peak_rss << std::endl;
+    }
+    out << ss.str();
+}
+
+void write_bench_json(std::ostream& out, const std::vector<bench_result_t>& results) {
+    out << "[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        if (i) out << ",";
+        out << "{\"name\":\"" << r.name << "\""
+            << ",\"ops\":" << r.ops
+            << ",\"seconds\":" << r.seconds
+            << ",\"ns_per_op\":" << r.ns_per_op()
+            << ",\"ops_per_second\":" << r.ops_per_second()
+            << ",\"peak_rss\":" << r.peak_rss << "}";
+    }
+    out << "]";
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef dgraph_bench_hpp
+#define dgraph_bench_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+/** \file
+ * bench.hpp: timed micro-benchmarks of the handle graph operations, used by
+ * `dg bench` to catch performance regressions.
+ */
+
+namespace dg {
+
+/// The timing of one benchmarked operation
+struct bench_result_t {
+    /// the operation
+    std::string name;
+    /// how many times it was run
+    uint64_t ops = 0;
+    /// total wall-clock time taken
+    double seconds = 0;
+    /// peak resident set size of the process after the run, in bytes
+    uint64_t peak_rss = 0;
+
+    double ns_per_op(void) const { return ops ? seconds * 1e9 / ops : 0; }
+    double ops_per_second(void) const { return seconds > 0 ? ops / seconds : 0; }
+};
+
+/// Parameters of the benchmark graph and workload
+struct bench_params_t {
+    /// nodes in the benchmark graph
+    uint64_t node_count = 100000;
+    /// mean node length; lengths are drawn uniformly from [1, 2*mean-1]
+    uint64_t node_length = 8;
+    /// random lookups to run for each query benchmark
+    uint64_t query_count = 100000;
+    /// nodes to split in the divide_handle benchmark, which is skipped when
+    /// this is 0
+    uint64_t divide_count = 1000;
+    /// seed for the graph and the query order
+    uint64_t seed = 27;
+};
+
+/// Peak resident set size of this process so far, in bytes
+uint64_t peak_rss_bytes(void);
+
+/// Time a body that performs the given number of operations
+template<typename Body>
+bench_result_t bench_run(const std::string& name, uint64_t ops, Body&& body) {
+    bench_result_t result;
+    result.name = name;
+    result.ops = ops;
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.peak_rss = peak_rss_bytes();
+    return result;
+}
+
+/// Run the micro-benchmark suite against a freshly built graph_t
+std::vector<bench_result_t> run_graph_benchmarks(const bench_params_t& params);
+
+/// Write the results as an aligned table
+void write_bench_table(std::ostream& out, const std::vector<bench_result_t>& results);
+
+/// Write the results as a JSON array
+void write_bench_json(std::ostream& out, const std::vector<bench_result_t>& results);
+
+}
+
+#endif
@@ -1,302 +1,627 @@
 #include "bgraph.hpp"
+#include "dna.hpp"
+#include <algorithm>
+#include <cassert>
 
 namespace betagraph{
+
+    /// Build the handle to a step slot on a path
+    static occurrence_handle_t make_occurrence(uint64_t path_id, uint64_t slot){
+        occurrence_handle_t occ;
+        as_integers(occ)[0] = path_id;
+        as_integers(occ)[1] = slot;
+        return occ;
+    }
+
     BGraph::BGraph(){
 
     };
     BGraph::~BGraph(){
 
     };
-    handle_t BGraph::get_handle(const dg::id_t& node_id, bool is_reverse) const{
-        return hhelper.pack(node_id, is_reverse);
+
+    bool BGraph::has_node(id_t node_id) const{
+        return id_to_rank.has(node_id);
     }
-    
 
-    dg::id_t BGraph::get_id(const handle_t& handle) const{
-        return hhelper.unpack_number(handle);
+    handle_t BGraph::get_handle(const id_t& node_id, bool is_reverse) const{
+        return handle_helper::pack(id_to_rank.get(node_id), is_reverse);
+    }
+
+    id_t BGraph::get_id(const handle_t& handle) const{
+        return nodes[handle_helper::unpack_number(handle)].id;
     }
-    
 
     bool BGraph::get_is_reverse(const handle_t& handle) const{
-        return hhelper.unpack_bit(handle);
+        return handle_helper::unpack_bit(handle);
     }
-    
 
     handle_t BGraph::flip(const handle_t& handle) const{
-        return hhelper.toggle_bit(handle);
+        return handle_helper::toggle_bit(handle);
     }
-    
 
     size_t BGraph::get_length(const handle_t& handle) const{
-        return graph.backer.at(get_id(handle)).length;
+        return nodes[handle_helper::unpack_number(handle)].seq_length;
     }
 
     std::string BGraph::get_sequence(const handle_t& handle) const{
-        return graph.backer.at(get_id(handle)).sequence;
+        const bnode_t& node = nodes[handle_helper::unpack_number(handle)];
+        std::string seq = seq_store.substr(node.seq_begin, node.seq_length);
+        if (handle_helper::unpack_bit(handle)){
+            reverse_complement_in_place(seq);
+        }
+        return seq;
+    }
+
+    bool BGraph::follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const{
+        return follow_edges_fast(handle, go_left, iteratee);
     }
-    
-    // bool follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const{
 
-    // }
-    
     void BGraph::for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const{
-        std::atomic<bool> keep_going(true);
+        for_each_handle_fast(iteratee, parallel);
+    }
 
-        while(keep_going){
+    void BGraph::follow_edges_batch(const handle_t* in, size_t n, bool go_left, neighbor_batch_t& out) const{
+        // the degrees are read off the slices, so the result can be laid out first
+        out.offsets.resize(n + 1);
+        out.offsets[0] = 0;
+        for (size_t i = 0; i < n; ++i){
+            const bnode_t& node = nodes[handle_helper::unpack_number(in[i])];
+            bool rev = handle_helper::unpack_bit(in[i]);
+            out.offsets[i+1] = out.offsets[i] + ((go_left != rev) ? node.left : node.right).size;
+        }
+        out.handles.resize(out.offsets[n]);
+        for (size_t i = 0; i < n; ++i){
+            const bnode_t& node = nodes[handle_helper::unpack_number(in[i])];
+            bool rev = handle_helper::unpack_bit(in[i]);
+            const bslice_t& slice = (go_left != rev) ? node.left : node.right;
+            handle_t* dest = &out.handles[out.offsets[i]];
+            for (uint64_t j = 0; j < slice.size; ++j){
+                const handle_t& next = edge_store[slice.begin + j];
+                dest[j] = rev ? handle_helper::toggle_bit(next) : next;
+            }
+        }
+    }
 
-            //if (parallel){
+    size_t BGraph::node_size(void) const{
+        return num_nodes;
+    }
 
-            //}
-            //else{
-                for (auto g : graph.backer){
-                    if(!iteratee(get_handle(g.first, g.second.orientation))){
-                        keep_going = false;
-                    }
+    id_t BGraph::min_node_id(void) const{
+        return _min_node_id;
+    }
 
-                    if (!keep_going){
-                        break;
-                    }
+    id_t BGraph::max_node_id(void) const{
+        return _max_node_id;
+    }
+
+    size_t BGraph::get_degree(const handle_t& handle, bool go_left) const{
+        const bnode_t& node = nodes[handle_helper::unpack_number(handle)];
+        bool rev = handle_helper::unpack_bit(handle);
+        return (go_left != rev) ? node.left.size : node.right.size;
+    }
+
+    size_t BGraph::edge_size(void) const{
+        return num_edges;
+    }
+
+    bool BGraph::has_edge(const handle_t& left, const handle_t& right) const{
+        return !follow_edges_fast(left, false, [&right](const handle_t& next){
+                return next != right;
+            });
+    }
+
+    bslice_t& BGraph::side_of(const handle_t& handle, bool go_left){
+        bnode_t& node = nodes[handle_helper::unpack_number(handle)];
+        return (go_left != handle_helper::unpack_bit(handle)) ? node.left : node.right;
+    }
+
+    void BGraph::slice_append(bslice_t& slice, const handle_t& h){
+        if (slice.size == slice.capacity){
+            if (slice.capacity == 0 || slice.begin + slice.capacity == edge_store.size()){
+                // the slice ends the store, so it can grow where it is
+                if (slice.capacity == 0){
+                    slice.begin = edge_store.size();
                 }
-            //}
-            
+                edge_store.push_back(h);
+                ++slice.size;
+                ++slice.capacity;
+                return;
+            }
+            // move the slice to the end of the store with room to grow
+            uint64_t begin = edge_store.size();
+            uint32_t capacity = slice.capacity * 2;
+            edge_store.resize(begin + capacity);
+            std::copy(edge_store.begin() + slice.begin,
+                      edge_store.begin() + slice.begin + slice.size,
+                      edge_store.begin() + begin);
+            dead_edges += slice.capacity;
+            slice.begin = begin;
+            slice.capacity = capacity;
         }
+        edge_store[slice.begin + slice.size++] = h;
     }
-    
-    size_t BGraph::node_size(void) const{
-        return graph.backer.size();
-    }
-    
-    dg::id_t BGraph::min_node_id(void) const{
-        return graph.min_node_id;
-    }
-
-    dg::id_t BGraph::max_node_id(void) const{
-        return graph.max_node_id;
-    }
-  
-//     /// Get the number of edges on the right (go_left = false) or left (go_left
-//     /// = true) side of the given handle. The default implementation is O(n) in
-//     /// the number of edges returned, but graph implementations that track this
-//     /// information more efficiently can override this method.
-     size_t BGraph::get_degree(const handle_t& handle, bool go_left) const{
-         if (go_left){
-             return graph.backer.at(as_integer(handle)).in_edges.size();
-         }
-         else{
-             return graph.backer.at(as_integer(handle)).out_edges.size();
-         }
-     }
-  
-    /// Get the locally forward version of a handle
-    handle_t BGraph::forward(const handle_t& handle) const{
-        handle_t h(handle);
-        if (hhelper.unpack_bit(h)){
-            hhelper.toggle_bit(h);
-        }
-        return h;
-    }
-    
-    /// A pair of handles can be used as an edge. When so used, the handles have a
-    /// canonical order and orientation.
-    // edge_t BGraph::edge_handle(const handle_t& left, const handle_t& right) const{
-
-    // }
-    
-//     /// Such a pair can be viewed from either inward end handle and produce the
-//     /// outward handle you would arrive at.
-//     handle_t traverse_edge_handle(const edge_t& edge, const handle_t& left) const;
-    
+
+    bool BGraph::slice_remove(bslice_t& slice, const handle_t& h){
+        auto begin = edge_store.begin() + slice.begin;
+        auto end = begin + slice.size;
+        auto found = std::find(begin, end, h);
+        if (found == end){
+            return false;
+        }
+        std::copy(found + 1, end, found);
+        --slice.size;
+        return true;
+    }
+
+    void BGraph::neighbor_ranks(uint64_t rank, std::vector<uint64_t>& ranks) const{
+        const bnode_t& node = nodes[rank];
+        for (const bslice_t* slice : {&node.left, &node.right}){
+            for (uint64_t i = slice->begin; i < slice->begin + slice->size; ++i){
+                ranks.push_back(handle_helper::unpack_number(edge_store[i]));
+            }
+        }
+    }
+
 /**
  * This is the interface for a handle graph that stores embedded paths.
  */
-    
-    ////////////////////////////////////////////////////////////////////////////
-    // Path handle interface that needs to be implemented
-    ////////////////////////////////////////////////////////////////////////////
-    
-    /// Determine if a path name exists and is legal to get a path handle for.
-     bool BGraph::has_path(const std::string& path_name) const{
-         return paths.has_path(path_name);
-     }
-    
-    /// Look up the path handle for the given path name.
-    /// The path with that name must exist.
+
+    bool BGraph::has_path(const std::string& path_name) const{
+        return path_ids.count(path_name) != 0;
+    }
+
     path_handle_t BGraph::get_path_handle(const std::string& path_name) const{
-        return as_path_handle(paths.get_id(path_name));
+        return as_path_handle(path_ids.at(path_name));
     }
-    
-    /// Look up the name of a path from a handle to it
+
     std::string BGraph::get_path_name(const path_handle_t& path_handle) const{
-        return paths.get_name(path_handle);
+        return paths[as_integer(path_handle)].name;
     }
-    
-    /// Returns the number of node occurrences in the path
+
     size_t BGraph::get_occurrence_count(const path_handle_t& path_handle) const{
-        return paths.get_path_occurrence_count(path_handle);
+        return paths[as_integer(path_handle)].length;
     }
 
-    /// Returns the number of paths stored in the graph
     size_t BGraph::get_path_count() const{
-        return paths.paths.size();
+        return num_paths;
     }
-    
-    /// Execute a function on each path in the graph
-    // TODO: allow stopping early?
+
     void BGraph::for_each_path_handle(const std::function<void(const path_handle_t&)>& iteratee) const{
+        for (uint64_t i = 0; i < paths.size(); ++i){
+            if (paths[i].live){
+                iteratee(as_path_handle(i));
+            }
+        }
+    }
+
+    std::vector<occurrence_handle_t> BGraph::occurrences_of_handle(const handle_t& handle, bool match_orientation) const{
+        std::vector<occurrence_handle_t> found;
+        for (auto& occ : node_occurrences[handle_helper::unpack_number(handle)]){
+            if (!match_orientation || get_occurrence(occ) == handle){
+                found.push_back(occ);
+            }
+        }
+        return found;
+    }
+
+    handle_t BGraph::get_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        return paths[as_integers(occurrence_handle)[0]].steps[as_integers(occurrence_handle)[1]].handle;
+    }
+
+    occurrence_handle_t BGraph::get_first_occurrence(const path_handle_t& path_handle) const{
+        return make_occurrence(as_integer(path_handle), paths[as_integer(path_handle)].first);
+    }
+
+    occurrence_handle_t BGraph::get_last_occurrence(const path_handle_t& path_handle) const{
+        return make_occurrence(as_integer(path_handle), paths[as_integer(path_handle)].last);
+    }
+
+    bool BGraph::has_next_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        return paths[as_integers(occurrence_handle)[0]].steps[as_integers(occurrence_handle)[1]].next != bstep_none;
+    }
+
+    bool BGraph::has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        return paths[as_integers(occurrence_handle)[0]].steps[as_integers(occurrence_handle)[1]].prev != bstep_none;
+    }
+
+    occurrence_handle_t BGraph::get_next_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        uint64_t path_id = as_integers(occurrence_handle)[0];
+        return make_occurrence(path_id, paths[path_id].steps[as_integers(occurrence_handle)[1]].next);
+    }
+
+    occurrence_handle_t BGraph::get_previous_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        uint64_t path_id = as_integers(occurrence_handle)[0];
+        return make_occurrence(path_id, paths[path_id].steps[as_integers(occurrence_handle)[1]].prev);
+    }
+
+    path_handle_t BGraph::get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const{
+        return as_path_handle(as_integers(occurrence_handle)[0]);
+    }
+
+/**
+ * This is the interface for a handle graph that supports modification.
+ */
+
+    uint64_t BGraph::append_node(const id_t& id, uint64_t seq_begin, uint32_t seq_length){
+        assert(id > 0);
+        assert(!id_to_rank.has(id));
+        uint64_t rank = nodes.size();
+        bnode_t node;
+        node.id = id;
+        node.seq_begin = seq_begin;
+        node.seq_length = seq_length;
+        nodes.push_back(node);
+        node_occurrences.emplace_back();
+        id_to_rank.set(id, rank);
+        _min_node_id = num_nodes ? std::min(id, _min_node_id) : id;
+        _max_node_id = std::max(id, _max_node_id);
+        ++num_nodes;
+        return rank;
+    }
+
+    handle_t BGraph::create_handle(const std::string& sequence){
+        return create_handle(sequence, _max_node_id + 1);
+    }
+
+    handle_t BGraph::create_handle(const std::string& sequence, const id_t& id){
+        uint64_t seq_begin = seq_store.size();
+        seq_store.append(sequence);
+        return handle_helper::pack(append_node(id, seq_begin, sequence.size()), false);
+    }
+
+    void BGraph::destroy_handle(const handle_t& handle){
+        uint64_t rank = handle_helper::unpack_number(handle);
+        handle_t fwd = handle_helper::pack(rank, false);
+        std::vector<edge_t> edges;
+        follow_edges_fast(fwd, false, [&](const handle_t& h){
+                edges.push_back(std::make_pair(fwd, h));
+            });
+        follow_edges_fast(fwd, true, [&](const handle_t& h){
+                edges.push_back(std::make_pair(h, fwd));
+            });
+        for (auto& edge : edges){
+            destroy_edge(edge);
+        }
+        // the rank stays behind as a tombstone so other handles stay valid
+        bnode_t& node = nodes[rank];
+        dead_edges += node.left.capacity + node.right.capacity;
+        dead_bases += node.seq_length;
+        id_to_rank.erase(node.id);
+        node = bnode_t();
+        --num_nodes;
+    }
+
+    void BGraph::create_edge(const handle_t& left, const handle_t& right){
+        if (has_edge(left, right)) return;
+        if (dead_edges > 4096 && dead_edges * 2 > edge_store.size()){
+            compact_edges();
+        }
+        bool left_rev = handle_helper::unpack_bit(left);
+        bool right_rev = handle_helper::unpack_bit(right);
+        // each side stores the neighbor as seen from its forward orientation
+        slice_append(side_of(left, false), left_rev ? flip(right) : right);
+        // a reversing self loop lands in the same list twice with the same value
+        if (handle_helper::unpack_number(left) != handle_helper::unpack_number(right)
+            || left_rev == right_rev){
+            slice_append(side_of(right, true), right_rev ? flip(left) : left);
+        }
+        ++num_edges;
+    }
+
+    void BGraph::destroy_edge(const handle_t& left, const handle_t& right){
+        bool left_rev = handle_helper::unpack_bit(left);
+        bool right_rev = handle_helper::unpack_bit(right);
+        if (!slice_remove(side_of(left, false), left_rev ? flip(right) : right)){
+            return;
+        }
+        if (handle_helper::unpack_number(left) != handle_helper::unpack_number(right)
+            || left_rev == right_rev){
+            slice_remove(side_of(right, true), right_rev ? flip(left) : left);
+        }
+        --num_edges;
+    }
+
+    void BGraph::clear(void){
+        nodes.clear();
+        seq_store.clear();
+        edge_store.clear();
+        id_to_rank.clear();
+        node_occurrences.clear();
+        paths.clear();
+        path_ids.clear();
+        num_nodes = 0;
+        num_edges = 0;
+        num_paths = 0;
+        _min_node_id = 0;
+        _max_node_id = 0;
+        dead_edges = 0;
+        dead_bases = 0;
+    }
+
+    void BGraph::swap_handles(const handle_t& a, const handle_t& b){
+        uint64_t rank_a = handle_helper::unpack_number(a);
+        uint64_t rank_b = handle_helper::unpack_number(b);
+        if (rank_a == rank_b) return;
+        auto rename = [&](handle_t& h){
+            uint64_t rank = handle_helper::unpack_number(h);
+            if (rank == rank_a){
+                h = handle_helper::pack(rank_b, handle_helper::unpack_bit(h));
+            } else if (rank == rank_b){
+                h = handle_helper::pack(rank_a, handle_helper::unpack_bit(h));
+            }
+        };
+        // rename the two nodes wherever their neighbors refer to them
+        std::vector<uint64_t> touched = {rank_a, rank_b};
+        neighbor_ranks(rank_a, touched);
+        neighbor_ranks(rank_b, touched);
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (auto rank : touched){
+            for (bslice_t* slice : {&nodes[rank].left, &nodes[rank].right}){
+                for (uint64_t i = slice->begin; i < slice->begin + slice->size; ++i){
+                    rename(edge_store[i]);
+                }
+            }
+        }
+        std::swap(nodes[rank_a], nodes[rank_b]);
+        std::swap(node_occurrences[rank_a], node_occurrences[rank_b]);
+        for (auto rank : {rank_a, rank_b}){
+            if (nodes[rank].id){
+                id_to_rank.set(nodes[rank].id, rank);
+            }
+            for (auto& occ : node_occurrences[rank]){
+                rename(paths[as_integers(occ)[0]].steps[as_integers(occ)[1]].handle);
+            }
+        }
+    }
+
+    handle_t BGraph::apply_orientation(const handle_t& handle){
+        if (!handle_helper::unpack_bit(handle)) return handle;
+        uint64_t rank = handle_helper::unpack_number(handle);
+        bnode_t& node = nodes[rank];
+        std::string seq = seq_store.substr(node.seq_begin, node.seq_length);
+        reverse_complement_in_place(seq);
+        seq_store.replace(node.seq_begin, node.seq_length, seq);
+        // neighbors now reach the node on its other strand
+        std::vector<uint64_t> touched;
+        neighbor_ranks(rank, touched);
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (auto other : touched){
+            if (other == rank) continue;
+            for (bslice_t* slice : {&nodes[other].left, &nodes[other].right}){
+                for (uint64_t i = slice->begin; i < slice->begin + slice->size; ++i){
+                    if (handle_helper::unpack_number(edge_store[i]) == rank){
+                        edge_store[i] = handle_helper::toggle_bit(edge_store[i]);
+                    }
+                }
+            }
+        }
+        // and the node's own sides trade places, seen from the new strand;
+        // self loops are flipped twice, so they stay as they are
+        std::swap(node.left, node.right);
+        for (bslice_t* slice : {&node.left, &node.right}){
+            for (uint64_t i = slice->begin; i < slice->begin + slice->size; ++i){
+                if (handle_helper::unpack_number(edge_store[i]) != rank){
+                    edge_store[i] = handle_helper::toggle_bit(edge_store[i]);
+                }
+            }
+        }
+        for (auto& occ : node_occurrences[rank]){
+            handle_t& h = paths[as_integers(occ)[0]].steps[as_integers(occ)[1]].handle;
+            h = handle_helper::toggle_bit(h);
+        }
+        return handle_helper::pack(rank, false);
+    }
+
+    std::vector<handle_t> BGraph::divide_handle(const handle_t& handle, const std::vector<size_t>& offsets){
+        uint64_t rank = handle_helper::unpack_number(handle);
+        bool rev = handle_helper::unpack_bit(handle);
+        uint64_t length = nodes[rank].seq_length;
+        // offsets along the forward strand, without empty pieces
+        std::vector<uint64_t> fwd_offsets;
+        for (auto offset : offsets){
+            uint64_t fwd_offset = rev ? length - offset : offset;
+            if (fwd_offset > 0 && fwd_offset < length){
+                fwd_offsets.push_back(fwd_offset);
+            }
+        }
+        std::sort(fwd_offsets.begin(), fwd_offsets.end());
+        fwd_offsets.erase(std::unique(fwd_offsets.begin(), fwd_offsets.end()), fwd_offsets.end());
+        if (fwd_offsets.empty()){
+            return std::vector<handle_t>{handle};
+        }
+        // take the node's edges off, to put them back on the outer pieces
+        handle_t fwd = handle_helper::pack(rank, false);
+        std::vector<edge_t> edges;
+        follow_edges_fast(fwd, false, [&](const handle_t& h){
+                edges.push_back(std::make_pair(fwd, h));
+            });
+        follow_edges_fast(fwd, true, [&](const handle_t& h){
+                edges.push_back(std::make_pair(h, fwd));
+            });
+        for (auto& edge : edges){
+            destroy_edge(edge);
+        }
+        // the node keeps the first piece, and the others are new nodes over
+        // the rest of its bases, so nothing is copied
+        uint64_t seq_begin = nodes[rank].seq_begin;
+        nodes[rank].seq_length = fwd_offsets.front();
+        std::vector<uint64_t> ranks = {rank};
+        for (uint64_t i = 0; i < fwd_offsets.size(); ++i){
+            uint64_t end = (i + 1 < fwd_offsets.size() ? fwd_offsets[i+1] : length);
+            ranks.push_back(append_node(_max_node_id + 1, seq_begin + fwd_offsets[i], end - fwd_offsets[i]));
+        }
+        for (uint64_t i = 0; i + 1 < ranks.size(); ++i){
+            create_edge(handle_helper::pack(ranks[i], false), handle_helper::pack(ranks[i+1], false));
+        }
+        handle_t first = handle_helper::pack(ranks.front(), false);
+        handle_t last = handle_helper::pack(ranks.back(), false);
+        for (auto& edge : edges){
+            handle_t from = edge.first;
+            handle_t to = edge.second;
+            if (handle_helper::unpack_number(from) == rank){
+                from = handle_helper::unpack_bit(from) ? flip(first) : last;
+            }
+            if (handle_helper::unpack_number(to) == rank){
+                to = handle_helper::unpack_bit(to) ? flip(last) : first;
+            }
+            create_edge(from, to);
+        }
+        // replace each occurrence of the node with a walk over its pieces
+        std::vector<occurrence_handle_t> occs;
+        occs.swap(node_occurrences[rank]);
+        for (auto& occ : occs){
+            uint64_t path_id = as_integers(occ)[0];
+            uint64_t slot = as_integers(occ)[1];
+            bool occ_rev = handle_helper::unpack_bit(paths[path_id].steps[slot].handle);
+            uint64_t head = occ_rev ? ranks.back() : ranks.front();
+            paths[path_id].steps[slot].handle = handle_helper::pack(head, occ_rev);
+            node_occurrences[head].push_back(occ);
+            for (uint64_t i = 1; i < ranks.size(); ++i){
+                uint64_t next = occ_rev ? ranks[ranks.size() - 1 - i] : ranks[i];
+                slot = insert_step(path_id, slot, handle_helper::pack(next, occ_rev));
+            }
+        }
+        std::vector<handle_t> parts;
+        for (auto r : ranks){
+            parts.push_back(handle_helper::pack(r, false));
+        }
+        if (rev){
+            std::reverse(parts.begin(), parts.end());
+            for (auto& part : parts){
+                part = flip(part);
+            }
+        }
+        return parts;
+    }
+
+/**
+ * This is the interface for a handle graph with embedded paths where the paths can be modified.
+ */
+
+    uint64_t BGraph::insert_step(uint64_t path_id, uint64_t after, const handle_t& handle){
+        bpath_t& path = paths[path_id];
+        uint64_t slot = path.steps.size();
+        bstep_t step;
+        step.handle = handle;
+        step.prev = after;
+        step.next = (after == bstep_none ? path.first : path.steps[after].next);
+        path.steps.push_back(step);
+        if (step.prev == bstep_none){
+            path.first = slot;
+        } else {
+            path.steps[step.prev].next = slot;
+        }
+        if (step.next == bstep_none){
+            path.last = slot;
+        } else {
+            path.steps[step.next].prev = slot;
+        }
+        ++path.length;
+        node_occurrences[handle_helper::unpack_number(handle)].push_back(make_occurrence(path_id, slot));
+        return slot;
+    }
+
+    void BGraph::destroy_path(const path_handle_t& path){
+        uint64_t path_id = as_integer(path);
+        bpath_t& p = paths[path_id];
+        for (uint64_t slot = p.first; slot != bstep_none; slot = p.steps[slot].next){
+            auto& occs = node_occurrences[handle_helper::unpack_number(p.steps[slot].handle)];
+            for (uint64_t i = 0; i < occs.size(); ++i){
+                if ((uint64_t)as_integers(occs[i])[0] == path_id
+                    && (uint64_t)as_integers(occs[i])[1] == slot){
+                    occs[i] = occs.back();
+                    occs.pop_back();
+                    break;
+                }
+            }
+        }
+        path_ids.erase(p.name);
+        p = bpath_t();
+        p.live = false;
+        --num_paths;
+    }
+
+    path_handle_t BGraph::create_path_handle(const std::string& name){
+        uint64_t path_id = paths.size();
+        paths.emplace_back();
+        paths.back().name = name;
+        path_ids[name] = path_id;
+        ++num_paths;
+        return as_path_handle(path_id);
+    }
+
+    occurrence_handle_t BGraph::append_occurrence(const path_handle_t& path, const handle_t& to_append){
+        uint64_t path_id = as_integer(path);
+        return make_occurrence(path_id, insert_step(path_id, paths[path_id].last, to_append));
+    }
+
+    void BGraph::compact_edges(void){
+        std::vector<handle_t> store;
+        store.reserve(edge_store.size() - dead_edges);
+        for (auto& node : nodes){
+            for (bslice_t* slice : {&node.right, &node.left}){
+                uint64_t begin = store.size();
+                store.insert(store.end(),
+                             edge_store.begin() + slice->begin,
+                             edge_store.begin() + slice->begin + slice->size);
+                slice->begin = begin;
+                slice->capacity = slice->size;
+            }
+        }
+        edge_store.swap(store);
+        dead_edges = 0;
+    }
+
+    void BGraph::compact(void){
+        compact_edges();
+        std::string store;
+        store.reserve(seq_store.size() - dead_bases);
+        for (auto& node : nodes){
+            if (!node.id) continue;
+            uint64_t begin = store.size();
+            store.append(seq_store, node.seq_begin, node.seq_length);
+            node.seq_begin = begin;
+        }
+        seq_store.swap(store);
+        dead_bases = 0;
+    }
+
+    memory_usage_t BGraph::memory_usage(void) const{
+        memory_usage_t usage("BGraph");
+        auto per = [](const memory_usage_t& m, uint64_t n){
+            return n ? (double)m.bytes * 8 / n : 0.0;
+        };
+        memory_usage_t node_usage("nodes");
+        node_usage.add(memory_usage_t("nodes", nodes.capacity() * sizeof(bnode_t)));
+        node_usage.add(memory_usage_t("id_to_rank", id_to_rank.bit_size() / 8));
+        node_usage.rates.push_back(std::make_pair("bits_per_node", per(node_usage, num_nodes)));
+        memory_usage_t edge_usage("edges");
+        edge_usage.add(memory_usage_t("edge_store", edge_store.capacity() * sizeof(handle_t)));
+        edge_usage.rates.push_back(std::make_pair("bits_per_edge", per(edge_usage, num_edges)));
+        memory_usage_t sequence_usage("sequence");
+        sequence_usage.add(memory_usage_t("seq_store", seq_store.capacity()));
+        sequence_usage.rates.push_back(std::make_pair("bits_per_base", per(sequence_usage, seq_store.size() - dead_bases)));
+        memory_usage_t path_usage("paths");
+        uint64_t step_count = 0, step_bytes = 0, occ_bytes = 0;
+        for (auto& path : paths){
+            step_count += path.length;
+            step_bytes += sizeof(bpath_t) + path.steps.capacity() * sizeof(bstep_t) + path.name.capacity();
+        }
+        for (auto& occs : node_occurrences){
+            occ_bytes += sizeof(occs) + occs.capacity() * sizeof(occurrence_handle_t);
+        }
+        path_usage.add(memory_usage_t("paths", step_bytes));
+        path_usage.add(memory_usage_t("node_occurrences", occ_bytes));
+        path_usage.add(memory_usage_t("path_ids", path_ids.size() * sizeof(std::pair<std::string, uint64_t>) + path_ids.bucket_count() / 2));
+        path_usage.rates.push_back(std::make_pair("bits_per_step", per(path_usage, step_count)));
+        usage.add(node_usage);
+        usage.add(edge_usage);
+        usage.add(sequence_usage);
+        usage.add(path_usage);
+        return usage;
+    }
 
-        std::cerr << "Not implemented" << std::endl;
-        exit(1);
-    }
-    
-    /// Get a node handle (node ID and orientation) from a handle to an occurrence on a path
-    // handle_t BGraph::get_occurrence(const occurrence_handle_t& occurrence_handle) const{
-
-    // }
-    
-//     /// Get a handle to the first occurrence in a path.
-//     /// The path MUST be nonempty.
-//     occurrence_handle_t get_first_occurrence(const path_handle_t& path_handle) const;
-    
-//     /// Get a handle to the last occurrence in a path
-//     /// The path MUST be nonempty.
-//     occurrence_handle_t get_last_occurrence(const path_handle_t& path_handle) const;
-    
-//     /// Returns true if the occurrence is not the last occurence on the path, else false
-//     bool has_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-//     /// Returns true if the occurrence is not the first occurence on the path, else false
-//     bool has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-//     /// Returns a handle to the next occurrence on the path
-//     occurrence_handle_t get_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-//     /// Returns a handle to the previous occurrence on the path
-//     occurrence_handle_t get_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-//     /// Returns a handle to the path that an occurrence is on
-//     path_handle_t get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-//     /// Returns the 0-based ordinal rank of a occurrence on a path
-//     size_t get_ordinal_rank_of_occurrence(const occurrence_handle_t& occurrence_handle) const;
-
-//     ////////////////////////////////////////////////////////////////////////////
-//     // Additional optional interface with a default implementation
-//     ////////////////////////////////////////////////////////////////////////////
-
-//     /// Returns true if the given path is empty, and false otherwise
-//     bool is_empty(const path_handle_t& path_handle) const;
-
-//     ////////////////////////////////////////////////////////////////////////////
-//     // Concrete utility methods
-//     ////////////////////////////////////////////////////////////////////////////
-
-//     /// Loop over all the occurrences along a path, from first through last
-//     void for_each_occurrence_in_path(const path_handle_t& path, const std::function<void(const occurrence_handle_t&)>& iteratee) const;
-
-// /**
-//  * This is the interface for a handle graph that supports modification.
-//  */
-//     /*
-//      * Note: All operations may invalidate path handles and occurrence handles.
-//      */
-    
-//     /// Create a new node with the given sequence and return the handle.
-//     handle_t create_handle(const std::string& sequence);
-
-//     /// Create a new node with the given id and sequence, then return the handle.
-//     handle_t create_handle(const std::string& sequence, const dg::id_t& id);
-    
-//     /// Remove the node belonging to the given handle and all of its edges.
-//     /// Does not update any stored paths.
-//     /// Invalidates the destroyed handle.
-//     /// May be called during serial for_each_handle iteration **ONLY** on the node being iterated.
-//     /// May **NOT** be called during parallel for_each_handle iteration.
-//     /// May **NOT** be called on the node from which edges are being followed during follow_edges.
-//     void destroy_handle(const handle_t& handle);
-    
-//     /// Create an edge connecting the given handles in the given order and orientations.
-//     /// Ignores existing edges.
-//     void create_edge(const handle_t& left, const handle_t& right);
-    
-//     /// Convenient wrapper for create_edge.
-//     inline void create_edge(const dg::edge_t& edge) {
-//         create_edge(edge.first, edge.second);
-//     }
-    
-//     /// Remove the edge connecting the given handles in the given order and orientations.
-//     /// Ignores nonexistent edges.
-//     /// Does not update any stored paths.
-//     void destroy_edge(const handle_t& left, const handle_t& right);
-    
-//     /// Convenient wrapper for destroy_edge.
-//     inline void destroy_edge(const edge_t& edge) {
-//         destroy_edge(edge.first, edge.second);
-//     }
-    
-//     /// Remove all nodes and edges. Does not update any stored paths.
-//     void clear(void);
-    
-//     /// Swap the nodes corresponding to the given handles, in the ordering used
-//     /// by for_each_handle when looping over the graph. Other handles to the
-//     /// nodes being swapped must not be invalidated. If a swap is made while
-//     /// for_each_handle is running, it affects the order of the handles
-//     /// traversed during the current traversal (so swapping an already seen
-//     /// handle to a later handle's position will make the seen handle be visited
-//     /// again and the later handle not be visited at all).
-//     void swap_handles(const handle_t& a, const handle_t& b);
-    
-//     /// Alter the node that the given handle corresponds to so the orientation
-//     /// indicated by the handle becomes the node's local forward orientation.
-//     /// Rewrites all edges pointing to the node and the node's sequence to
-//     /// reflect this. Invalidates all handles to the node (including the one
-//     /// passed). Returns a new, valid handle to the node in its new forward
-//     /// orientation. Note that it is possible for the node's ID to change.
-//     /// Does not update any stored paths. May change the ordering of the underlying
-//     /// graph.
-//     handle_t apply_orientation(const handle_t& handle);
-    
-//     /// Split a handle's underlying node at the given offsets in the handle's
-//     /// orientation. Returns all of the handles to the parts. Other handles to
-//     /// the node being split may be invalidated. The split pieces stay in the
-//     /// same local forward orientation as the original node, but the returned
-//     /// handles come in the order and orientation appropriate for the handle
-//     /// passed in.
-//     /// Updates stored paths.
-//     std::vector<handle_t> divide_handle(const handle_t& handle, const std::vector<size_t>& offsets);
-    
-//     /// Specialization of divide_handle for a single division point
-//     inline std::pair<handle_t, handle_t> divide_handle(const handle_t& handle, size_t offset) {
-//         auto parts = divide_handle(handle, std::vector<size_t>{offset});
-//         return std::make_pair(parts.front(), parts.back());
-//     }
-
-// /**
-//  * This is the interface for a handle graph with embedded paths where the paths can be modified.
-//  * Note that if the *graph* can also be modified, the implementation will also
-//  * need to inherit from MutableHandleGraph, via the combination
-//  * MutablePathMutableHandleGraph interface.
-//  * TODO: This is a very limited interface at the moment. It will probably need to be extended.
-//  */
-    
-//     /**
-//      * Destroy the given path. Invalidates handles to the path and its node occurrences.
-//      */
-//     void destroy_path(const path_handle_t& path);
-
-//     /**
-//      * Create a path with the given name. The caller must ensure that no path
-//      * with the given name exists already, or the behavior is undefined.
-//      * Returns a handle to the created empty path. Handles to other paths must
-//      * remain valid.
-//      */
-//     path_handle_t create_path_handle(const std::string& name);
-    
-//     /**
-//      * Append a visit to a node to the given path. Returns a handle to the new
-//      * final occurrence on the path which is appended. Handles to prior
-//      * occurrences on the path, and to other paths, must remain valid.
-//      */
-//     occurrence_handle_t append_occurrence(const path_handle_t& path, const handle_t& to_append);
-
-
-};
\ No newline at end of file
+};
@@ -4,64 +4,96 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include "handle_types.hpp"
-#include "handle_helper.hpp"
+#include "handle.hpp"
+#include "hash_map.hpp"
+#include "id_index.hpp"
+#include "memory_usage.hpp"
 #include "btypes.hpp"
 
+/** \file
+ * bgraph.hpp: an uncompressed graph that trades space for speed.
+ *
+ * Nodes are addressed by rank in a flat array, their sequences are slices of
+ * one concatenated buffer and their neighbors are slices of one shared edge
+ * store, so a traversal touches a few contiguous arrays rather than the
+ * succinct structures behind graph_t. Handles are packed ranks and stay valid
+ * until the node is destroyed.
+ */
+
 namespace betagraph{
     using namespace dg;
-    class BGraph {
-        
+    class BGraph : public MutablePathDeletableHandleGraph {
+
 public:
     BGraph();
     ~BGraph();
-        
+
+    /// Method to check if a node exists by ID
+    bool has_node(id_t node_id) const;
+
     /// Look up the handle for the node with the given ID in the given orientation
-    handle_t get_handle(const dg::id_t& node_id, bool is_reverse = false) const;
-    
+    handle_t get_handle(const id_t& node_id, bool is_reverse = false) const;
+
     /// Get the ID from a handle
-    dg::id_t get_id(const handle_t& handle) const;
-    
+    id_t get_id(const handle_t& handle) const;
+
     /// Get the orientation of a handle
     bool get_is_reverse(const handle_t& handle) const;
-    
+
     /// Invert the orientation of a handle (potentially without getting its ID)
     handle_t flip(const handle_t& handle) const;
-    
+
     /// Get the length of a node
     size_t get_length(const handle_t& handle) const;
-    
+
     /// Get the sequence of a node, presented in the handle's local forward orientation.
     std::string get_sequence(const handle_t& handle) const;
-    
+
     /// Loop over all the handles to next/previous (right/left) nodes. Passes
     /// them to a callback which returns false to stop iterating and true to
     /// continue. Returns true if we finished and false if we stopped early.
     bool follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
-    
+
     /// Loop over all the nodes in the graph in their local forward
     /// orientations, in their internal stored order. Stop if the iteratee
     /// returns false. Can be told to run in parallel, in which case stopping
     /// after a false return value is on a best-effort basis and iteration
     /// order is not defined.
     void for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
-    
+
+    /// Loop over the handles to next/previous (right/left) nodes like
+    /// follow_edges, with the iteratee inlined rather than called through a
+    /// std::function. The iteratee may return bool (false to stop) or void.
+    /// Returns true if we finished and false if we stopped early.
+    template<typename F>
+    bool follow_edges_fast(const handle_t& handle, bool go_left, F&& iteratee) const;
+
+    /// Loop over all the nodes in the graph like for_each_handle, with the
+    /// iteratee inlined. The iteratee may return bool (false to stop) or void.
+    template<typename F>
+    void for_each_handle_fast(F&& iteratee, bool parallel = false) const;
+
+    /// Follow the edges on one side of each of n handles at once. The
+    /// neighbors of in[i] are left in out in the order follow_edges would
+    /// visit them.
+    void follow_edges_batch(const handle_t* in, size_t n, bool go_left, neighbor_batch_t& out) const;
+
     /// Return the number of nodes in the graph
     /// TODO: can't be node_count because XG has a field named node_count.
     size_t node_size(void) const;
-    
+
     /// Return the smallest ID in the graph, or some smaller number if the
     /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
-    dg::id_t min_node_id(void) const;
-    
+    id_t min_node_id(void) const;
+
     /// Return the largest ID in the graph, or some larger number if the
     /// largest ID is unavailable. Return value is unspecified if the graph is empty.
-    dg::id_t max_node_id(void) const;
-    
+    id_t max_node_id(void) const;
+
     ////////////////////////////////////////////////////////////////////////////
     // Interface that needs to be using'd
     ////////////////////////////////////////////////////////////////////////////
-    
+
     /// Loop over all the handles to next/previous (right/left) nodes. Works
     /// with a callback that just takes all the handles and returns void.
     /// Has to be a template because we can't overload on the types of std::function arguments otherwise.
@@ -69,176 +101,91 @@ public:
     template <typename T>
     auto follow_edges(const handle_t& handle, bool go_left, T&& iteratee) const
         -> typename std::enable_if<std::is_void<decltype(iteratee(get_handle(0, false)))>::value>::type {
-        // Implementation only for void-returning iteratees
-        // We ought to just overload on the std::function but that's not allowed until C++14.
-        // See <https://stackoverflow.com/q/13811180>
-        
-        // We also can't use result_of<T(handle_t)>::type to sniff the return
-        // type out because that ::type would not exist (since that's what you
-        // get for a void apparently?) and we couldn't check if it's bool or
-        // void.
-        
-        // So we do this nonsense thing with a trailing return type (to get the
-        // actual arg into scope) and a decltype (which is allowed to resolve to
-        // void) and is_void (which is allowed to take void) and a fake
-        // get_handle call (which is the shortest handle_t-typed expression I
-        // could think of).
-        
-        // Make a wrapper that puts a bool return type on.
-        std::function<bool(const handle_t&)> lambda = [&](const handle_t& found) {
-            iteratee(found);
-            return true;
-        };
-        
-        // Use that
-        follow_edges(handle, go_left, lambda);
-        
-        // During development I managed to get earlier versions of this template to build infinitely recursive functions.
-        static_assert(!std::is_void<decltype(lambda(get_handle(0, false)))>::value, "can't take our own lambda");
+        follow_edges_fast(handle, go_left, iteratee);
     }
-    
+
     /// Loop over all the nodes in the graph in their local forward
     /// orientations, in their internal stored order. Works with void-returning iteratees.
     /// MUST be pulled into implementing classes with `using` in order to work!
     template <typename T>
     auto for_each_handle(T&& iteratee, bool parallel = false) const
     -> typename std::enable_if<std::is_void<decltype(iteratee(get_handle(0, false)))>::value>::type {
-        // Make a wrapper that puts a bool return type on.
-        std::function<bool(const handle_t&)> lambda = [&](const handle_t& found) {
-            iteratee(found);
-            return true;
-        };
-        
-        // Use that
-        for_each_handle(lambda, parallel);
+        for_each_handle_fast(iteratee, parallel);
     }
 
-    void for_each_edge(const std::function<bool(const edge_t&)>& iteratee, bool parallel = false){
-        for_each_handle([&](const handle_t& handle){
-            bool keep_going = true;
-            // filter to edges where this node is lower ID or any rightward self-loops
-            follow_edges(handle, false, [&](const handle_t& next) {
-                if (get_id(handle) <= get_id(next)) {
-                        keep_going = iteratee(edge_handle(handle, next));
-                    }
-                return keep_going;
-            });
-            if (keep_going) {
-                // filter to edges where this node is lower ID or leftward reversing
-                // self-loop
-                follow_edges(handle, true, [&](const handle_t& prev) {
-                    if (get_id(handle) < get_id(prev) ||
-                        (get_id(handle) == get_id(prev) && !get_is_reverse(prev))) {
-                        keep_going = iteratee(edge_handle(prev, handle));
-                    }
-                    return keep_going;
-                });
-            }
-        }, parallel);
-    };
-    
-    /// Get a handle from a Visit Protobuf object.
-    /// Must be using'd to avoid shadowing.
-    //handle_t get_handle(const Visit& visit) const;
-    
     ////////////////////////////////////////////////////////////////////////////
     // Additional optional interface with a default implementation
     ////////////////////////////////////////////////////////////////////////////
-    
+
     /// Get the number of edges on the right (go_left = false) or left (go_left
-    /// = true) side of the given handle. The default implementation is O(n) in
-    /// the number of edges returned, but graph implementations that track this
-    /// information more efficiently can override this method.
+    /// = true) side of the given handle. Constant time, read off the node's
+    /// slice of the edge store.
     size_t get_degree(const handle_t& handle, bool go_left) const;
-    
-    ////////////////////////////////////////////////////////////////////////////
-    // Concrete utility methods
-    ////////////////////////////////////////////////////////////////////////////
-    
-    /// Get a Protobuf Visit from a handle.
-    //Visit to_visit(const handle_t& handle) const;
-    
-    /// Get the locally forward version of a handle
-    handle_t forward(const handle_t& handle) const;
-    
-    /// A pair of handles can be used as an edge. When so used, the handles have a
-    /// canonical order and orientation.
-    edge_t edge_handle(const handle_t& left, const handle_t& right) const;
-    
-    /// Such a pair can be viewed from either inward end handle and produce the
-    /// outward handle you would arrive at.
-    handle_t traverse_edge_handle(const edge_t& edge, const handle_t& left) const;
-    
+
+    /// Return the number of edges in the graph
+    size_t edge_size(void) const;
+
+    /// Check if the edge exists
+    bool has_edge(const handle_t& left, const handle_t& right) const;
+
 /**
  * This is the interface for a handle graph that stores embedded paths.
  */
-    
+
     ////////////////////////////////////////////////////////////////////////////
     // Path handle interface that needs to be implemented
     ////////////////////////////////////////////////////////////////////////////
-    
+
     /// Determine if a path name exists and is legal to get a path handle for.
     bool has_path(const std::string& path_name) const;
-    
+
     /// Look up the path handle for the given path name.
     /// The path with that name must exist.
     path_handle_t get_path_handle(const std::string& path_name) const;
-    
+
     /// Look up the name of a path from a handle to it
     std::string get_path_name(const path_handle_t& path_handle) const;
-    
+
     /// Returns the number of node occurrences in the path
     size_t get_occurrence_count(const path_handle_t& path_handle) const;
 
     /// Returns the number of paths stored in the graph
     size_t get_path_count() const;
-    
+
     /// Execute a function on each path in the graph
     // TODO: allow stopping early?
     void for_each_path_handle(const std::function<void(const path_handle_t&)>& iteratee) const;
-    
+
+    /// Returns a vector of all occurrences of a node on paths. Optionally restricts to
+    /// occurrences that match the handle in orientation.
+    std::vector<occurrence_handle_t> occurrences_of_handle(const handle_t& handle,
+                                                           bool match_orientation = false) const;
+
     /// Get a node handle (node ID and orientation) from a handle to an occurrence on a path
     handle_t get_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
+
     /// Get a handle to the first occurrence in a path.
     /// The path MUST be nonempty.
     occurrence_handle_t get_first_occurrence(const path_handle_t& path_handle) const;
-    
+
     /// Get a handle to the last occurrence in a path
     /// The path MUST be nonempty.
     occurrence_handle_t get_last_occurrence(const path_handle_t& path_handle) const;
-    
+
     /// Returns true if the occurrence is not the last occurence on the path, else false
     bool has_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
+
     /// Returns true if the occurrence is not the first occurence on the path, else false
     bool has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
+
     /// Returns a handle to the next occurrence on the path
     occurrence_handle_t get_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
+
     /// Returns a handle to the previous occurrence on the path
     occurrence_handle_t get_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
+
     /// Returns a handle to the path that an occurrence is on
     path_handle_t get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const;
-    
-    /// Returns the 0-based ordinal rank of a occurrence on a path
-    size_t get_ordinal_rank_of_occurrence(const occurrence_handle_t& occurrence_handle) const;
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Additional optional interface with a default implementation
-    ////////////////////////////////////////////////////////////////////////////
-
-    /// Returns true if the given path is empty, and false otherwise
-    bool is_empty(const path_handle_t& path_handle) const;
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Concrete utility methods
-    ////////////////////////////////////////////////////////////////////////////
-
-    /// Loop over all the occurrences along a path, from first through last
-    void for_each_occurrence_in_path(const path_handle_t& path, const std::function<void(const occurrence_handle_t&)>& iteratee) const;
 
 /**
  * This is the interface for a handle graph that supports modification.
@@ -246,13 +193,13 @@ public:
     /*
      * Note: All operations may invalidate path handles and occurrence handles.
      */
-    
+
     /// Create a new node with the given sequence and return the handle.
     handle_t create_handle(const std::string& sequence);
 
     /// Create a new node with the given id and sequence, then return the handle.
-    handle_t create_handle(const std::string& sequence, const dg::id_t& id);
-    
+    handle_t create_handle(const std::string& sequence, const id_t& id);
+
     /// Remove the node belonging to the given handle and all of its edges.
     /// Does not update any stored paths.
     /// Invalidates the destroyed handle.
@@ -260,29 +207,29 @@ public:
     /// May **NOT** be called during parallel for_each_handle iteration.
     /// May **NOT** be called on the node from which edges are being followed during follow_edges.
     void destroy_handle(const handle_t& handle);
-    
+
     /// Create an edge connecting the given handles in the given order and orientations.
     /// Ignores existing edges.
     void create_edge(const handle_t& left, const handle_t& right);
-    
+
     /// Convenient wrapper for create_edge.
     inline void create_edge(const dg::edge_t& edge) {
         create_edge(edge.first, edge.second);
     }
-    
+
     /// Remove the edge connecting the given handles in the given order and orientations.
     /// Ignores nonexistent edges.
     /// Does not update any stored paths.
     void destroy_edge(const handle_t& left, const handle_t& right);
-    
+
     /// Convenient wrapper for destroy_edge.
     inline void destroy_edge(const edge_t& edge) {
         destroy_edge(edge.first, edge.second);
     }
-    
+
     /// Remove all nodes and edges. Does not update any stored paths.
     void clear(void);
-    
+
     /// Swap the nodes corresponding to the given handles, in the ordering used
     /// by for_each_handle when looping over the graph. Other handles to the
     /// nodes being swapped must not be invalidated. If a swap is made while
@@ -291,17 +238,17 @@ public:
     /// handle to a later handle's position will make the seen handle be visited
     /// again and the later handle not be visited at all).
     void swap_handles(const handle_t& a, const handle_t& b);
-    
+
     /// Alter the node that the given handle corresponds to so the orientation
     /// indicated by the handle becomes the node's local forward orientation.
     /// Rewrites all edges pointing to the node and the node's sequence to
     /// reflect this. Invalidates all handles to the node (including the one
     /// passed). Returns a new, valid handle to the node in its new forward
     /// orientation. Note that it is possible for the node's ID to change.
-    /// Does not update any stored paths. May change the ordering of the underlying
-    /// graph.
+    /// Also flips the node's occurrences on paths. May change the ordering of
+    /// the underlying graph.
     handle_t apply_orientation(const handle_t& handle);
-    
+
     /// Split a handle's underlying node at the given offsets in the handle's
     /// orientation. Returns all of the handles to the parts. Other handles to
     /// the node being split may be invalidated. The split pieces stay in the
@@ -310,7 +257,7 @@ public:
     /// passed in.
     /// Updates stored paths.
     std::vector<handle_t> divide_handle(const handle_t& handle, const std::vector<size_t>& offsets);
-    
+
     /// Specialization of divide_handle for a single division point
     inline std::pair<handle_t, handle_t> divide_handle(const handle_t& handle, size_t offset) {
         auto parts = divide_handle(handle, std::vector<size_t>{offset});
@@ -324,7 +271,7 @@ public:
  * MutablePathMutableHandleGraph interface.
  * TODO: This is a very limited interface at the moment. It will probably need to be extended.
  */
-    
+
     /**
      * Destroy the given path. Invalidates handles to the path and its node occurrences.
      */
@@ -337,7 +284,7 @@ public:
      * remain valid.
      */
     path_handle_t create_path_handle(const std::string& name);
-    
+
     /**
      * Append a visit to a node to the given path. Returns a handle to the new
      * final occurrence on the path which is appended. Handles to prior
@@ -345,29 +292,104 @@ public:
      */
     occurrence_handle_t append_occurrence(const path_handle_t& path, const handle_t& to_append);
 
+    /// Rewrite the edge store in rank order with no slack, and drop the
+    /// sequence of destroyed nodes. Handles stay valid.
+    void compact(void);
+
+    /// Measure the bytes used by each backing structure, grouped like
+    /// graph_t::memory_usage so that the two can be compared.
+    memory_usage_t memory_usage(void) const;
+
 /// These are the backing data structures that we use to fulfill the above functions
 
 private:
-        
-    /// Encodes the topology of the graph.
-    /// {ID, start edge list index, end edge list index, seq index}
-    //SuccinctDynamicVector graph_iv;
-    bgraph_t graph;
-    uint64_t num_edges;
-    uint64_t num_nodes;
 
-    bpathstore_t paths;
+    /// Add a neighbor to one side of a node, growing its slice if needed
+    void slice_append(bslice_t& slice, const handle_t& h);
+
+    /// Remove one copy of a neighbor from a slice, returning whether it was there
+    bool slice_remove(bslice_t& slice, const handle_t& h);
+
+    /// The slice of the node that holds the neighbors of the handle on the given side
+    bslice_t& side_of(const handle_t& handle, bool go_left);
+
+    /// Link a new step into a path after the given slot (or at the front if
+    /// it is bstep_none) and record it on its node
+    uint64_t insert_step(uint64_t path_id, uint64_t after, const handle_t& handle);
 
-    static const handle_helper hhelper;
+    /// Append the rank of every neighbor of the node
+    void neighbor_ranks(uint64_t rank, std::vector<uint64_t>& ranks) const;
 
+    /// Add a node over a stretch of the sequence store and return its rank
+    uint64_t append_node(const id_t& id, uint64_t seq_begin, uint32_t seq_length);
 
-    //size_t dead_bases;
-    //size_t deleted_nodes;
-    //size_t deleted_edges;
+    /// Rewrite the edge store in rank order with no slack
+    void compact_edges(void);
+
+    /// Nodes by rank
+    std::vector<bnode_t> nodes;
+    /// All node sequences, concatenated in forward orientation
+    std::string seq_store;
+    /// All neighbor lists; each node owns a slice on either side
+    std::vector<handle_t> edge_store;
+    /// Node id to rank
+    id_index_t id_to_rank;
+    /// Occurrences of each node's rank on paths
+    std::vector<std::vector<occurrence_handle_t>> node_occurrences;
+    /// Paths by path handle
+    std::vector<bpath_t> paths;
+    string_hash_map<std::string, uint64_t> path_ids;
+
+    uint64_t num_nodes = 0;
+    uint64_t num_edges = 0;
+    uint64_t num_paths = 0;
+    id_t _min_node_id = 0;
+    id_t _max_node_id = 0;
+    /// Slots of the edge store and bases of the sequence store no longer in use
+    uint64_t dead_edges = 0;
+    uint64_t dead_bases = 0;
 };
+
+    template<typename F>
+    bool BGraph::follow_edges_fast(const handle_t& handle, bool go_left, F&& iteratee) const{
+        const bnode_t& node = nodes[handle_helper::unpack_number(handle)];
+        bool rev = handle_helper::unpack_bit(handle);
+        // the lists are kept for the forward orientation, so the reverse
+        // strand reads the opposite side and flips what it finds
+        const bslice_t& slice = (go_left != rev) ? node.left : node.right;
+        uint64_t begin = slice.begin;
+        uint64_t end = begin + slice.size;
+        for (uint64_t i = begin; i < end; ++i){
+            const handle_t& next = edge_store[i];
+            if (!keep_iterating(iteratee, rev ? handle_helper::toggle_bit(next) : next)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename F>
+    void BGraph::for_each_handle_fast(F&& iteratee, bool parallel) const{
+        if (parallel){
+            volatile bool stop = false;
+#pragma omp parallel for schedule(dynamic, 4096)
+            for (uint64_t i = 0; i < nodes.size(); ++i){
+                if (stop || !nodes[i].id) continue;
+                if (!keep_iterating(iteratee, handle_helper::pack(i, false))){
+                    stop = true;
+                }
+            }
+        }
+        else{
+            for (uint64_t i = 0; i < nodes.size(); ++i){
+                if (!nodes[i].id) continue;
+                if (!keep_iterating(iteratee, handle_helper::pack(i, false))) break;
+            }
+        }
+    }
 };
 
 
 
 
-#endif
\ No newline at end of file
+#endif
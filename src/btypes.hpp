@@ -1,95 +1,53 @@
-#ifndef btype_h
+#ifndef btypes_h
 #define btypes_h
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <string>
-#include "spp.h"
+#include "handle.hpp"
 
 namespace betagraph{
 
-    struct bholder_t{
-        bool orientation;
-        uint32_t length;
-        std::vector<dg::edge_t> in_edges;
-        std::vector<dg::edge_t> out_edges;
-        std::string sequence;
-    };
-    struct b_node_t {
-        bool orientation;
-        std::int64_t id;
-        char* seq;
-    };
-    struct b_edge_t{
-        bool forward;
-        std::int64_t id;
-        std::int64_t from_id;
-        std::int64_t to_id;
-    };
-    struct b_path_t{
-        char* name;
-        std::vector<int64_t> ids; 
-    };
-    struct bgraph_t{
-        // spp::sparse_hash_map<int64_t, b_node_t> id_to_node;
-        // spp::sparse_hash_map<int64_t, vector<b_edge_t>> node_to_edges;
-        // spp::sparse_hash_map<char*, b_path_t> name_to_path;
-        spp::sparse_hash_map<dg::id_t, bholder_t> backer;
-        id_t min_node_id = 0;
-        id_t max_node_id = std::numeric_limits<id_t>::max();
-    };
-    struct bpath_occurrence_t{
-        int32_t rank = 0;
-        id_t id;
-    };
-    struct bpath_key_t{
-        dg::id_t id;
-        std::string name;
-        bool operator==(const bpath_key_t &o) const 
-        { return name == o.name && name == o.name; }
+    /// A run of a node's neighbors in the shared edge store. Slots past size
+    /// up to capacity are reserved for the node so that appends stay in place.
+    struct bslice_t{
+        uint64_t begin = 0;
+        uint32_t size = 0;
+        uint32_t capacity = 0;
     };
 
-    struct bpath_val_t{
-        dg::id_t id;
-        std::vector<bpath_occurrence_t> occurrences;
+    /// A node, addressed by its rank. Deleted nodes keep their rank with id 0.
+    struct bnode_t{
+        id_t id = 0;
+        /// where the node's forward sequence starts in the sequence store
+        uint64_t seq_begin = 0;
+        uint32_t seq_length = 0;
+        /// handles reached going right from the node's forward orientation
+        bslice_t right;
+        /// handles reached going left from the node's forward orientation
+        bslice_t left;
     };
 
+    /// Marks the missing neighbor of the first and last step of a path
+    const uint64_t bstep_none = std::numeric_limits<uint64_t>::max();
 
+    /// One step of a path. Steps are linked so that their slots never move
+    /// and occurrence handles stay valid when steps are inserted.
+    struct bstep_t{
+        dg::handle_t handle;
+        uint64_t prev = bstep_none;
+        uint64_t next = bstep_none;
+    };
 
-    struct bpathstore_t{
-        spp::sparse_hash_map<std::string, bpath_val_t> paths;
-        spp::sparse_hash_map<dg::id_t, std::string> id_to_name;
-        bool has_path(const std::string& s) const{
-            return (paths.count(s) != 0);
-        };
-        dg::id_t get_id(std::string s) const{
-            return paths.at(s).id;
-        };
-        std::string get_name(dg::path_handle_t p) const{
-            return id_to_name.at(as_integer(p));
-        };
-        size_t get_path_occurrence_count(dg::path_handle_t p) const{
-            return paths.at(id_to_name.at(as_integer(p))).occurrences.size();
-        };
-
+    struct bpath_t{
+        std::string name;
+        std::vector<bstep_t> steps;
+        uint64_t first = bstep_none;
+        uint64_t last = bstep_none;
+        uint64_t length = 0;
+        bool live = true;
     };
 
 }
 
-    namespace std
-{
-    // inject specialization of std::hash for Person into namespace std
-    // ----------------------------------------------------------------
-    template<> 
-    struct hash<betagraph::bpath_key_t>
-    {
-        std::size_t operator()(betagraph::bpath_key_t const &p) const
-        {
-            std::size_t seed = 0;
-            spp::hash_combine(seed, p.name);
-            spp::hash_combine(seed, p.name);
-            return seed;
-        }
-    };
-};
-
 #endif
@@ -0,0 +1,131 @@
+//
+//  compare.cpp
+//
+
+#include "compare.hpp"
+#include "gfa.hpp"
+#include "segment_names.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace dg {
+
+gfa_records_t read_gfa_records(const std::string& filename) {
+    if (filename == "-") {
+        return read_gfa_records(std::cin);
+    }
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("[dg::read_gfa_records] could not open " + filename);
+    }
+    return read_gfa_records(in);
+}
+
+gfa_records_t read_gfa_records(std::istream& in) {
+    // read through a graph, so segment names need not be numbers
+    graph_t graph;
+    segment_names_t names;
+    read_gfa(in, graph, &names);
+    gfa_records_t gfa;
+    gfa.nodes.reserve(graph.node_size());
+    graph.for_each_handle([&](const handle_t& h) {
+            gfa.nodes.push_back(std::make_pair(graph.get_id(h), graph.get_sequence(h)));
+        });
+    graph.for_each_edge([&](const edge_t& e) {
+            gfa.edges.push_back(std::make_tuple(graph.get_id(e.first), graph.get_is_reverse(e.first),
+                                                graph.get_id(e.second), graph.get_is_reverse(e.second)));
+            return true;
+        });
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+            gfa.paths.emplace_back();
+            gfa.paths.back().first = graph.get_path_name(p);
+            graph.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) {
+                    handle_t h = graph.get_occurrence(occ);
+                    gfa.paths.back().second.push_back(std::make_pair(graph.get_id(h), graph.get_is_reverse(h)));
+                });
+        });
+    return gfa;
+}
+
+void write_compare_table(std::ostream& out, const std::vector<backend_report_t>& reports) {
+    if (reports.empty()) return;
+    std::stringstream ss;
+    ss << std::left << std::setw(20) << "operation"
+       << std::right << std::setw(12) << "ops";
+    for (auto& report : reports) {
+        ss << std::setw(16) << report.backend + " ns/op";
+    }
+    ss << std::endl << std::fixed << std::setprecision(1);
+    // every backend runs the same operations in the same order
+    for (size_t i = 0; i < reports.front().results.size(); ++i) {
+        auto& first = reports.front().results[i];
+        ss << std::left << std::setw(20) << first.name
+           << std::right << std::setw(12) << first.ops;
+        for (auto& report : reports) {
+            if (i < report.results.size()) {
+                ss << std::setw(16) << report.results[i].ns_per_op();
+            } else {
+                ss << std::setw(16) << "-";
+            }
+        }
+        ss << std::endl;
+    }
+    ss << std::endl << std::left << std::setw(32) << "memory (bytes)";
+    for (auto& report : reports) {
+        ss << std::right << std::setw(16) << report.backend;
+    }
+    ss << std::endl;
+    auto row = [&](const std::string& name, const std::function<std::string(const memory_usage_t&)>& value) {
+        ss << std::left << std::setw(32) << name;
+        for (auto& report : reports) {
+            ss << std::right << std::setw(16) << value(report.memory);
+        }
+        ss << std::endl;
+    };
+    row("total", [](const memory_usage_t& m) { return std::to_string(m.bytes); });
+    // the groups, and their rates, are matched up by name
+    for (auto& group : reports.front().memory.children) {
+        auto find_group = [&](const memory_usage_t& m) -> const memory_usage_t* {
+            for (auto& child : m.children) {
+                if (child.name == group.name) return &child;
+            }
+            return nullptr;
+        };
+        row("  " + group.name, [&](const memory_usage_t& m) {
+                auto g = find_group(m);
+                return g ? std::to_string(g->bytes) : std::string("-");
+            });
+        for (auto& rate : group.rates) {
+            row("    " + rate.first, [&](const memory_usage_t& m) {
+                    auto g = find_group(m);
+                    if (g) {
+                        for (auto& r : g->rates) {
+                            if (r.first == rate.first) {
+                                std::stringstream value;
+                                value << std::fixed << std::setprecision(2) << r.second;
+                                return value.str();
+                            }
+                        }
+                    }
+                    return std::string("-");
+                });
+        }
+    }
+    out << ss.str();
+}
+
+void write_compare_json(std::ostream& out, const std::vector<backend_report_t>& reports) {
+    out << "[";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        if (i) out << ",";
+        out << "{\"backend\":\"" << reports[i].backend << "\",\"results\":";
+        write_bench_json(out, reports[i].results);
+        out << ",\"memory\":";
+        reports[i].memory.write_json(out);
+        out << "}";
+    }
+    out << "]";
+}
+
+}
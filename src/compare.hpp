@@ -0,0 +1,293 @@
+#ifndef dgraph_compare_hpp
+#define dgraph_compare_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include "handle.hpp"
+#include "bench.hpp"
+#include "memory_usage.hpp"
+
+/** \file
+ * compare.hpp: the same workload run against each graph backend, so that
+ * `dg compare` can show their time and memory side by side.
+ *
+ * The input GFA is read into plain records once, untimed, and every backend
+ * is built from those records. The workload is a template over the backend
+ * so that each backend's calls can be inlined.
+ */
+
+namespace dg {
+
+/// The contents of a GFA file, held as plain records
+struct gfa_records_t {
+    /// node id and sequence
+    std::vector<std::pair<id_t, std::string>> nodes;
+    /// from id, from reverse, to id, to reverse
+    std::vector<std::tuple<id_t, bool, id_t, bool>> edges;
+    /// path name and its steps as id and reverse
+    std::vector<std::pair<std::string, std::vector<std::pair<id_t, bool>>>> paths;
+};
+
+/// Read the segments, links and paths of a GFA file, or of stdin given "-"
+gfa_records_t read_gfa_records(const std::string& filename);
+
+/// Read the segments, links and paths of a GFA stream. Segments take dense
+/// ids in order of first appearance, so their names need not be numbers.
+gfa_records_t read_gfa_records(std::istream& in);
+
+/// The outcome of running the workload against one backend
+struct backend_report_t {
+    std::string backend;
+    std::vector<bench_result_t> results;
+    memory_usage_t memory;
+};
+
+/// Write the reports as a table with one row per operation and one column
+/// of ns/op per backend, followed by each backend's memory by group
+void write_compare_table(std::ostream& out, const std::vector<backend_report_t>& reports);
+
+/// Write the reports as a JSON array
+void write_compare_json(std::ostream& out, const std::vector<backend_report_t>& reports);
+
+/// Build the nodes and edges (and optionally the paths) of the records into a graph
+template<typename Graph>
+void build_from_records(Graph& graph, const gfa_records_t& gfa, bool with_paths = true) {
+    for (auto& node : gfa.nodes) {
+        graph.create_handle(node.second, node.first);
+    }
+    for (auto& edge : gfa.edges) {
+        graph.create_edge(graph.get_handle(std::get<0>(edge), std::get<1>(edge)),
+                          graph.get_handle(std::get<2>(edge), std::get<3>(edge)));
+    }
+    if (!with_paths) return;
+    for (auto& path : gfa.paths) {
+        path_handle_t p = graph.create_path_handle(path.first);
+        for (auto& step : path.second) {
+            graph.append_occurrence(p, graph.get_handle(step.first, step.second));
+        }
+    }
+}
+
+/// Run the comparison workload against an empty graph of the given backend:
+/// loading, traversal, sequence, path and mutation operations. Queries are
+/// drawn with the params' seed, so every backend sees the same ones.
+template<typename Graph>
+backend_report_t run_backend_workload(const std::string& backend, const gfa_records_t& gfa,
+                                      const bench_params_t& params) {
+    backend_report_t report;
+    report.backend = backend;
+    auto& results = report.results;
+    // results are folded in here so that the calls can't be optimized away
+    volatile uint64_t sink = 0;
+
+    Graph graph;
+    results.push_back(bench_run("load_nodes", gfa.nodes.size(), [&]() {
+                for (auto& node : gfa.nodes) {
+                    graph.create_handle(node.second, node.first);
+                }
+            }));
+    results.push_back(bench_run("load_edges", gfa.edges.size(), [&]() {
+                for (auto& edge : gfa.edges) {
+                    graph.create_edge(graph.get_handle(std::get<0>(edge), std::get<1>(edge)),
+                                      graph.get_handle(std::get<2>(edge), std::get<3>(edge)));
+                }
+            }));
+    uint64_t step_count = 0;
+    for (auto& path : gfa.paths) step_count += path.second.size();
+    results.push_back(bench_run("load_paths", step_count, [&]() {
+                for (auto& path : gfa.paths) {
+                    path_handle_t p = graph.create_path_handle(path.first);
+                    for (auto& step : path.second) {
+                        graph.append_occurrence(p, graph.get_handle(step.first, step.second));
+                    }
+                }
+            }));
+    report.memory = graph.memory_usage();
+    if (gfa.nodes.empty()) return report;
+
+    std::mt19937_64 rng(params.seed);
+    std::uniform_int_distribution<uint64_t> node_dist(0, gfa.nodes.size() - 1);
+    std::bernoulli_distribution strand_dist(0.5);
+    std::vector<std::pair<id_t, bool>> queries(params.query_count);
+    for (auto& query : queries) {
+        query = std::make_pair(gfa.nodes[node_dist(rng)].first, strand_dist(rng));
+    }
+
+    // traversal
+    results.push_back(bench_run("get_handle", queries.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& query : queries) {
+                    sum += as_integer(graph.get_handle(query.first, query.second));
+                }
+                sink += sum;
+            }));
+    std::vector<handle_t> handles;
+    handles.reserve(queries.size());
+    for (auto& query : queries) {
+        handles.push_back(graph.get_handle(query.first, query.second));
+    }
+    results.push_back(bench_run("for_each_handle", graph.node_size(), [&]() {
+                uint64_t sum = 0;
+                // through the virtual interface, as a std::function
+                const HandleGraph& base = graph;
+                base.for_each_handle([&](const handle_t& h) {
+                        sum += as_integer(h);
+                        return true;
+                    });
+                sink += sum;
+            }));
+    results.push_back(bench_run("for_each_handle_fast", graph.node_size(), [&]() {
+                uint64_t sum = 0;
+                graph.for_each_handle_fast([&](const handle_t& h) {
+                        sum += as_integer(h);
+                    });
+                sink += sum;
+            }));
+    results.push_back(bench_run("follow_edges", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                const HandleGraph& base = graph;
+                for (auto& h : handles) {
+                    for (bool go_left : {false, true}) {
+                        base.follow_edges(h, go_left, [&](const handle_t& next) {
+                                sum += as_integer(next);
+                                return true;
+                            });
+                    }
+                }
+                sink += sum;
+            }));
+    results.push_back(bench_run("follow_edges_fast", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    for (bool go_left : {false, true}) {
+                        graph.follow_edges_fast(h, go_left, [&](const handle_t& next) {
+                                sum += as_integer(next);
+                            });
+                    }
+                }
+                sink += sum;
+            }));
+    results.push_back(bench_run("follow_edges_batch", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                neighbor_batch_t batch;
+                // a frontier-sized chunk of the queries at a time
+                const size_t chunk = 4096;
+                for (size_t i = 0; i < handles.size(); i += chunk) {
+                    size_t n = std::min(chunk, handles.size() - i);
+                    for (bool go_left : {false, true}) {
+                        graph.follow_edges_batch(handles.data() + i, n, go_left, batch);
+                        for (auto& next : batch.handles) {
+                            sum += as_integer(next);
+                        }
+                    }
+                }
+                sink += sum;
+            }));
+    results.push_back(bench_run("get_degree", 2 * handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    sum += graph.get_degree(h, false) + graph.get_degree(h, true);
+                }
+                sink += sum;
+            }));
+    results.push_back(bench_run("for_each_edge", gfa.edges.size(), [&]() {
+                uint64_t sum = 0;
+                const HandleGraph& base = graph;
+                base.for_each_edge([&](const edge_t& e) {
+                        sum += as_integer(e.first);
+                        return true;
+                    });
+                sink += sum;
+            }));
+
+    // sequence
+    results.push_back(bench_run("get_length", handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    sum += graph.get_length(h);
+                }
+                sink += sum;
+            }));
+    results.push_back(bench_run("get_sequence", handles.size(), [&]() {
+                uint64_t sum = 0;
+                for (auto& h : handles) {
+                    sum += graph.get_sequence(h).size();
+                }
+                sink += sum;
+            }));
+
+    // paths
+    results.push_back(bench_run("path_walk", step_count, [&]() {
+                uint64_t sum = 0;
+                graph.for_each_path_handle([&](const path_handle_t& p) {
+                        if (graph.get_occurrence_count(p) == 0) return;
+                        occurrence_handle_t occ = graph.get_first_occurrence(p);
+                        while (true) {
+                            sum += as_integer(graph.get_occurrence(occ));
+                            if (!graph.has_next_occurrence(occ)) break;
+                            occ = graph.get_next_occurrence(occ);
+                        }
+                    });
+                sink += sum;
+            }));
+    results.push_back(bench_run("path_sequence", step_count, [&]() {
+                uint64_t sum = 0;
+                graph.for_each_path_handle([&](const path_handle_t& p) {
+                        graph.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) {
+                                sum += graph.get_sequence(graph.get_occurrence(occ)).size();
+                            });
+                    });
+                sink += sum;
+            }));
+
+    // mutation: grow the graph with new nodes hung off the queried handles
+    id_t next_id = graph.max_node_id() + 1;
+    std::vector<handle_t> created;
+    created.reserve(handles.size());
+    results.push_back(bench_run("create_handle", handles.size(), [&]() {
+                for (uint64_t i = 0; i < handles.size(); ++i) {
+                    created.push_back(graph.create_handle("ACGT", next_id + i));
+                }
+            }));
+    results.push_back(bench_run("create_edge", handles.size(), [&]() {
+                for (uint64_t i = 0; i < handles.size(); ++i) {
+                    graph.create_edge(handles[i], created[i]);
+                }
+            }));
+    path_handle_t extra = graph.create_path_handle("compare_extra");
+    results.push_back(bench_run("append_occurrence", created.size(), [&]() {
+                for (auto& h : created) {
+                    graph.append_occurrence(extra, h);
+                }
+            }));
+    if (!params.divide_count) return report;
+    // divide_handle edits the topology, so it gets a graph without paths
+    Graph topology;
+    build_from_records(topology, gfa, false);
+    std::vector<id_t> to_divide;
+    for (auto& query : queries) {
+        if (to_divide.size() >= params.divide_count) break;
+        handle_t h = topology.get_handle(query.first);
+        if (topology.get_length(h) > 1) {
+            to_divide.push_back(query.first);
+        }
+    }
+    std::sort(to_divide.begin(), to_divide.end());
+    to_divide.erase(std::unique(to_divide.begin(), to_divide.end()), to_divide.end());
+    results.push_back(bench_run("divide_handle", to_divide.size(), [&]() {
+                for (auto id : to_divide) {
+                    handle_t h = topology.get_handle(id);
+                    topology.divide_handle(h, topology.get_length(h) / 2);
+                }
+            }));
+    return report;
+}
+
+}
+
+#endif
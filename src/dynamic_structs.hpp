@@ -10,6 +10,8 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <cassert>
+#include <iostream>
 #include "sdsl/bit_vectors.hpp"
 #include "sdsl/enc_vector.hpp"
 #include "sdsl/dac_vector.hpp"
@@ -52,6 +54,15 @@ public:
 
     /// Clears the backing vector
     inline void clear();
+
+    /// Returns the number of bits used by the backing vector
+    inline uint64_t bit_size() const;
+
+    /// Write the vector to a stream, returning the number of bytes written
+    inline uint64_t serialize(std::ostream& out) const;
+
+    /// Replace the contents of the vector with those read from a stream
+    inline void load(std::istream& in);
         
 private:
         
@@ -211,6 +222,23 @@ inline void SuccinctDynamicVector::clear() {
     vec.resize(0);
     filled = 0;
 }
+
+inline uint64_t SuccinctDynamicVector::bit_size() const {
+    return vec.bit_size() + sizeof(filled) * 8;
+}
+
+inline uint64_t SuccinctDynamicVector::serialize(std::ostream& out) const {
+    uint64_t written = 0;
+    out.write((char*)&filled,sizeof(filled));
+    written += sizeof(filled);
+    written += vec.serialize(out);
+    return written;
+}
+
+inline void SuccinctDynamicVector::load(std::istream& in) {
+    in.read((char*)&filled,sizeof(filled));
+    vec.load(in);
+}
     
 inline bool SuccinctSplayTree::empty( ) const {
     return root == 0;
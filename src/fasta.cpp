@@ -0,0 +1,91 @@
+//
+//  fasta.cpp
+//
+
+#include "fasta.hpp"
+#include <algorithm>
+
+namespace dg {
+
+/// A run of steps of one path that is decoded as one task
+struct fasta_chunk_t {
+    uint64_t path;
+    /// the steps of the run in the path's step vector
+    uint64_t step_begin, step_end;
+    /// the offset in the path's sequence where the run starts
+    uint64_t base_offset;
+};
+
+void write_path_fasta(const graph_t& graph, const std::vector<path_handle_t>& paths,
+                      uint64_t line_width, std::ostream& out) {
+    std::vector<std::vector<handle_t>> steps(paths.size());
+    std::vector<std::vector<fasta_chunk_t>> path_chunks(paths.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        auto& path_steps = steps[i];
+        auto& chunks = path_chunks[i];
+        path_steps.reserve(graph.get_occurrence_count(paths[i]));
+        // a path always gets one chunk, which writes its header
+        fasta_chunk_t chunk = {i, 0, 0, 0};
+        uint64_t length = 0;
+        graph.for_each_occurrence_in_path(paths[i], [&](const occurrence_handle_t& occ) {
+                handle_t h = graph.get_occurrence(occ);
+                if (length - chunk.base_offset >= fasta_chunk_bases) {
+                    chunk.step_end = path_steps.size();
+                    chunks.push_back(chunk);
+                    chunk.step_begin = chunk.step_end;
+                    chunk.base_offset = length;
+                }
+                path_steps.push_back(h);
+                length += graph.get_length(h);
+            });
+        chunk.step_end = path_steps.size();
+        chunks.push_back(chunk);
+    }
+    std::vector<fasta_chunk_t> chunks;
+    for (auto& c : path_chunks) {
+        chunks.insert(chunks.end(), c.begin(), c.end());
+    }
+    path_chunks.clear();
+#pragma omp parallel for ordered schedule(dynamic, 1)
+    for (uint64_t k = 0; k < chunks.size(); ++k) {
+        auto& chunk = chunks[k];
+        auto& path_steps = steps[chunk.path];
+        std::string sequence;
+        for (uint64_t j = chunk.step_begin; j < chunk.step_end; ++j) {
+            graph.append_sequence(path_steps[j], sequence);
+        }
+        std::string buffer;
+        if (chunk.step_begin == 0) {
+            buffer.push_back('>');
+            buffer.append(graph.get_path_name(paths[chunk.path]));
+            buffer.push_back('\n');
+        }
+        bool last = chunk.step_end == path_steps.size();
+        if (line_width == 0) {
+            buffer.append(sequence);
+            if (last && path_steps.size()) buffer.push_back('\n');
+        } else {
+            // lines continue across chunks, so they're counted from the start of the path
+            buffer.reserve(buffer.size() + sequence.size() + sequence.size() / line_width + 2);
+            uint64_t column = chunk.base_offset % line_width;
+            for (uint64_t i = 0; i < sequence.size(); ) {
+                uint64_t take = std::min(line_width - column, (uint64_t)sequence.size() - i);
+                buffer.append(sequence, i, take);
+                i += take;
+                column += take;
+                if (column == line_width) {
+                    buffer.push_back('\n');
+                    column = 0;
+                }
+            }
+            // finish the last line, unless it just ended on the width
+            if (last && column != 0) buffer.push_back('\n');
+        }
+#pragma omp ordered
+        out.write(buffer.data(), buffer.size());
+    }
+    out.flush();
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef dgraph_fasta_hpp
+#define dgraph_fasta_hpp
+
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include "graph.hpp"
+
+/** \file
+ * fasta.hpp: FASTA output of the sequences spelled by embedded paths.
+ *
+ * Each path's steps are gathered by one worker, with the paths shared out
+ * among the threads. The steps are then cut into chunks of about
+ * fasta_chunk_bases bases. The chunks are decoded in parallel into their
+ * own buffers and written out in order, so long paths are spread over the
+ * threads too.
+ */
+
+namespace dg {
+
+/// Bases decoded per parallel task
+const uint64_t fasta_chunk_bases = 1 << 20;
+
+/// Write a FASTA record for each of the given paths, in the order given,
+/// with the sequence wrapped at line_width bases, or unwrapped if it's 0
+void write_path_fasta(const graph_t& graph, const std::vector<path_handle_t>& paths,
+                      uint64_t line_width, std::ostream& out);
+
+}
+
+#endif
@@ -0,0 +1,509 @@
+//
+//  gfa.cpp
+//
+
+#include "gfa.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dg {
+
+/// Node ranks formatted per parallel task
+static const uint64_t gfa_chunk_ranks = 1024;
+
+static inline void append_link(std::string& buffer, const graph_t& graph,
+                               const handle_t& from, const handle_t& to) {
+    buffer.append("L\t");
+    append_number(buffer, graph.get_id(from));
+    buffer.append(graph.get_is_reverse(from) ? "\t-\t" : "\t+\t");
+    append_number(buffer, graph.get_id(to));
+    buffer.append(graph.get_is_reverse(to) ? "\t-\t0M\n" : "\t+\t0M\n");
+}
+
+void write_gfa(const graph_t& graph, std::ostream& out) {
+    out << "H\tVN:Z:1.0\n";
+    uint64_t rank_count = graph.node_size();
+    uint64_t chunk_count = (rank_count + gfa_chunk_ranks - 1) / gfa_chunk_ranks;
+    // the chunks are formatted in parallel and written in order as each is done
+#pragma omp parallel for ordered schedule(dynamic, 1)
+    for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+        std::string buffer;
+        uint64_t end = std::min(rank_count, (chunk + 1) * gfa_chunk_ranks);
+        for (uint64_t i = chunk * gfa_chunk_ranks; i < end; ++i) {
+            handle_t h = handle_helper::pack(i, false);
+            id_t id = graph.get_id(h);
+            buffer.append("S\t");
+            append_number(buffer, id);
+            buffer.push_back('\t');
+            buffer.append(graph.get_sequence(h));
+            buffer.push_back('\n');
+            // an edge on the right joining another right side is seen from both ends
+            graph.follow_edges_fast(h, false, [&](const handle_t& next) {
+                    if (!graph.get_is_reverse(next) || id <= graph.get_id(next)) {
+                        append_link(buffer, graph, h, next);
+                    }
+                });
+            // edges from the right of a node onto this left side were written
+            // with that node, leaving the edges that join two left sides
+            graph.follow_edges_fast(h, true, [&](const handle_t& prev) {
+                    if (graph.get_is_reverse(prev) && id <= graph.get_id(prev)) {
+                        append_link(buffer, graph, graph.flip(h), graph.flip(prev));
+                    }
+                });
+        }
+#pragma omp ordered
+        out.write(buffer.data(), buffer.size());
+    }
+    std::vector<path_handle_t> paths;
+    graph.for_each_path_handle([&](const path_handle_t& p) { paths.push_back(p); });
+#pragma omp parallel for ordered schedule(dynamic, 1)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        // the steps and the overlaps are collected in the one walk
+        std::string buffer = "P\t" + graph.get_path_name(paths[i]) + "\t";
+        std::string overlaps;
+        bool first = true;
+        graph.for_each_occurrence_in_path(paths[i], [&](const occurrence_handle_t& occ) {
+                handle_t h = graph.get_occurrence(occ);
+                if (!first) {
+                    buffer.push_back(',');
+                    overlaps.push_back(',');
+                }
+                first = false;
+                append_number(buffer, graph.get_id(h));
+                buffer.push_back(graph.get_is_reverse(h) ? '-' : '+');
+                append_number(overlaps, graph.get_length(h));
+                overlaps.push_back('M');
+            });
+        buffer.push_back('\t');
+        buffer.append(overlaps);
+        buffer.push_back('\n');
+#pragma omp ordered
+        out.write(buffer.data(), buffer.size());
+    }
+    out.flush();
+}
+
+/// Bytes per block handed from the reading stage to the parsing stage
+static const uint64_t gfa_block_bytes = 1 << 20;
+
+/// Blocks or batches that may wait between two stages of the reader
+static const uint64_t gfa_queue_depth = 4;
+
+/// A bounded queue between two threads of the reading pipeline. Closing it
+/// ends the stream for the consumer, once drained, and makes any further
+/// push fail, so either side can stop the other.
+template<typename T>
+class gfa_queue_t {
+public:
+    explicit gfa_queue_t(uint64_t capacity) : capacity(capacity) { }
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&]() { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&]() { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+    void close(void) {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+private:
+    uint64_t capacity;
+    bool closed = false;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+/// A parsed S, L or P line. Sequences, path names and path steps live in
+/// the batch, and records refer to them by offset.
+struct gfa_record_t {
+    char type;
+    /// the segment id of an S line, or the packed from end of an L line
+    uint64_t a;
+    /// the packed to end of an L line
+    uint64_t b;
+    /// the sequence of an S line or the name of a P line in the batch text
+    uint64_t text_begin, text_end;
+    /// the packed steps of a P line in the batch steps
+    uint64_t steps_begin, steps_end;
+};
+
+/// The records parsed from one block, in file order
+struct gfa_batch_t {
+    std::vector<gfa_record_t> records;
+    std::string text;
+    /// path steps, as id << 1 | is_reverse
+    std::vector<uint64_t> steps;
+};
+
+/// Read the stream in blocks, inflating it if it starts with the gzip magic
+static void read_gfa_blocks(std::istream& in, gfa_queue_t<std::string>& blocks) {
+    std::string raw(gfa_block_bytes, '\0');
+    in.read(&raw[0], raw.size());
+    uint64_t got = in.gcount();
+    bool gzipped = got >= 2 && (uint8_t)raw[0] == 0x1f && (uint8_t)raw[1] == 0x8b;
+    if (!gzipped) {
+        while (got) {
+            std::string block(raw, 0, got);
+            if (!blocks.push(std::move(block))) return;
+            in.read(&raw[0], raw.size());
+            got = in.gcount();
+        }
+        return;
+    }
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // gzip only, with the largest window
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw std::runtime_error("[dg::read_gfa] could not set up gzip decompression");
+    }
+    std::string block(gfa_block_bytes, '\0');
+    int status = Z_OK;
+    try {
+        while (got) {
+            stream.next_in = (Bytef*)raw.data();
+            stream.avail_in = got;
+            // inflate until the input is used up and the output has room to spare
+            do {
+                if (status == Z_STREAM_END) {
+                    if (!stream.avail_in) break;
+                    // another gzip member follows
+                    inflateReset(&stream);
+                }
+                stream.next_out = (Bytef*)&block[0];
+                stream.avail_out = block.size();
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                    throw std::runtime_error("[dg::read_gfa] gzip stream is corrupt");
+                }
+                uint64_t length = block.size() - stream.avail_out;
+                if (length) {
+                    std::string full(gfa_block_bytes, '\0');
+                    std::swap(full, block);
+                    full.resize(length);
+                    if (!blocks.push(std::move(full))) {
+                        inflateEnd(&stream);
+                        return;
+                    }
+                }
+            } while (stream.avail_in || stream.avail_out == 0);
+            in.read(&raw[0], raw.size());
+            got = in.gcount();
+        }
+    } catch (...) {
+        inflateEnd(&stream);
+        throw;
+    }
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error("[dg::read_gfa] gzip stream is truncated");
+    }
+}
+
+/// Parse a segment id that runs from begin to end, or translate the name there
+/// if we have a name table
+static uint64_t parse_gfa_id(const char* begin, const char* end, segment_names_t* names) {
+    if (names) {
+        if (begin == end) {
+            throw std::runtime_error("[dg::read_gfa] empty segment name");
+        }
+        return names->intern(begin, end - begin);
+    }
+    uint64_t id = 0;
+    for (const char* c = begin; c < end; ++c) {
+        if (*c < '0' || *c > '9') {
+            id = 0;
+            break;
+        }
+        id = id * 10 + (*c - '0');
+    }
+    if (id == 0 || id > std::numeric_limits<id_t>::max()) {
+        throw std::runtime_error("[dg::read_gfa] segment name " + std::string(begin, end)
+                                 + " is not a positive integer id");
+    }
+    return id;
+}
+
+/// Parse an orientation, giving true for reverse
+static bool parse_gfa_orientation(const char* begin, const char* end) {
+    if (end - begin != 1 || (*begin != '+' && *begin != '-')) {
+        throw std::runtime_error("[dg::read_gfa] bad orientation " + std::string(begin, end));
+    }
+    return *begin == '-';
+}
+
+/// Parse one line into the batch, skipping line types that don't change the graph
+static void parse_gfa_line(const char* line, uint64_t length, segment_names_t* names, gfa_batch_t& batch) {
+    if (length && line[length-1] == '\r') --length;
+    if (length < 2 || line[1] != '\t'
+        || (line[0] != 'S' && line[0] != 'L' && line[0] != 'P')) {
+        return;
+    }
+    // the tab-separated fields we need, each as its begin and end
+    const char* field_begin[6];
+    const char* field_end[6];
+    const char* end = line + length;
+    uint64_t fields = 0;
+    for (const char* c = line; fields < 6; ++fields) {
+        const char* tab = (const char*)std::memchr(c, '\t', end - c);
+        field_begin[fields] = c;
+        field_end[fields] = tab ? tab : end;
+        if (!tab) {
+            ++fields;
+            break;
+        }
+        c = tab + 1;
+    }
+    gfa_record_t record;
+    record.type = line[0];
+    record.a = record.b = 0;
+    record.text_begin = record.text_end = batch.text.size();
+    record.steps_begin = record.steps_end = batch.steps.size();
+    switch (line[0]) {
+    case 'S': {
+        if (fields < 3) {
+            throw std::runtime_error("[dg::read_gfa] S line has too few fields");
+        }
+        record.a = parse_gfa_id(field_begin[1], field_end[1], names);
+        uint64_t seq_length = field_end[2] - field_begin[2];
+        if (seq_length == 0 || (seq_length == 1 && *field_begin[2] == '*')) {
+            throw std::runtime_error("[dg::read_gfa] segment " + std::string(field_begin[1], field_end[1])
+                                     + " has no sequence");
+        }
+        batch.text.append(field_begin[2], seq_length);
+        record.text_end = batch.text.size();
+        break;
+    }
+    case 'L': {
+        if (fields < 5) {
+            throw std::runtime_error("[dg::read_gfa] L line has too few fields");
+        }
+        record.a = parse_gfa_id(field_begin[1], field_end[1], names) << 1
+            | parse_gfa_orientation(field_begin[2], field_end[2]);
+        record.b = parse_gfa_id(field_begin[3], field_end[3], names) << 1
+            | parse_gfa_orientation(field_begin[4], field_end[4]);
+        break;
+    }
+    case 'P': {
+        if (fields < 3) {
+            throw std::runtime_error("[dg::read_gfa] P line has too few fields");
+        }
+        batch.text.append(field_begin[1], field_end[1] - field_begin[1]);
+        record.text_end = batch.text.size();
+        const char* c = field_begin[2];
+        while (c < field_end[2]) {
+            const char* comma = (const char*)std::memchr(c, ',', field_end[2] - c);
+            if (!comma) comma = field_end[2];
+            if (comma - c < 2) {
+                throw std::runtime_error("[dg::read_gfa] empty step in path "
+                                         + std::string(field_begin[1], field_end[1]));
+            }
+            batch.steps.push_back(parse_gfa_id(c, comma - 1, names) << 1
+                                  | parse_gfa_orientation(comma - 1, comma));
+            c = comma + 1;
+        }
+        record.steps_end = batch.steps.size();
+        break;
+    }
+    }
+    batch.records.push_back(record);
+}
+
+/// Split blocks into lines and parse each block's complete lines into a batch
+static void parse_gfa_blocks(gfa_queue_t<std::string>& blocks, gfa_queue_t<gfa_batch_t>& batches,
+                             segment_names_t* names) {
+    // the start of a line that runs on into the next block
+    std::string carry;
+    std::string block;
+    while (blocks.pop(block)) {
+        gfa_batch_t batch;
+        const char* begin = block.data();
+        const char* end = begin + block.size();
+        const char* newline = (const char*)std::memchr(begin, '\n', end - begin);
+        if (carry.size()) {
+            if (!newline) {
+                carry.append(begin, end - begin);
+                continue;
+            }
+            carry.append(begin, newline - begin);
+            parse_gfa_line(carry.data(), carry.size(), names, batch);
+            carry.clear();
+            begin = newline + 1;
+            newline = (const char*)std::memchr(begin, '\n', end - begin);
+        }
+        while (newline) {
+            parse_gfa_line(begin, newline - begin, names, batch);
+            begin = newline + 1;
+            newline = (const char*)std::memchr(begin, '\n', end - begin);
+        }
+        carry.assign(begin, end - begin);
+        if (!batches.push(std::move(batch))) return;
+    }
+    if (carry.size()) {
+        gfa_batch_t batch;
+        parse_gfa_line(carry.data(), carry.size(), names, batch);
+        batches.push(std::move(batch));
+    }
+}
+
+void read_gfa(std::istream& in, MutablePathDeletableHandleGraph& graph, segment_names_t* names, bool progress) {
+    gfa_queue_t<std::string> blocks(gfa_queue_depth);
+    gfa_queue_t<gfa_batch_t> batches(gfa_queue_depth);
+    // the first error in a stage stops the stages around it, and is rethrown here
+    std::exception_ptr read_error, parse_error;
+    std::thread reader([&]() {
+            try {
+                read_gfa_blocks(in, blocks);
+            } catch (...) {
+                read_error = std::current_exception();
+            }
+            blocks.close();
+        });
+    std::thread parser([&]() {
+            try {
+                parse_gfa_blocks(blocks, batches, names);
+            } catch (...) {
+                parse_error = std::current_exception();
+            }
+            blocks.close();
+            batches.close();
+        });
+    // links and paths with segments not yet seen, as packed ends and steps
+    std::vector<std::pair<uint64_t, uint64_t>> deferred_links;
+    std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> deferred_paths;
+    std::vector<uint64_t> deferred_steps;
+    uint64_t node_count = 0, edge_count = 0, step_count = 0;
+    id_t repeated = 0;
+    auto unpack = [&](uint64_t packed) {
+        return graph.get_handle(packed >> 1, packed & 1);
+    };
+    auto add_path = [&](const std::string& name, const uint64_t* begin, const uint64_t* end) {
+        path_handle_t path = graph.has_path(name)
+            ? graph.get_path_handle(name) : graph.create_path_handle(name);
+        for (const uint64_t* step = begin; step < end; ++step) {
+            graph.append_occurrence(path, unpack(*step));
+        }
+        step_count += end - begin;
+    };
+    auto report = [&](void) {
+        std::cerr << "[dg::read_gfa] " << node_count << " nodes, " << edge_count
+                  << " edges, " << step_count << " path steps\r";
+    };
+    try {
+        gfa_batch_t batch;
+        while (batches.pop(batch)) {
+            for (auto& record : batch.records) {
+                switch (record.type) {
+                case 'S':
+                    if (graph.has_node(record.a)) {
+                        // reported once the parser, which may still be naming segments, is done
+                        repeated = record.a;
+                        break;
+                    }
+                    graph.create_handle(batch.text.substr(record.text_begin, record.text_end - record.text_begin),
+                                        record.a);
+                    ++node_count;
+                    break;
+                case 'L':
+                    if (graph.has_node(record.a >> 1) && graph.has_node(record.b >> 1)) {
+                        graph.create_edge(unpack(record.a), unpack(record.b));
+                        ++edge_count;
+                    } else {
+                        deferred_links.push_back(std::make_pair(record.a, record.b));
+                    }
+                    break;
+                case 'P': {
+                    std::string name = batch.text.substr(record.text_begin, record.text_end - record.text_begin);
+                    const uint64_t* begin = batch.steps.data() + record.steps_begin;
+                    const uint64_t* end = batch.steps.data() + record.steps_end;
+                    // once one path waits, the rest wait behind it to keep their order
+                    bool ready = deferred_paths.empty();
+                    for (const uint64_t* step = begin; ready && step < end; ++step) {
+                        ready = graph.has_node(*step >> 1);
+                    }
+                    if (ready) {
+                        add_path(name, begin, end);
+                    } else {
+                        deferred_paths.push_back(std::make_pair(name, std::make_pair(deferred_steps.size(),
+                                                                                     deferred_steps.size() + (end - begin))));
+                        deferred_steps.insert(deferred_steps.end(), begin, end);
+                    }
+                    break;
+                }
+                }
+                if (repeated) break;
+            }
+            if (repeated) {
+                batches.close();
+                blocks.close();
+                break;
+            }
+            if (progress) report();
+        }
+    } catch (...) {
+        batches.close();
+        blocks.close();
+        parser.join();
+        reader.join();
+        throw;
+    }
+    parser.join();
+    reader.join();
+    auto label = [&](id_t id) {
+        return names ? names->get_name(id) : std::to_string(id);
+    };
+    if (repeated) {
+        throw std::runtime_error("[dg::read_gfa] segment " + label(repeated) + " is given twice");
+    }
+    if (read_error) std::rethrow_exception(read_error);
+    if (parse_error) std::rethrow_exception(parse_error);
+    // every segment is in now
+    auto check = [&](uint64_t packed) {
+        if (!graph.has_node(packed >> 1)) {
+            throw std::runtime_error("[dg::read_gfa] segment " + label(packed >> 1)
+                                     + " is used but never given");
+        }
+    };
+    for (auto& link : deferred_links) {
+        check(link.first);
+        check(link.second);
+        graph.create_edge(unpack(link.first), unpack(link.second));
+        ++edge_count;
+    }
+    for (auto& path : deferred_paths) {
+        const uint64_t* begin = deferred_steps.data() + path.second.first;
+        const uint64_t* end = deferred_steps.data() + path.second.second;
+        for (const uint64_t* step = begin; step < end; ++step) {
+            check(*step);
+        }
+        add_path(path.first, begin, end);
+    }
+    if (progress) {
+        report();
+        std::cerr << std::endl;
+    }
+}
+
+}
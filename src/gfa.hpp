@@ -0,0 +1,56 @@
+#ifndef dgraph_gfa_hpp
+#define dgraph_gfa_hpp
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+#include "graph.hpp"
+#include "segment_names.hpp"
+
+/** \file
+ * gfa.hpp: GFA 1.0 input and output for graph_t.
+ *
+ * The writer formats chunks of node ranks, and then whole paths, in
+ * parallel into per-thread buffers. The buffers are written out in order
+ * with one large write each, so the output does not depend on the number
+ * of threads.
+ *
+ * The reader makes a single pass over a stream, which may be gzipped. One
+ * thread reads and decompresses blocks, a second splits them into parsed
+ * records, and the calling thread inserts the records into the graph.
+ * Links and paths that name segments not yet seen are held back in
+ * compact form and added once the stream ends.
+ */
+
+namespace dg {
+
+/// Write the graph as GFA: a header, then each node's S line followed by
+/// the L lines of the edges it owns, in rank order, then a P line per path.
+/// An edge is owned by the node on its right side, or for an edge joining
+/// two left sides or two right sides, by the node with the smaller id.
+void write_gfa(const graph_t& graph, std::ostream& out);
+
+/// Read GFA from a stream into an empty graph, in one pass. A gzip stream
+/// (including a series of gzip members, as bgzip writes) is recognized by
+/// its magic bytes and decompressed on the fly. Without a name table,
+/// segment names must be positive integers, which become the node ids.
+/// With one, every segment name is translated to a dense id in order of
+/// first appearance. Overlaps and tags are ignored. With progress, running
+/// counts are written to stderr.
+void read_gfa(std::istream& in, MutablePathDeletableHandleGraph& graph,
+              segment_names_t* names = nullptr, bool progress = false);
+
+/// Append the decimal digits of a number to a buffer
+inline void append_number(std::string& buffer, uint64_t value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (n) buffer.push_back(digits[--n]);
+}
+
+}
+
+#endif
@@ -3,21 +3,28 @@
 //  
 
 #include "graph.hpp"
+#include "union_find.hpp"
+#include "traverse.hpp"
+#include "gfa.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <tuple>
 
 namespace dg {
 
 /// Method to check if a node exists by ID
 bool graph_t::has_node(id_t node_id) const {
-    return graph_id_map.find(node_id) != graph_id_map.end()
+    return DG_PROFILE_EXPR(PROF_ID_LOOKUP, graph_id_index.has(node_id))
         && !graph_id_hidden_set.count(node_id);
 }
 
 /// Look up the handle for the node with the given ID in the given orientation
 handle_t graph_t::get_handle(const id_t& node_id, bool is_reverse) const {
     //return handle_helper::pack(graph_id_wt.select(0, node_id), is_reverse);
-    auto f = graph_id_map.find(node_id);
-    assert(f != graph_id_map.end());
-    return handle_helper::pack(f->second, is_reverse);
+    assert(graph_id_index.has(node_id));
+    return handle_helper::pack(DG_PROFILE_EXPR(PROF_ID_LOOKUP, graph_id_index.get(node_id)), is_reverse);
 }
     
 /// Get the ID from a handle
@@ -38,53 +45,46 @@ handle_t graph_t::flip(const handle_t& handle) const {
 /// Get the length of a node
 size_t graph_t::get_length(const handle_t& handle) const {
     uint64_t offset = handle_helper::unpack_number(handle);
-    return seq_bv.select1(offset+1) - seq_bv.select1(offset);
+    return DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset+1))
+        - DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset));
 }
     
 /// Get the sequence of a node, presented in the handle's local forward orientation.
 std::string graph_t::get_sequence(const handle_t& handle) const {
     std::string seq;
     uint64_t offset = handle_helper::unpack_number(handle);
-    for (uint64_t i = seq_bv.select1(offset); ; ++i) {
-        if (seq.size() && seq_bv.at(i)) break;
-        seq += int_as_dna(seq_pv.at(i));
+    uint64_t begin = DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset));
+    {
+        DG_PROFILE_SCOPE(PROF_SEQ_DECODE);
+        for (uint64_t i = begin; ; ++i) {
+            if (seq.size() && seq_bv.at(i)) break;
+            seq += int_as_dna(seq_pv.at(i));
+        }
     }
     return (handle_helper::unpack_bit(handle) ? reverse_complement(seq) : seq);
 }
-    
-/// Loop over all the handles to next/previous (right/left) nodes. Passes
-/// them to a callback which returns false to stop iterating and true to
-/// continue. Returns true if we finished and false if we stopped early.
-bool graph_t::follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
-    bool result = true;
+
+void graph_t::append_sequence(const handle_t& handle, std::string& buffer) const {
     uint64_t offset = handle_helper::unpack_number(handle);
-    bool is_rev = handle_helper::unpack_bit(handle);
-    // NB edges are stored in canonical orientation, forward to reverse prefered
-    if (!go_left && !is_rev || go_left && is_rev) {
-        uint64_t edges_begin = edge_fwd_bv.select1(offset)+1;
-        for (uint64_t i = edges_begin; ; ++i) {
-            uint64_t x = edge_fwd_iv.at(i);
-            if (x==0) break; // end of record
-            uint64_t id = edge_delta_to_id(get_id(handle), x);
-            bool inv = edge_fwd_inv_bv.at(i);
-            handle_t handle = get_handle(id, (inv ? !is_rev : is_rev));
-            result &= iteratee(handle);
-            if (!result) break;
+    uint64_t begin = DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset));
+    uint64_t end = DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset+1));
+    DG_PROFILE_SCOPE(PROF_SEQ_DECODE);
+    if (handle_helper::unpack_bit(handle)) {
+        for (uint64_t i = end; i > begin; --i) {
+            buffer.push_back(reverse_complement(int_as_dna(seq_pv.at(i-1))));
         }
     } else {
-        assert(go_left && !is_rev || !go_left && is_rev);
-        uint64_t edges_begin = edge_rev_bv.select1(offset)+1;
-        for (uint64_t i = edges_begin; ; ++i) {
-            uint64_t x = edge_rev_iv.at(i);
-            if (x==0) break; // end of record
-            uint64_t id = edge_delta_to_id(get_id(handle), x);
-            bool inv = edge_rev_inv_bv.at(i);
-            handle_t handle = get_handle(id, (inv ? !is_rev : is_rev));
-            result &= iteratee(handle);
-            if (!result) break;
+        for (uint64_t i = begin; i < end; ++i) {
+            buffer.push_back(int_as_dna(seq_pv.at(i)));
         }
     }
-    return result;
+}
+    
+/// Loop over all the handles to next/previous (right/left) nodes. Passes
+/// them to a callback which returns false to stop iterating and true to
+/// continue. Returns true if we finished and false if we stopped early.
+bool graph_t::follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    return follow_edges_fast(handle, go_left, iteratee);
 }
     
 /// Loop over all the nodes in the graph in their local forward
@@ -93,27 +93,82 @@ bool graph_t::follow_edges(const handle_t& handle, bool go_left, const std::func
 /// after a false return value is on a best-effort basis and iteration
 /// order is not defined.
 void graph_t::for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
-    if (parallel) {
-        volatile bool flag=false;
-#pragma omp parallel for
-        for (uint64_t i = 0; i < graph_id_pv.size(); ++i) {
-            if (flag) continue;
-            bool result = iteratee(handle_helper::pack(i,false));
-#pragma omp atomic
-            flag &= result;
+    for_each_handle_fast(iteratee, parallel);
+}
+
+void graph_t::follow_edges_batch(const handle_t* in, size_t n, bool go_left, neighbor_batch_t& out) const {
+    // order the queries by the edge list they read and then by rank, so that
+    // each record is found by scanning on from the previous one when it is close
+    std::vector<std::pair<uint64_t, uint64_t>> order(n);
+    const uint64_t rev_list = 1ULL << 63;
+    for (uint64_t i = 0; i < n; ++i) {
+        bool is_rev = handle_helper::unpack_bit(in[i]);
+        bool fwd = !go_left && !is_rev || go_left && is_rev;
+        order[i] = std::make_pair((fwd ? 0 : rev_list) | handle_helper::unpack_number(in[i]), i);
+    }
+    std::sort(order.begin(), order.end());
+    // past this many records it is cheaper to select than to scan
+    const uint64_t max_scan = 8;
+    std::vector<uint64_t> found_begin(n);
+    std::vector<handle_t> found;
+    found.reserve(2 * n);
+    uint64_t last_key = 0;
+    uint64_t last_pos = 0;
+    bool have_last = false;
+    for (auto& query : order) {
+        bool fwd = !(query.first & rev_list);
+        uint64_t rank = query.first & ~rev_list;
+        const lciv_iv& edge_iv = fwd ? edge_fwd_iv : edge_rev_iv;
+        const suc_bv& edge_inv_bv = fwd ? edge_fwd_inv_bv : edge_rev_inv_bv;
+        // the position of this record's delimiter
+        uint64_t pos;
+        if (have_last && (last_key & rev_list) == (query.first & rev_list)
+            && query.first - last_key <= max_scan) {
+            pos = last_pos;
+            for (uint64_t skip = query.first - last_key; skip > 0; --skip) {
+                while (edge_iv.at(++pos) != 0) {}
+            }
+        } else {
+            pos = DG_PROFILE_EXPR(PROF_EDGE_SELECT, (fwd ? edge_fwd_bv : edge_rev_bv).select1(rank));
         }
-    } else {
-        for (uint64_t i = 0; i < graph_id_pv.size(); ++i) {
-            if (!iteratee(handle_helper::pack(i,false))) break;
+        last_key = query.first;
+        last_pos = pos;
+        have_last = true;
+        bool is_rev = handle_helper::unpack_bit(in[query.second]);
+        uint64_t base = graph_id_pv.at(rank);
+        found_begin[query.second] = found.size();
+        for (uint64_t i = pos + 1; ; ++i) {
+            uint64_t x = edge_iv.at(i);
+            if (x==0) break; // end of record
+            // stored values are zigzag deltas: 1 for the same id, 2d for +d, 2d+1 for -d
+            id_t id = edge_delta_to_id(base, x);
+            uint64_t next = DG_PROFILE_EXPR(PROF_ID_LOOKUP, graph_id_index.get(id));
+            bool inv = edge_inv_bv.at(i);
+            found.push_back(handle_helper::pack(next, inv ? !is_rev : is_rev));
         }
     }
+    // lay the neighbors out again in the order of the queries
+    std::vector<uint64_t> found_end(n);
+    for (uint64_t k = 0; k < n; ++k) {
+        found_end[order[k].second] = k + 1 < n ? found_begin[order[k+1].second] : found.size();
+    }
+    out.offsets.resize(n + 1);
+    out.offsets[0] = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        out.offsets[i+1] = out.offsets[i] + found_end[i] - found_begin[i];
+    }
+    out.handles.resize(found.size());
+    for (uint64_t i = 0; i < n; ++i) {
+        std::copy(found.begin() + found_begin[i], found.begin() + found_end[i],
+                  out.handles.begin() + out.offsets[i]);
+    }
 }
 
 void graph_t::for_each_edge(const std::function<bool(const edge_t&)>& iteratee, bool parallel){
-    for_each_handle([&](const handle_t& handle){
+    for_each_handle_fast([&](const handle_t& handle){
             bool keep_going = true;
             // filter to edges where this node is lower ID or any rightward self-loops
-            follow_edges(handle, false, [&](const handle_t& next) {
+            follow_edges_fast(handle, false, [&](const handle_t& next) {
                     if (get_id(handle) <= get_id(next)) {
                         keep_going = iteratee(edge_handle(handle, next));
                     }
@@ -122,9 +177,9 @@ void graph_t::for_each_edge(const std::function<bool(const edge_t&)>& iteratee,
             if (keep_going) {
                 // filter to edges where this node is lower ID or leftward reversing
                 // self-loop
-                follow_edges(handle, true, [&](const handle_t& prev) {
+                follow_edges_fast(handle, true, [&](const handle_t& prev) {
                         if (get_id(handle) < get_id(prev) ||
-                            (get_id(handle) == get_id(prev) && !get_is_reverse(prev))) {
+                            (get_id(handle) == get_id(prev) && get_is_reverse(prev))) {
                             keep_going = iteratee(edge_handle(prev, handle));
                         }
                         return keep_going;
@@ -162,10 +217,13 @@ id_t graph_t::max_node_id(void) const {
 size_t graph_t::get_degree(const handle_t& handle, bool go_left) const {
     uint64_t offset = handle_helper::unpack_number(handle);
     bool is_rev = handle_helper::unpack_bit(handle);
+    // the record runs from its delimiter up to the next one
     if (!go_left && !is_rev || go_left && is_rev) {
-        return edge_fwd_bv.select1(offset+1) - edge_fwd_bv.select1(offset);
+        return DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(offset+1))
+            - DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(offset)) - 1;
     } else {
-        return edge_rev_bv.select1(offset+1) - edge_rev_bv.select1(offset);
+        return DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(offset+1))
+            - DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(offset)) - 1;
     }
 }
     
@@ -206,7 +264,7 @@ handle_t graph_t::traverse_edge_handle(const edge_t& edge, const handle_t& left)
     
 /// Determine if a path name exists and is legal to get a path handle for.
 bool graph_t::has_path(const std::string& path_name) const {
-    auto f = path_name_map.find(path_name);
+    auto f = DG_PROFILE_EXPR(PROF_PATH_MAP_LOOKUP, path_name_map.find(path_name));
     if (f == path_name_map.end()) return false;
     else return true;
 }
@@ -214,21 +272,21 @@ bool graph_t::has_path(const std::string& path_name) const {
 /// Look up the path handle for the given path name.
 /// The path with that name must exist.
 path_handle_t graph_t::get_path_handle(const std::string& path_name) const {
-    auto f = path_name_map.find(path_name);
+    auto f = DG_PROFILE_EXPR(PROF_PATH_MAP_LOOKUP, path_name_map.find(path_name));
     assert(f != path_name_map.end());
     return as_path_handle(f->second);
 }
 
 /// Look up the name of a path from a handle to it
 std::string graph_t::get_path_name(const path_handle_t& path_handle) const {
-    auto f = path_metadata_map.find(as_integer(path_handle));
+    auto f = DG_PROFILE_EXPR(PROF_PATH_MAP_LOOKUP, path_metadata_map.find(as_integer(path_handle)));
     assert(f != path_metadata_map.end());
     return f->second.name;
 }
     
 /// Returns the number of node occurrences in the path
 size_t graph_t::get_occurrence_count(const path_handle_t& path_handle) const {
-    auto f = path_metadata_map.find(as_integer(path_handle));
+    auto f = DG_PROFILE_EXPR(PROF_PATH_MAP_LOOKUP, path_metadata_map.find(as_integer(path_handle)));
     if (f == path_metadata_map.end()) return 0;
     else return f->second.length;
 }
@@ -251,9 +309,8 @@ void graph_t::for_each_path_handle(const std::function<void(const path_handle_t&
 
 void graph_t::for_each_occurrence_on_handle(const handle_t& handle, const std::function<void(const occurrence_handle_t&)>& iteratee) const {
     uint64_t handle_rank = handle_helper::unpack_number(handle);
-    uint64_t begin = path_handle_wt.select(handle_rank, 0);
-    uint64_t end = path_handle_wt.select(handle_rank+1, 0);
-    hash_map<uint64_t, uint64_t> path_count;
+    uint64_t begin = DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(handle_rank, 0))+1;
+    uint64_t end = DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(handle_rank+1, 0));
     for (uint64_t i = 0; i < end-begin; ++i) {
         occurrence_handle_t occ;
         as_integers(occ)[0] = handle_rank;
@@ -269,7 +326,7 @@ std::vector<occurrence_handle_t> graph_t::occurrences_of_handle(const handle_t&
     std::vector<occurrence_handle_t> res;
     for_each_occurrence_on_handle(handle, [&](const occurrence_handle_t& occ) {
             handle_t h = get_occurrence(occ);
-            if (!match_orientation || handle_helper::unpack_bit(h) == handle_helper::unpack_bit(h)) {
+            if (!match_orientation || handle_helper::unpack_bit(h) == handle_helper::unpack_bit(handle)) {
                 res.push_back(occ);
             }
         });
@@ -278,15 +335,15 @@ std::vector<occurrence_handle_t> graph_t::occurrences_of_handle(const handle_t&
 
 size_t graph_t::get_occurrence_count(const handle_t& handle) const {
     uint64_t handle_rank = handle_helper::unpack_number(handle);
-    uint64_t begin = path_handle_wt.select(handle_rank, 0)+1;
-    uint64_t end = path_handle_wt.select(handle_rank+1, 0);
+    uint64_t begin = DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(handle_rank, 0))+1;
+    uint64_t end = DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(handle_rank+1, 0));
     return end - begin;
 }
 
 uint64_t graph_t::occurrence_rank(const occurrence_handle_t& occurrence_handle) const {
     uint64_t i = as_integers(occurrence_handle)[0];
     uint64_t j = as_integers(occurrence_handle)[1];
-    return path_handle_wt.select(i, 0)+1 + j;
+    return DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(i, 0))+1 + j;
 }
 
 /// Get a node handle (node ID and orientation) from a handle to an occurrence on a path
@@ -319,7 +376,7 @@ bool graph_t::has_next_occurrence(const occurrence_handle_t& occurrence_handle)
     
 /// Returns true if the occurrence is not the first occurence on the path, else false
 bool graph_t::has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const {
-    return path_next_id_iv.at(occurrence_rank(occurrence_handle)) != path_begin_marker;
+    return path_prev_id_iv.at(occurrence_rank(occurrence_handle)) != path_begin_marker;
 }
 
 /// Returns a handle to the next occurrence on the path, which must exist
@@ -345,7 +402,7 @@ occurrence_handle_t graph_t::get_previous_occurrence(const occurrence_handle_t&
 }
 
 path_handle_t graph_t::get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const {
-    return as_path_handle(path_handle_wt.at(occurrence_rank(occurrence_handle)));
+    return get_path(occurrence_handle);
 }
     
 ////////////////////////////////////////////////////////////////////////////
@@ -395,39 +452,48 @@ handle_t graph_t::create_hidden_handle(const std::string& sequence) {
 
 /// Create a new node with the given id and sequence, then return the handle.
 handle_t graph_t::create_handle(const std::string& sequence, const id_t& id) {
-    assert(!graph_id_map.find(id) != graph_id_map.end());
+    assert(!graph_id_index.has(id));
     assert(id > 0);
     id_t new_id = id;
     // set new max
     _max_node_id = max(new_id, _max_node_id);
     _min_node_id = max((uint64_t)1, (uint64_t)min(new_id, _min_node_id));
-    graph_id_map[new_id] = graph_id_pv.size();
+    graph_id_index.set(new_id, graph_id_pv.size());
     // add to graph_id_pv
     uint64_t handle_rank = graph_id_pv.size();
     graph_id_pv.push_back(new_id);
-    // append to seq_wt, delimit by 0
-    for (auto c : sequence) {
-        seq_pv.push_back(dna_as_int(c));
-    }
-    // update seq_bv
-    for (uint64_t i = 0; i < sequence.size()-1; ++i) {
+    {
+        DG_PROFILE_SCOPE(PROF_SEQ_INSERT);
+        // append to seq_wt, delimit by 0
+        for (auto c : sequence) {
+            seq_pv.push_back(dna_as_int(c));
+        }
+        // update seq_bv
+        for (uint64_t i = 0; i < sequence.size()-1; ++i) {
             seq_bv.push_back(0);
+        }
+        seq_bv.push_back(1); // end delimiter
+    }
+    {
+        DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+        // set up delemiters for edges, for later filling
+        edge_fwd_iv.push_back(0);
+        edge_fwd_bv.push_back(1);
+        edge_fwd_inv_bv.push_back(0);
+        edge_rev_iv.push_back(0);
+        edge_rev_bv.push_back(1);
+        edge_rev_inv_bv.push_back(0);
+    }
+    {
+        DG_PROFILE_SCOPE(PROF_PATH_INSERT);
+        // set up path handle mapping
+        path_handle_wt.push_back(0);
+        path_rev_iv.push_back(0);
+        path_next_id_iv.push_back(0);
+        path_next_rank_iv.push_back(0);
+        path_prev_id_iv.push_back(0);
+        path_prev_rank_iv.push_back(0);
     }
-    seq_bv.push_back(1); // end delimiter
-    // set up delemiters for edges, for later filling
-    edge_fwd_iv.push_back(0);
-    edge_fwd_bv.push_back(1);
-    edge_fwd_inv_bv.push_back(0);
-    edge_rev_iv.push_back(0);
-    edge_rev_bv.push_back(1);
-    edge_rev_inv_bv.push_back(0);
-    // set up path handle mapping
-    path_handle_wt.push_back(0);
-    path_rev_iv.push_back(0);
-    path_next_id_iv.push_back(0);
-    path_next_rank_iv.push_back(0);
-    path_prev_id_iv.push_back(0);
-    path_prev_rank_iv.push_back(0);
     // increment node count
     ++_node_count;
     // return handle
@@ -444,24 +510,33 @@ void graph_t::destroy_handle(const handle_t& handle) {
     uint64_t offset = handle_helper::unpack_number(handle);
     id_t id = graph_id_pv.at(offset);
     // remove occs in edge lists
-    // enumerate the edges
+    // enumerate the edges, each once, as a self edge is seen from both ends
     std::vector<edge_t> edges_to_destroy;
-    follow_edges(handle, false, [&edges_to_destroy,&handle,this](const handle_t& h) {
-            edges_to_destroy.push_back(make_pair(handle, h)); });
-    follow_edges(handle, true, [&edges_to_destroy,&handle,this](const handle_t& h) {
-            edges_to_destroy.push_back(make_pair(h, handle)); });
+    std::set<std::pair<uint64_t, uint64_t>> seen_edges;
+    auto add_edge = [&](const handle_t& left, const handle_t& right) {
+        edge_t e = edge_handle(left, right);
+        if (seen_edges.insert(std::make_pair(as_integer(e.first), as_integer(e.second))).second) {
+            edges_to_destroy.push_back(e);
+        }
+    };
+    follow_edges_fast(handle, false, [&](const handle_t& h) { add_edge(handle, h); });
+    follow_edges_fast(handle, true, [&](const handle_t& h) { add_edge(h, handle); });
     // and then remove them
     for (auto& edge : edges_to_destroy) {
         destroy_edge(edge);
     }
     // save the node sequence for stashing in the paths
     std::string seq = get_sequence(handle);
-    // remove the sequence from seq_pv
-    uint64_t seq_pv_offset = seq_bv.select1(offset);
+    // remove the sequence from seq_pv, and its bits from seq_bv, which has a
+    // leading delimiter
+    uint64_t seq_pv_offset = DG_PROFILE_EXPR(PROF_SEQ_SELECT, seq_bv.select1(offset));
     uint64_t length = get_length(handle);
-    for (uint64_t i = seq_pv_offset; i < seq_pv_offset+length; ++i) {
-        seq_pv.remove(i);
-        seq_bv.remove(i);
+    {
+        DG_PROFILE_SCOPE(PROF_SEQ_REMOVE);
+        for (uint64_t i = 0; i < length; ++i) {
+            seq_pv.remove(seq_pv_offset);
+            seq_bv.remove(seq_pv_offset+1);
+        }
     }
     // move the sequence of the node into each path that traverses it
     std::vector<occurrence_handle_t> occs;
@@ -471,28 +546,46 @@ void graph_t::destroy_handle(const handle_t& handle) {
         });
     if (occs.size()) {
         handle_t hidden = create_hidden_handle(seq);
-        for (auto& occ : occs) {
-            handle_t h = get_occurrence(occ);
+        // replacing an occurrence shifts the ones after it down to the same rank
+        for (uint64_t i = 0; i < occs.size(); ++i) {
+            handle_t h = get_occurrence(occs.front());
             if (handle_helper::unpack_bit(h)) {
-                set_occurrence(occ, handle_helper::toggle_bit(hidden));
+                set_occurrence(occs.front(), handle_helper::toggle_bit(hidden));
             } else {
-                set_occurrence(occ, hidden);
+                set_occurrence(occs.front(), hidden);
             }
         }
     }
-    // remove from path handle mapping
-    do {
-        path_handle_wt.remove(offset);
-        path_rev_iv.remove(offset);
-        path_next_id_iv.remove(offset);
-        path_next_rank_iv.remove(offset);
-        path_prev_id_iv.remove(offset);
-        path_prev_rank_iv.remove(offset);
-    } while (path_handle_wt.at(offset) != 0);
+    {
+        // the node's edge and path records are now empty, so only their
+        // delimiters are left to remove
+        DG_PROFILE_SCOPE(PROF_EDGE_REMOVE);
+        uint64_t fwd_offset = edge_fwd_bv.select1(offset);
+        edge_fwd_iv.remove(fwd_offset);
+        edge_fwd_bv.remove(fwd_offset);
+        edge_fwd_inv_bv.remove(fwd_offset);
+        uint64_t rev_offset = edge_rev_bv.select1(offset);
+        edge_rev_iv.remove(rev_offset);
+        edge_rev_bv.remove(rev_offset);
+        edge_rev_inv_bv.remove(rev_offset);
+    }
+    {
+        DG_PROFILE_SCOPE(PROF_PATH_REMOVE);
+        destroy_path_handle_records(DG_PROFILE_EXPR(PROF_PATH_SELECT, path_handle_wt.select(offset, 0)));
+    }
     // remove from graph_id_pv
     graph_id_pv.remove(offset);
     // from the id to handle map
-    graph_id_map.erase(id);
+    graph_id_index.erase(id);
+    // the nodes after this one each move down a rank
+    for (uint64_t i = offset; i < graph_id_pv.size(); ++i) {
+        graph_id_index.set(graph_id_pv.at(i), i);
+    }
+    for (auto& p : path_metadata_map) {
+        for (auto occ : { &p.second.first, &p.second.last }) {
+            if (as_integers(*occ)[0] > offset) --as_integers(*occ)[0];
+        }
+    }
     // and from the set of hidden nodes, if it's a member
     if (graph_id_hidden_set.count(id)) {
         graph_id_hidden_set.erase(id);
@@ -501,6 +594,29 @@ void graph_t::destroy_handle(const handle_t& handle) {
     --_node_count;
 }
     
+handle_t graph_t::append_handle(const std::string& sequence, id_t id,
+                                const std::vector<std::pair<id_t, bool>>& right,
+                                const std::vector<std::pair<id_t, bool>>& left) {
+    {
+        DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+        // the record of the new rank runs up to the delimiter create_handle adds
+        for (auto& e : right) {
+            edge_fwd_iv.push_back(id_to_delta(id, e.first));
+            edge_fwd_bv.push_back(0);
+            edge_fwd_inv_bv.push_back(e.second);
+            // an edge is counted at its later end, and a self edge on the right
+            if (e.first <= id) ++_edge_count;
+        }
+        for (auto& e : left) {
+            edge_rev_iv.push_back(id_to_delta(id, e.first));
+            edge_rev_bv.push_back(0);
+            edge_rev_inv_bv.push_back(e.second);
+            if (e.first < id || (e.first == id && e.second)) ++_edge_count;
+        }
+    }
+    return create_handle(sequence, id);
+}
+
 /// Create an edge connecting the given handles in the given order and orientations.
 /// Ignores existing edges.
 void graph_t::create_edge(const handle_t& left, const handle_t& right) {
@@ -525,53 +641,60 @@ void graph_t::create_edge(const handle_t& left, const handle_t& right) {
     uint64_t left_relative = edge_to_delta(left_h, right_h);
     if (!left_rev) {
         //std::cerr << "not left rev" << std::endl;
-        uint64_t edge_fwd_left_offset = edge_fwd_bv.select1(left_rank+1);
+        uint64_t edge_fwd_left_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(left_rank+1));
         //std::cerr << "edge fwd " << edge_fwd_left_offset << std::endl;
-        edge_fwd_iv.insert(edge_fwd_left_offset, left_relative);
-        edge_fwd_bv.insert(edge_fwd_left_offset, 0);
-        edge_fwd_inv_bv.insert(edge_fwd_left_offset, inv);
+        {
+            DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+            edge_fwd_iv.insert(edge_fwd_left_offset, left_relative);
+            edge_fwd_bv.insert(edge_fwd_left_offset, 0);
+            edge_fwd_inv_bv.insert(edge_fwd_left_offset, inv);
+        }
     } else {
         //std::cerr << "left rev" << std::endl;
-        uint64_t edge_rev_left_offset = edge_rev_bv.select1(left_rank+1);
-        edge_rev_iv.insert(edge_rev_left_offset, left_relative);
-        edge_rev_bv.insert(edge_rev_left_offset, 0);
-        edge_rev_inv_bv.insert(edge_rev_left_offset, inv);
+        uint64_t edge_rev_left_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(left_rank+1));
+        {
+            DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+            edge_rev_iv.insert(edge_rev_left_offset, left_relative);
+            edge_rev_bv.insert(edge_rev_left_offset, 0);
+            edge_rev_inv_bv.insert(edge_rev_left_offset, inv);
+        }
     }
-    if (!right_rev) {
+    if (left_rank == right_rank && inv) {
+        // a reversing self edge joins one side to itself, so it has only the one entry
+    } else if (!right_rev) {
         //std::cerr << "not right rev" << std::endl;
-        uint64_t edge_rev_right_offset = edge_rev_bv.select1(right_rank+1);
-        edge_rev_iv.insert(edge_rev_right_offset, right_relative);
-        edge_rev_bv.insert(edge_rev_right_offset, 0);
-        edge_rev_inv_bv.insert(edge_rev_right_offset, inv);
+        uint64_t edge_rev_right_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(right_rank+1));
+        {
+            DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+            edge_rev_iv.insert(edge_rev_right_offset, right_relative);
+            edge_rev_bv.insert(edge_rev_right_offset, 0);
+            edge_rev_inv_bv.insert(edge_rev_right_offset, inv);
+        }
     } else {
         //std::cerr << "right rev" << std::endl;
-        uint64_t edge_fwd_right_offset = edge_fwd_bv.select1(right_rank+1);
-        edge_fwd_iv.insert(edge_fwd_right_offset, right_relative);
-        edge_fwd_bv.insert(edge_fwd_right_offset, 0);
-        edge_fwd_inv_bv.insert(edge_fwd_right_offset, inv);
+        uint64_t edge_fwd_right_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(right_rank+1));
+        {
+            DG_PROFILE_SCOPE(PROF_EDGE_INSERT);
+            edge_fwd_iv.insert(edge_fwd_right_offset, right_relative);
+            edge_fwd_bv.insert(edge_fwd_right_offset, 0);
+            edge_fwd_inv_bv.insert(edge_fwd_right_offset, inv);
+        }
     }
     ++_edge_count;
 }
 
-uint64_t graph_t::edge_delta_to_id(uint64_t base, uint64_t delta) const {
-    assert(delta != 0);
-    if (delta == 1) {
-        return base;
-    } else if (delta % 2 == 0) {
-        return base + delta/2;
-    } else { //if (delta-1 % 2 == 0) {
-        return base - (delta-1)/2;
-    }
+uint64_t graph_t::edge_to_delta(const handle_t& left, const handle_t& right) const {
+    return id_to_delta(get_id(left), get_id(right));
 }
 
-uint64_t graph_t::edge_to_delta(const handle_t& left, const handle_t& right) const {
-    int64_t delta = get_id(right) - get_id(left);
+uint64_t graph_t::id_to_delta(id_t from, id_t to) {
+    int64_t delta = to - from;
     return (delta == 0 ? 1 : (delta > 0 ? 2*abs(delta) : 2*abs(delta)+1));
 }
 
 bool graph_t::has_edge(const handle_t& left, const handle_t& right) const {
     bool exists = false;
-    follow_edges(left, false, [&right, &exists](const handle_t& next) {
+    follow_edges_fast(left, false, [&right, &exists](const handle_t& next) {
             if (next == right) exists = true;
         });
     return exists;
@@ -599,66 +722,70 @@ void graph_t::destroy_edge(const handle_t& left, const handle_t& right) {
     uint64_t right_relative = edge_to_delta(right_h, left_h);
     uint64_t left_relative = edge_to_delta(left_h, right_h);
     if (!left_rev) {
-        uint64_t edge_fwd_left_offset = edge_fwd_bv.select1(left_rank);
+        uint64_t edge_fwd_left_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(left_rank));
         uint64_t edge_fwd_left_offset_erase = 0;
         for (uint64_t i = edge_fwd_left_offset+1; ; ++i) {
             uint64_t c = edge_fwd_iv.at(i);
-            if (c != 0) break;
+            if (c == 0) break;
             if (c == left_relative && inv == edge_fwd_inv_bv.at(i)) {
                 edge_fwd_left_offset_erase = i;
                 break;
             }
         }
         if (edge_fwd_left_offset_erase) {
+            DG_PROFILE_SCOPE(PROF_EDGE_REMOVE);
             edge_fwd_iv.remove(edge_fwd_left_offset_erase);
             edge_fwd_bv.remove(edge_fwd_left_offset_erase);
             edge_fwd_inv_bv.remove(edge_fwd_left_offset_erase);
         }
     } else {
-        uint64_t edge_rev_left_offset = edge_rev_bv.select1(left_rank);
+        uint64_t edge_rev_left_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(left_rank));
         uint64_t edge_rev_left_offset_erase = 0;
         for (uint64_t i = edge_rev_left_offset+1; ; ++i) {
             uint64_t c = edge_rev_iv.at(i);
-            if (c != 0) break;
+            if (c == 0) break;
             if (c == left_relative && inv == edge_rev_inv_bv.at(i)) {
                 edge_rev_left_offset_erase = i;
                 break;
             }
         }
         if (edge_rev_left_offset_erase) {
+            DG_PROFILE_SCOPE(PROF_EDGE_REMOVE);
             edge_rev_iv.remove(edge_rev_left_offset_erase);
             edge_rev_bv.remove(edge_rev_left_offset_erase);
             edge_rev_inv_bv.remove(edge_rev_left_offset_erase);
         }
     }
     if (!right_rev) {
-        uint64_t edge_rev_right_offset = edge_rev_bv.select1(right_rank);
+        uint64_t edge_rev_right_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_rev_bv.select1(right_rank));
         uint64_t edge_rev_right_offset_erase = 0;
         for (uint64_t i = edge_rev_right_offset+1; ; ++i) {
             uint64_t c = edge_rev_iv.at(i);
-            if (c != 0) break;
+            if (c == 0) break;
             if (c == right_relative && inv == edge_rev_inv_bv.at(i)) {
                 edge_rev_right_offset_erase = i;
                 break;
             }
         }
         if (edge_rev_right_offset_erase) {
+            DG_PROFILE_SCOPE(PROF_EDGE_REMOVE);
             edge_rev_iv.remove(edge_rev_right_offset_erase);
             edge_rev_bv.remove(edge_rev_right_offset_erase);
             edge_rev_inv_bv.remove(edge_rev_right_offset_erase);
         }
     } else {
-        uint64_t edge_fwd_right_offset = edge_fwd_bv.select1(right_rank);
+        uint64_t edge_fwd_right_offset = DG_PROFILE_EXPR(PROF_EDGE_SELECT, edge_fwd_bv.select1(right_rank));
         uint64_t edge_fwd_right_offset_erase = 0;
         for (uint64_t i = edge_fwd_right_offset+1; ; ++i) {
             uint64_t c = edge_fwd_iv.at(i);
-            if (c != 0) break;
+            if (c == 0) break;
             if (c == right_relative && inv == edge_fwd_inv_bv.at(i)) {
                 edge_fwd_right_offset_erase = i;
                 break;
             }
         }
         if (edge_fwd_right_offset_erase) {
+            DG_PROFILE_SCOPE(PROF_EDGE_REMOVE);
             edge_fwd_iv.remove(edge_fwd_right_offset_erase);
             edge_fwd_bv.remove(edge_fwd_right_offset_erase);
             edge_fwd_inv_bv.remove(edge_fwd_right_offset_erase);
@@ -680,7 +807,7 @@ void graph_t::clear(void) {
     _path_count = 0;
     _path_handle_next = 0;
     graph_id_pv = null_pv;
-    graph_id_map.clear();
+    graph_id_index.clear();
     edge_fwd_iv = null_iv;
     edge_fwd_bv = null_bv;
     edge_fwd_inv_bv = null_bv;
@@ -724,10 +851,10 @@ handle_t graph_t::apply_orientation(const handle_t& handle) {
     // store edges
     vector<handle_t> edges_fwd;
     vector<handle_t> edges_rev;
-    follow_edges(handle, false, [&](const handle_t& h) {
+    follow_edges_fast(handle, false, [&](const handle_t& h) {
             edges_fwd.push_back(h);
         });
-    follow_edges(handle, true, [&](const handle_t& h) {
+    follow_edges_fast(handle, true, [&](const handle_t& h) {
             edges_rev.push_back(h);
         });
     // save the sequence's reverse complement, which we will use to add the new handle
@@ -771,12 +898,16 @@ std::vector<handle_t> graph_t::divide_handle(const handle_t& handle, const std::
         for (auto& o : offsets) fwd_offsets.push_back(o);
     }
     std::sort(fwd_offsets.begin(), fwd_offsets.end());
+    // the pieces run between the ends of the node and each offset
+    fwd_offsets.insert(fwd_offsets.begin(), 0);
+    fwd_offsets.push_back(length);
     handle_t fwd_handle = handle_helper::unpack_bit(handle) ? handle_helper::toggle_bit(handle) : handle;
+    id_t fwd_id = get_id(fwd_handle);
     // break it into the given pieces by building up the new node sequences
     std::string seq = get_sequence(fwd_handle);
     std::vector<std::string> seqs;
-    for (uint64_t i = 0; i < offsets.size()-1; ++i) {
-        seqs.push_back(seq.substr(offsets[i], offsets[i+1]-offsets[i]));
+    for (uint64_t i = 0; i < fwd_offsets.size()-1; ++i) {
+        seqs.push_back(seq.substr(fwd_offsets[i], fwd_offsets[i+1]-fwd_offsets[i]));
     }
     // make the handles
     std::vector<handle_t> handles;
@@ -795,32 +926,54 @@ std::vector<handle_t> graph_t::divide_handle(const handle_t& handle, const std::
     }
     // collect the handle's path context
     vector<occurrence_handle_t> occurrences;
-    for_each_occurrence_on_handle(handle, [&](const occurrence_handle_t& occ) {
+    for_each_occurrence_on_handle(fwd_handle, [&](const occurrence_handle_t& occ) {
             occurrences.push_back(occ);
         });
-    // replace path occurrences with the new handles
-    for (auto& occ : occurrences) {
-        handle_t h = get_occurrence(occ);
+    // replace path occurrences with the new handles; each replacement moves
+    // the later occurrences on the node down to the same rank
+    for (uint64_t i = 0; i < occurrences.size(); ++i) {
+        handle_t h = get_occurrence(occurrences.front());
         if (handle_helper::unpack_bit(h)) {
-            replace_occurrence(occ, rev_handles);
+            replace_occurrence(occurrences.front(), rev_handles);
         } else {
-            replace_occurrence(occ, handles);
+            replace_occurrence(occurrences.front(), handles);
         }
     }
-    // collect the context of the forward handle
-    vector<handle_t> edges_fwd;
-    vector<handle_t> edges_rev;
-    follow_edges(fwd_handle, false, [&](const handle_t& h) {
-            edges_fwd.push_back(h);
-        });
-    follow_edges(fwd_handle, true, [&](const handle_t& h) {
-            edges_rev.push_back(h);
-        });
+    // collect the edges of the node, each once, by id as destroying the
+    // node moves the ranks after it
+    std::vector<id_t> piece_ids;
+    for (auto& h : handles) piece_ids.push_back(get_id(h));
+    std::set<std::pair<uint64_t, uint64_t>> seen_edges;
+    std::vector<std::pair<std::pair<id_t, bool>, std::pair<id_t, bool>>> context;
+    auto add_edge = [&](const handle_t& left, const handle_t& right) {
+        edge_t e = edge_handle(left, right);
+        if (seen_edges.insert(std::make_pair(as_integer(e.first), as_integer(e.second))).second) {
+            context.push_back(std::make_pair(std::make_pair(get_id(e.first), get_is_reverse(e.first)),
+                                             std::make_pair(get_id(e.second), get_is_reverse(e.second))));
+        }
+    };
+    follow_edges_fast(fwd_handle, false, [&](const handle_t& h) { add_edge(fwd_handle, h); });
+    follow_edges_fast(fwd_handle, true, [&](const handle_t& h) { add_edge(h, fwd_handle); });
     // destroy the handle
     destroy_handle(fwd_handle);
-    // connect the ends to the previous context
-    for (auto& h : edges_rev) create_edge(h, handles.front());
-    for (auto& h : edges_rev) create_edge(handles.back(), h);
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        handles[i] = get_handle(piece_ids[i]);
+    }
+    // connect the ends to the previous context: the right side of the node
+    // is now that of the last piece, and its left side that of the first
+    for (auto& e : context) {
+        handle_t left = e.first.first == fwd_id
+            ? (e.first.second ? flip(handles.front()) : handles.back())
+            : get_handle(e.first.first, e.first.second);
+        handle_t right = e.second.first == fwd_id
+            ? (e.second.second ? flip(handles.back()) : handles.front())
+            : get_handle(e.second.first, e.second.second);
+        create_edge(left, right);
+    }
+    if (handle_helper::unpack_bit(handle)) {
+        std::reverse(handles.begin(), handles.end());
+        for (auto& h : handles) h = flip(h);
+    }
     return handles;
 }
     
@@ -853,6 +1006,7 @@ void graph_t::destroy_path(const path_handle_t& path) {
 }
 
 void graph_t::destroy_path_handle_records(uint64_t i) {
+    DG_PROFILE_SCOPE(PROF_PATH_REMOVE);
     path_handle_wt.remove(i);
     path_rev_iv.remove(i);
     path_next_id_iv.remove(i);
@@ -891,6 +1045,7 @@ occurrence_handle_t graph_t::create_occurrence(const path_handle_t& path, const
     as_integers(occ)[1] = rank_on_handle;
     // find our insertion point
     uint64_t i = occurrence_rank(occ);
+    DG_PROFILE_SCOPE(PROF_PATH_INSERT);
     // add reference to the path handle mapping
     path_handle_wt.insert(i, as_integer(path)+1);
     // record our handle orientation
@@ -932,18 +1087,23 @@ void graph_t::destroy_occurrence(const occurrence_handle_t& occurrence_handle) {
         path_prev_id_iv[i] = path_begin_marker;
         path_prev_rank_iv[i] = 0;
     }
-    // update other records on this path on this node
+    // the occurrences after this one on the node each move down a rank,
+    // so the steps linked to them and the path ends must follow
     handle_t handle = get_occurrence(occurrence_handle);
-    bool seen_curr = false;
+    uint64_t node_rank = as_integers(occurrence_handle)[0];
+    uint64_t removed = as_integers(occurrence_handle)[1];
     for_each_occurrence_on_handle(handle, [&](const occurrence_handle_t& occ) {
-            if (occ == occurrence_handle) {
-                if (seen_curr) {
-                    decrement_rank(occ);
-                } else {
-                    seen_curr = true;
-                }
+            if (as_integers(occ)[1] > removed) {
+                decrement_rank(occ);
             }
         });
+    for (auto& p : path_metadata_map) {
+        for (auto occ : { &p.second.first, &p.second.last }) {
+            if (as_integers(*occ)[0] == node_rank && as_integers(*occ)[1] > removed) {
+                --as_integers(*occ)[1];
+            }
+        }
+    }
     destroy_path_handle_records(occurrence_rank(occurrence_handle));
 }
 
@@ -1009,28 +1169,24 @@ graph_t::replace_occurrence(const occurrence_handle_t& occurrence_handle,
     assert(prev_seq == new_seq);
     // find the current occurrence
     handle_t curr_handle = get_occurrence(occurrence_handle);
-    // assert that we are not invalidating the path
-    assert(get_sequence(curr_handle) == get_sequence(assign_to));
     // we should not try to use this to reassign things to the same node
     for (auto& handle : handles) assert(curr_handle != handle);
     // get the context
     occurrence_handle_t prev_occ, next_occ;
-    if (has_previous_occurrence(occurrence_handle)) {
-        prev_occ = get_previous_occurrence(occurrence_handle);
-    } else {
-        as_integers(prev_occ)[0] = path_begin_marker;
-        as_integers(prev_occ)[1] = 0;
-    }
-    if (has_next_occurrence(occurrence_handle)) {
-        next_occ = get_next_occurrence(occurrence_handle);
-    } else {
-        as_integers(next_occ)[0] = path_end_marker;
-        as_integers(next_occ)[1] = 0;
-    }
+    bool has_prev = has_previous_occurrence(occurrence_handle);
+    bool has_next = has_next_occurrence(occurrence_handle);
+    if (has_prev) prev_occ = get_previous_occurrence(occurrence_handle);
+    if (has_next) next_occ = get_next_occurrence(occurrence_handle);
     // get the path
     path_handle_t path = get_path(occurrence_handle);
-    // destroy the current occurrence
+    // destroy the current occurrence, which moves the later ones on its node down a rank
     destroy_occurrence(occurrence_handle);
+    for (auto occ : { &prev_occ, &next_occ }) {
+        if (as_integers(*occ)[0] == as_integers(occurrence_handle)[0]
+            && as_integers(*occ)[1] > as_integers(occurrence_handle)[1]) {
+            --as_integers(*occ)[1];
+        }
+    }
     // determine the new occurrences
     std::vector<occurrence_handle_t> new_occs;
     for (auto& handle : handles) {
@@ -1041,12 +1197,18 @@ graph_t::replace_occurrence(const occurrence_handle_t& occurrence_handle,
         link_occurrences(new_occs[i], new_occs[i+1]);
     }
     // link to context
-    if (as_integers(prev_occ)[0] != path_begin_marker) {
+    auto& p = path_metadata_map[as_integer(path)];
+    if (has_prev) {
         link_occurrences(prev_occ, new_occs.front());
+    } else {
+        p.first = new_occs.front();
     }
-    if (as_integers(next_occ)[0] != path_end_marker) {
+    if (has_next) {
         link_occurrences(new_occs.back(), next_occ);
+    } else {
+        p.last = new_occs.back();
     }
+    p.length += new_occs.size() - 1;
     return new_occs;
 }
 
@@ -1126,162 +1288,802 @@ void graph_t::display(void) const {
 }
 
 void graph_t::to_gfa(std::ostream& out) const {
-    out << "H\tVN:Z:1.0" << std::endl;
-    // for each node
-    for_each_handle([&out,this](const handle_t& h) {
-            out << "S\t" << get_id(h) << "\t" << get_sequence(h) << std::endl;
-            // get the forward edges from this handle
-            follow_edges(h, false, [&out, &h, this](const handle_t& a){
-                    out << "L\t" << get_id(h) << "\t"
-                        << (handle_helper::unpack_bit(h)?"-":"+")
-                        << "\t" << get_id(a) << "\t"
-                        << (handle_helper::unpack_bit(a)?"-":"+")
-                        << "\t0M" << std::endl;
+    write_gfa(*this, out);
+}
+
+uint64_t graph_t::weakly_connected_components(std::vector<uint64_t>& component) const {
+    uint64_t node_count = node_size();
+    concurrent_union_find_t sets(node_count);
+    for_each_handle_fast([&](const handle_t& h) {
+            uint64_t rank = handle_helper::unpack_number(h);
+            // every edge is seen from both of its ends, so one end will do
+            for (bool go_left : {false, true}) {
+                follow_edges_fast(h, go_left, [&](const handle_t& next) {
+                        uint64_t other = handle_helper::unpack_number(next);
+                        if (other > rank) sets.unite(rank, other);
+                    });
+            }
+        }, true);
+    // each set's root is its lowest rank, so numbering roots in rank order
+    // numbers the components by their lowest-ranked nodes
+    component.resize(node_count);
+#pragma omp parallel for schedule(static)
+    for (uint64_t i = 0; i < node_count; ++i) {
+        component[i] = sets.find(i);
+    }
+    // a hidden node has no edges, so it is its own root and can be skipped
+    for (auto id : graph_id_hidden_set) {
+        component[graph_id_index.get(id)] = no_component;
+    }
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < node_count; ++i) {
+        if (component[i] == no_component) continue;
+        component[i] = component[i] == i ? count++ : component[component[i]];
+    }
+    return count;
+}
+
+/// A node gathered for append_handle, with the neighbors on each side
+struct node_record_t {
+    std::string sequence;
+    std::vector<std::pair<id_t, bool>> right;
+    std::vector<std::pair<id_t, bool>> left;
+};
+
+void graph_t::extract(id_t first, id_t last, uint64_t context, graph_t& into) const {
+    rank_bitset_t in_range(graph_id_pv.size());
+    for_each_handle_fast([&](const handle_t& h) {
+            id_t id = get_id(h);
+            if (id >= first && id <= last) in_range.set(handle_helper::unpack_number(h));
+        }, true);
+    std::vector<handle_t> nodes;
+    nodes.reserve(in_range.count());
+    for (uint64_t i = 0; i < graph_id_pv.size(); ++i) {
+        if (in_range.test(i)) nodes.push_back(handle_helper::pack(i, false));
+    }
+    extract(nodes, context, into);
+}
+
+void graph_t::extract(const std::vector<handle_t>& nodes, uint64_t context, graph_t& into) const {
+    if (into.node_size() || into.get_path_count()) {
+        throw std::runtime_error("[dg::graph_t] can only extract into an empty graph");
+    }
+    // the region keeps the order of its ranks here
+    std::vector<handle_t> region = bfs(*this, nodes, context).nodes;
+    std::sort(region.begin(), region.end(), [](const handle_t& a, const handle_t& b) {
+            return as_integer(a) < as_integer(b);
+        });
+    rank_bitset_t inside(graph_id_pv.size());
+    for (auto& h : region) {
+        inside.set(handle_helper::unpack_number(h));
+    }
+
+    // gather the node records, keeping only the edges within the region
+    std::vector<node_record_t> records(region.size());
+#pragma omp parallel for schedule(dynamic, 256)
+    for (uint64_t i = 0; i < region.size(); ++i) {
+        auto& record = records[i];
+        record.sequence = get_sequence(region[i]);
+        for (bool go_left : {false, true}) {
+            auto& side = go_left ? record.left : record.right;
+            follow_edges_fast(region[i], go_left, [&](const handle_t& next) {
+                    if (inside.test(handle_helper::unpack_number(next))) {
+                        side.push_back(std::make_pair(get_id(next), get_is_reverse(next)));
+                    }
                 });
+        }
+    }
+    for (uint64_t i = 0; i < region.size(); ++i) {
+        auto& record = records[i];
+        id_t id = get_id(region[i]);
+        into.append_handle(record.sequence, id, record.right, record.left);
+        record = node_record_t();
+        // a hidden node stays hidden in the extracted graph
+        if (graph_id_hidden_set.count(id)) {
+            into.graph_id_hidden_set.insert(id);
+            ++into._hidden_count;
+        }
+    }
+
+    // a stretch of a path starts where the path begins or enters the region
+    struct stretch_t {
+        path_handle_t path;
+        uint64_t first_index;
+        uint64_t first_rank_on_node;
+        std::vector<handle_t> steps;
+    };
+    std::vector<std::vector<stretch_t>> found(region.size());
+#pragma omp parallel for schedule(dynamic, 256)
+    for (uint64_t i = 0; i < region.size(); ++i) {
+        for_each_occurrence_on_handle(region[i], [&](const occurrence_handle_t& occ) {
+                if (has_previous_occurrence(occ)
+                    && inside.test(as_integers(get_previous_occurrence(occ))[0])) {
+                    return;
+                }
+                stretch_t stretch;
+                stretch.path = get_path(occ);
+                stretch.first_index = i;
+                stretch.first_rank_on_node = as_integers(occ)[1];
+                stretch.steps.push_back(get_occurrence(occ));
+                occurrence_handle_t curr = occ;
+                while (has_next_occurrence(curr)) {
+                    curr = get_next_occurrence(curr);
+                    if (!inside.test(as_integers(curr)[0])) break;
+                    stretch.steps.push_back(get_occurrence(curr));
+                }
+                found[i].push_back(std::move(stretch));
+            });
+    }
+    std::vector<stretch_t> stretches;
+    for (auto& f : found) {
+        for (auto& stretch : f) {
+            stretches.push_back(std::move(stretch));
+        }
+    }
+    found.clear();
+    // paths in their order here, and the stretches of each in region order
+    std::sort(stretches.begin(), stretches.end(), [](const stretch_t& a, const stretch_t& b) {
+            return std::make_tuple(as_integer(a.path), a.first_index, a.first_rank_on_node)
+                < std::make_tuple(as_integer(b.path), b.first_index, b.first_rank_on_node);
         });
-    for_each_path_handle([&out,this](const path_handle_t& p) {
-            //occurrence_handle_t occ = get_first_occurrence(p);
-            out << "P\t" << get_path_name(p) << "\t";
-            for_each_occurrence_in_path(p, [this,&out](const occurrence_handle_t& occ) {
-                    handle_t h = get_occurrence(occ);
-                    out << get_id(h) << (handle_helper::unpack_bit(h)?"-":"+");
-                    if (has_next_occurrence(occ)) out << ",";
+    for (uint64_t i = 0; i < stretches.size(); ) {
+        path_handle_t path = stretches[i].path;
+        uint64_t j = i;
+        while (j < stretches.size() && as_integer(stretches[j].path) == as_integer(path)) ++j;
+        std::string name = get_path_name(path);
+        bool whole = j - i == 1 && stretches[i].steps.size() == get_occurrence_count(path);
+        for (uint64_t k = i; k < j; ++k) {
+            path_handle_t copy = into.create_path_handle(whole ? name : name + "[" + std::to_string(k - i) + "]");
+            for (auto& h : stretches[k].steps) {
+                into.append_occurrence(copy, into.get_handle(get_id(h), get_is_reverse(h)));
+            }
+        }
+        i = j;
+    }
+}
+
+void graph_t::unchop(void) {
+    uint64_t rank_count = graph_id_pv.size();
+    // the handle that a handle can be merged with on its right, if any
+    auto merge_right = [&](const handle_t& h, handle_t& next) {
+        uint64_t degree = 0;
+        follow_edges_fast(h, false, [&](const handle_t& n) {
+                next = n;
+                return ++degree < 2;
+            });
+        if (degree != 1
+            || handle_helper::unpack_number(next) == handle_helper::unpack_number(h)
+            || get_degree(next, true) != 1
+            || get_occurrence_count(h) != get_occurrence_count(next)) {
+            return false;
+        }
+        // each path on h must go straight on to next; with the counts equal,
+        // every path on next then came from h
+        bool agree = true;
+        for_each_occurrence_on_handle(h, [&](const occurrence_handle_t& occ) {
+                if (!agree) return;
+                if (get_occurrence(occ) == h) {
+                    agree = has_next_occurrence(occ)
+                        && get_occurrence(get_next_occurrence(occ)) == next;
+                } else {
+                    agree = has_previous_occurrence(occ)
+                        && get_occurrence(get_previous_occurrence(occ)) == flip(next);
+                }
+            });
+        return agree;
+    };
+    // the links of each forward handle, to the handle after it and before it
+    std::vector<handle_t> right_link(rank_count), left_link(rank_count);
+    std::vector<uint8_t> has_right(rank_count), has_left(rank_count);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        handle_t h = handle_helper::pack(i, false);
+        has_right[i] = merge_right(h, right_link[i]);
+        has_left[i] = merge_right(flip(h), left_link[i]);
+        left_link[i] = flip(left_link[i]);
+    }
+    auto link = [&](const handle_t& h, bool go_left, handle_t& next) {
+        uint64_t i = handle_helper::unpack_number(h);
+        // the left of a reverse handle is the right of its forward one, flipped
+        if (go_left != handle_helper::unpack_bit(h)) {
+            next = left_link[i];
+            if (!has_left[i]) return false;
+        } else {
+            next = right_link[i];
+            if (!has_right[i]) return false;
+        }
+        if (handle_helper::unpack_bit(h)) next = flip(next);
+        return true;
+    };
+
+    // walk the chains out in rank order of their first-seen nodes; a chain
+    // closed into a cycle starts at the node the walk started from
+    std::vector<handle_t> chained;
+    std::vector<uint64_t> chain_offsets(1, 0);
+    std::vector<uint64_t> chain_of(rank_count);
+    std::vector<uint8_t> reversed_in_chain(rank_count);
+    std::vector<uint64_t> position(rank_count);
+    rank_bitset_t seen(rank_count);
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        if (seen.test(i)) continue;
+        handle_t start = handle_helper::pack(i, false), prev;
+        while (link(start, true, prev)) {
+            if (handle_helper::unpack_number(prev) == i) {
+                start = handle_helper::pack(i, false);
+                break;
+            }
+            start = prev;
+        }
+        uint64_t begin = chained.size();
+        handle_t curr = start, next;
+        chained.push_back(curr);
+        seen.set(handle_helper::unpack_number(curr));
+        while (link(curr, false, next) && !seen.test(handle_helper::unpack_number(next))) {
+            curr = next;
+            chained.push_back(curr);
+            seen.set(handle_helper::unpack_number(curr));
+        }
+        if (handle_helper::unpack_bit(chained[begin])) {
+            std::reverse(chained.begin() + begin, chained.end());
+            for (uint64_t j = begin; j < chained.size(); ++j) {
+                chained[j] = flip(chained[j]);
+            }
+        }
+        for (uint64_t j = begin; j < chained.size(); ++j) {
+            uint64_t rank = handle_helper::unpack_number(chained[j]);
+            chain_of[rank] = chain_offsets.size() - 1;
+            reversed_in_chain[rank] = handle_helper::unpack_bit(chained[j]);
+            position[rank] = j - begin;
+        }
+        chain_offsets.push_back(chained.size());
+    }
+    uint64_t chain_count = chain_offsets.size() - 1;
+    std::vector<id_t> chain_id(chain_count);
+    for (uint64_t k = 0; k < chain_count; ++k) {
+        chain_id[k] = get_id(chained[chain_offsets[k]]);
+    }
+    // where a handle here ends up in the merged graph
+    auto merged_handle = [&](const handle_t& h) {
+        uint64_t rank = handle_helper::unpack_number(h);
+        return std::make_pair(chain_id[chain_of[rank]],
+                              (bool)(reversed_in_chain[rank] != handle_helper::unpack_bit(h)));
+    };
+
+    // gather the merged nodes, whose outer edges are those of the chain ends
+    std::vector<node_record_t> records(chain_count);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (uint64_t k = 0; k < chain_count; ++k) {
+        auto& record = records[k];
+        for (uint64_t j = chain_offsets[k]; j < chain_offsets[k+1]; ++j) {
+            record.sequence.append(get_sequence(chained[j]));
+        }
+        follow_edges_fast(chained[chain_offsets[k+1]-1], false, [&](const handle_t& next) {
+                record.right.push_back(merged_handle(next));
+            });
+        follow_edges_fast(chained[chain_offsets[k]], true, [&](const handle_t& prev) {
+                record.left.push_back(merged_handle(prev));
+            });
+    }
+    // paths step onto a merged node only where they enter its chain
+    std::vector<path_handle_t> paths;
+    for_each_path_handle([&](const path_handle_t& p) { paths.push_back(p); });
+    std::vector<std::vector<std::pair<id_t, bool>>> path_records(paths.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        for_each_occurrence_in_path(paths[i], [&](const occurrence_handle_t& occ) {
+                handle_t h = get_occurrence(occ);
+                uint64_t rank = handle_helper::unpack_number(h);
+                auto step = merged_handle(h);
+                uint64_t k = chain_of[rank];
+                uint64_t entry = step.second ? chain_offsets[k+1] - chain_offsets[k] - 1 : 0;
+                if (position[rank] == entry) {
+                    path_records[i].push_back(step);
+                }
+            });
+    }
+
+    graph_t merged;
+    for (uint64_t k = 0; k < chain_count; ++k) {
+        auto& record = records[k];
+        merged.append_handle(record.sequence, chain_id[k], record.right, record.left);
+        // a hidden node has no edges, so it is a chain to itself and stays hidden
+        if (graph_id_hidden_set.count(chain_id[k])) {
+            merged.graph_id_hidden_set.insert(chain_id[k]);
+            ++merged._hidden_count;
+        }
+        record = node_record_t();
+    }
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        path_handle_t path = merged.create_path_handle(get_path_name(paths[i]));
+        for (auto& step : path_records[i]) {
+            merged.append_occurrence(path, merged.get_handle(step.first, step.second));
+        }
+    }
+    *this = std::move(merged);
+}
+
+void graph_t::chop(uint64_t max_length) {
+    if (max_length == 0) {
+        throw std::runtime_error("[dg::graph_t] cannot chop nodes to length 0");
+    }
+    uint64_t rank_count = graph_id_pv.size();
+    // the pieces of the node of rank i are piece_offsets[i] up to piece_offsets[i+1]
+    std::vector<uint64_t> piece_offsets(rank_count + 1, 0);
+#pragma omp parallel for schedule(static)
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        uint64_t length = get_length(handle_helper::pack(i, false));
+        piece_offsets[i+1] = std::max((uint64_t)1, (length + max_length - 1) / max_length);
+    }
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        piece_offsets[i+1] += piece_offsets[i];
+    }
+    // the pieces after the first take new ids in rank order
+    id_t next_id = _max_node_id + 1;
+    auto piece_id = [&](uint64_t rank, uint64_t j) {
+        return j == 0 ? (id_t)graph_id_pv.at(rank) : (id_t)(next_id + piece_offsets[rank] - rank + j - 1);
+    };
+    auto piece_count = [&](uint64_t rank) {
+        return piece_offsets[rank+1] - piece_offsets[rank];
+    };
+    // the piece holding the left end of a handle, in its orientation
+    auto left_end = [&](const handle_t& h) {
+        uint64_t rank = handle_helper::unpack_number(h);
+        bool rev = handle_helper::unpack_bit(h);
+        return std::make_pair(piece_id(rank, rev ? piece_count(rank) - 1 : 0), rev);
+    };
+    auto right_end = [&](const handle_t& h) {
+        uint64_t rank = handle_helper::unpack_number(h);
+        bool rev = handle_helper::unpack_bit(h);
+        return std::make_pair(piece_id(rank, rev ? 0 : piece_count(rank) - 1), rev);
+    };
+
+    graph_t chopped;
+    const uint64_t block_size = 1 << 16;
+    std::vector<std::vector<node_record_t>> records;
+    for (uint64_t block = 0; block < rank_count; block += block_size) {
+        uint64_t block_end = std::min(rank_count, block + block_size);
+        records.resize(block_end - block);
+#pragma omp parallel for schedule(dynamic, 256)
+        for (uint64_t i = block; i < block_end; ++i) {
+            handle_t h = handle_helper::pack(i, false);
+            std::string seq = get_sequence(h);
+            uint64_t count = piece_count(i);
+            auto& pieces = records[i - block];
+            pieces.resize(count);
+            for (uint64_t j = 0; j < count; ++j) {
+                auto& piece = pieces[j];
+                piece.sequence = seq.substr(j * max_length, max_length);
+                if (j > 0) piece.left.push_back(std::make_pair(piece_id(i, j-1), false));
+                if (j + 1 < count) piece.right.push_back(std::make_pair(piece_id(i, j+1), false));
+            }
+            follow_edges_fast(h, false, [&](const handle_t& next) {
+                    pieces.back().right.push_back(left_end(next));
                 });
-            out << "\t";
-            for_each_occurrence_in_path(p, [this,&out](const occurrence_handle_t& occ) {
-                    out << get_length(get_occurrence(occ)) << "M";
-                    if (has_next_occurrence(occ)) out << ",";
+            follow_edges_fast(h, true, [&](const handle_t& prev) {
+                    pieces.front().left.push_back(right_end(prev));
                 });
-            out << std::endl;
-        });
+        }
+        for (uint64_t i = block; i < block_end; ++i) {
+            auto& pieces = records[i - block];
+            // the pieces of a hidden node stay hidden
+            bool hidden = graph_id_hidden_set.count(piece_id(i, 0));
+            for (uint64_t j = 0; j < pieces.size(); ++j) {
+                chopped.append_handle(pieces[j].sequence, piece_id(i, j), pieces[j].right, pieces[j].left);
+                if (hidden) {
+                    chopped.graph_id_hidden_set.insert(piece_id(i, j));
+                    ++chopped._hidden_count;
+                }
+            }
+            pieces.clear();
+        }
+    }
+
+    // each step becomes a walk through the pieces of its node
+    std::vector<path_handle_t> paths;
+    for_each_path_handle([&](const path_handle_t& p) { paths.push_back(p); });
+    std::vector<std::vector<std::pair<id_t, bool>>> path_records(paths.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        for_each_occurrence_in_path(paths[i], [&](const occurrence_handle_t& occ) {
+                handle_t h = get_occurrence(occ);
+                uint64_t rank = handle_helper::unpack_number(h);
+                bool rev = handle_helper::unpack_bit(h);
+                uint64_t count = piece_count(rank);
+                for (uint64_t j = 0; j < count; ++j) {
+                    path_records[i].push_back(std::make_pair(piece_id(rank, rev ? count - 1 - j : j), rev));
+                }
+            });
+    }
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        path_handle_t path = chopped.create_path_handle(get_path_name(paths[i]));
+        for (auto& step : path_records[i]) {
+            chopped.append_occurrence(path, chopped.get_handle(step.first, step.second));
+        }
+        path_records[i].clear();
+    }
+    *this = std::move(chopped);
+}
+
+/// Approximate bytes held by a sparsepp table of the given entry type
+template<typename Map>
+static uint64_t hash_table_bytes(const Map& map) {
+    // entries plus about four bits of bookkeeping per bucket
+    return map.size() * sizeof(typename Map::value_type) + map.bucket_count() / 2;
+}
+
+void graph_t::dump_profile(std::ostream& out) {
+    dg::dump_profile(out);
+}
+
+memory_usage_t graph_t::memory_usage(void) const {
+    memory_usage_t usage("graph_t");
+    auto per = [](const memory_usage_t& m, uint64_t n) {
+        return n ? (double)m.bytes * 8 / n : 0.0;
+    };
+    memory_usage_t nodes("nodes");
+    nodes.add(memory_usage_t("graph_id_pv", graph_id_pv.bit_size() / 8));
+    nodes.add(memory_usage_t("graph_id_index", graph_id_index.bit_size() / 8));
+    nodes.add(memory_usage_t("graph_id_hidden_set", hash_table_bytes(graph_id_hidden_set)));
+    nodes.rates.push_back(std::make_pair("bits_per_node", per(nodes, _node_count)));
+    memory_usage_t edges("edges");
+    edges.add(memory_usage_t("edge_fwd_iv", edge_fwd_iv.bit_size() / 8));
+    edges.add(memory_usage_t("edge_fwd_bv", edge_fwd_bv.bit_size() / 8));
+    edges.add(memory_usage_t("edge_fwd_inv_bv", edge_fwd_inv_bv.bit_size() / 8));
+    edges.add(memory_usage_t("edge_rev_iv", edge_rev_iv.bit_size() / 8));
+    edges.add(memory_usage_t("edge_rev_bv", edge_rev_bv.bit_size() / 8));
+    edges.add(memory_usage_t("edge_rev_inv_bv", edge_rev_inv_bv.bit_size() / 8));
+    edges.rates.push_back(std::make_pair("bits_per_edge", per(edges, _edge_count)));
+    memory_usage_t sequence("sequence");
+    sequence.add(memory_usage_t("seq_pv", seq_pv.bit_size() / 8));
+    sequence.add(memory_usage_t("seq_bv", seq_bv.bit_size() / 8));
+    sequence.rates.push_back(std::make_pair("bits_per_base", per(sequence, seq_pv.size())));
+    memory_usage_t paths("paths");
+    paths.add(memory_usage_t("path_handle_wt", path_handle_wt.bit_size() / 8));
+    paths.add(memory_usage_t("path_rev_iv", path_rev_iv.bit_size() / 8));
+    paths.add(memory_usage_t("path_next_id_iv", path_next_id_iv.bit_size() / 8));
+    paths.add(memory_usage_t("path_next_rank_iv", path_next_rank_iv.bit_size() / 8));
+    paths.add(memory_usage_t("path_prev_id_iv", path_prev_id_iv.bit_size() / 8));
+    paths.add(memory_usage_t("path_prev_rank_iv", path_prev_rank_iv.bit_size() / 8));
+    uint64_t step_count = 0, name_bytes = 0;
+    for (auto& p : path_metadata_map) {
+        step_count += p.second.length;
+        name_bytes += p.second.name.capacity();
+    }
+    paths.add(memory_usage_t("path_metadata_map", hash_table_bytes(path_metadata_map) + name_bytes));
+    name_bytes = 0;
+    for (auto& p : path_name_map) {
+        name_bytes += p.first.capacity();
+    }
+    paths.add(memory_usage_t("path_name_map", hash_table_bytes(path_name_map) + name_bytes));
+    paths.rates.push_back(std::make_pair("bits_per_step", per(paths, step_count)));
+    usage.add(nodes);
+    usage.add(edges);
+    usage.add(sequence);
+    usage.add(paths);
+    return usage;
 }
 
-uint64_t graph_t::serialize(std::ostream& out) const {
+uint64_t graph_t::serialize(std::ostream& out, bool compress) const {
+    // serialize each section into memory first, so that we know the offsets
+    // and checksums to record in the section table before writing the sections
+    std::vector<graph_section_t> records;
+    std::vector<std::string> sections;
+    auto add_section = [&](uint64_t component, const std::string& raw, bool compressible) {
+        graph_section_t record;
+        record.component = component;
+        if (compress && compressible) {
+            record.encoding = ENCODING_ZLIB_BLOCKS;
+            sections.push_back(compress_blocks(raw));
+        } else {
+            record.encoding = ENCODING_RAW;
+            sections.push_back(raw);
+        }
+        records.push_back(record);
+    };
+    {
+        std::stringstream ss;
+        serialize_topology(ss);
+        add_section(COMPONENT_TOPOLOGY, ss.str(), false);
+    }
+    {
+        std::stringstream ss;
+        serialize_sequence(ss);
+        add_section(COMPONENT_SEQUENCE, ss.str(), true);
+    }
+    {
+        std::stringstream ss;
+        serialize_paths(ss);
+        add_section(COMPONENT_PATHS, ss.str(), true);
+    }
+    {
+        std::stringstream ss;
+        serialize_names(ss);
+        add_section(COMPONENT_NAMES, ss.str(), false);
+    }
     uint64_t written = 0;
+    out.write((char*)&graph_format_magic,sizeof(graph_format_magic));
+    written += sizeof(graph_format_magic);
+    out.write((char*)&graph_format_version,sizeof(graph_format_version));
+    written += sizeof(graph_format_version);
     out.write((char*)&_max_node_id,sizeof(_max_node_id));
     written += sizeof(_max_node_id);
     out.write((char*)&_min_node_id,sizeof(_min_node_id));
     written += sizeof(_min_node_id);
     out.write((char*)&_node_count,sizeof(_node_count));
     written += sizeof(_node_count);
+    out.write((char*)&_hidden_count,sizeof(_hidden_count));
+    written += sizeof(_hidden_count);
     out.write((char*)&_edge_count,sizeof(_edge_count));
     written += sizeof(_edge_count);
     out.write((char*)&_path_count,sizeof(_path_count));
     written += sizeof(_path_count);
     out.write((char*)&_path_handle_next,sizeof(_path_handle_next));
     written += sizeof(_path_handle_next);
-    written += graph_id_pv.serialize(out);
-    size_t i = graph_id_map.size();
-    out.write((char*)&i,sizeof(size_t));
-    written += sizeof(size_t);
-    for (auto& p : graph_id_map) {
-        out.write((char*)&p.first,sizeof(p.first));
-        written += sizeof(p.first);
-        out.write((char*)&p.second,sizeof(p.second));
-        written += sizeof(p.second);
+    uint64_t section_count = sections.size();
+    out.write((char*)&section_count,sizeof(section_count));
+    written += sizeof(section_count);
+    // the sections begin right after the table
+    uint64_t offset = written + section_count * sizeof(graph_section_t);
+    for (uint64_t i = 0; i < section_count; ++i) {
+        graph_section_t& record = records[i];
+        record.offset = offset;
+        record.length = sections[i].size();
+        record.checksum = section_checksum(sections[i].data(), sections[i].size());
+        out.write((char*)&record,sizeof(record));
+        written += sizeof(record);
+        offset += record.length;
+    }
+    for (auto& section : sections) {
+        out.write(section.data(),section.size());
+        written += section.size();
     }
+    return written;
+}
+
+uint64_t graph_t::serialize_topology(std::ostream& out) const {
+    uint64_t written = 0;
+    written += graph_id_pv.serialize(out);
+    written += graph_id_index.serialize(out);
+    std::vector<uint64_t> hidden(graph_id_hidden_set.begin(), graph_id_hidden_set.end());
+    std::sort(hidden.begin(), hidden.end());
+    written += write_array(out, hidden);
     written += edge_fwd_iv.serialize(out);
     written += edge_fwd_bv.serialize(out);
     written += edge_fwd_inv_bv.serialize(out);
     written += edge_rev_iv.serialize(out);
     written += edge_rev_bv.serialize(out);
     written += edge_rev_inv_bv.serialize(out);
+    return written;
+}
+
+uint64_t graph_t::serialize_sequence(std::ostream& out) const {
+    uint64_t written = 0;
     written += seq_pv.serialize(out);
     written += seq_bv.serialize(out);
+    return written;
+}
+
+uint64_t graph_t::serialize_paths(std::ostream& out) const {
+    uint64_t written = 0;
     written += path_handle_wt.serialize(out);
     written += path_rev_iv.serialize(out);
     written += path_next_id_iv.serialize(out);
     written += path_next_rank_iv.serialize(out);
     written += path_prev_id_iv.serialize(out);
     written += path_prev_rank_iv.serialize(out);
-    i = path_metadata_map.size();
-    out.write((char*)&i,sizeof(size_t));
-    written += sizeof(size_t);
+    // the metadata records as parallel arrays, sorted by path handle
+    std::vector<uint64_t> handles;
+    handles.reserve(path_metadata_map.size());
     for (auto& p : path_metadata_map) {
-        out.write((char*)&p.first,sizeof(p.first));
-        written += sizeof(p.first);
-        auto& m = p.second;
-        out.write((char*)&m.length,sizeof(m.length));
-        written += sizeof(m.length);
-        out.write((char*)&m.first,sizeof(m.first));
-        written += sizeof(m.first);
-        out.write((char*)&m.last,sizeof(m.last));
-        written += sizeof(m.last);
-        i = m.name.size();
-        out.write((char*)&i,sizeof(size_t));
-        written += sizeof(size_t);
-        out.write((char*)m.name.c_str(),m.name.size());
-        written += m.name.size();
-    }
-    i = path_name_map.size();
-    out.write((char*)&i,sizeof(size_t));
-    written += sizeof(size_t);
+        handles.push_back(p.first);
+    }
+    std::sort(handles.begin(), handles.end());
+    std::vector<uint64_t> lengths;
+    std::vector<occurrence_handle_t> firsts, lasts;
+    std::vector<const std::string*> names;
+    lengths.reserve(handles.size());
+    firsts.reserve(handles.size());
+    lasts.reserve(handles.size());
+    names.reserve(handles.size());
+    for (auto h : handles) {
+        auto& m = path_metadata_map.find(h)->second;
+        lengths.push_back(m.length);
+        firsts.push_back(m.first);
+        lasts.push_back(m.last);
+        names.push_back(&m.name);
+    }
+    written += write_array(out, handles);
+    written += write_array(out, lengths);
+    written += write_array(out, firsts);
+    written += write_array(out, lasts);
+    written += write_strings(out, names);
+    return written;
+}
+
+uint64_t graph_t::serialize_names(std::ostream& out) const {
+    uint64_t written = 0;
+    // names and their path handles as parallel arrays, sorted by name
+    std::vector<const std::pair<const std::string, uint64_t>*> entries;
+    entries.reserve(path_name_map.size());
     for (auto& p : path_name_map) {
-        i = p.first.size();
-        out.write((char*)&i,sizeof(size_t));
-        written += sizeof(size_t);
-        out.write(p.first.c_str(),p.first.size());
-        written += p.first.size();
-        out.write((char*)&p.second,sizeof(p.second));
-        written += sizeof(p.second);
+        entries.push_back(&p);
     }
+    std::sort(entries.begin(), entries.end(),
+              [](const std::pair<const std::string, uint64_t>* a,
+                 const std::pair<const std::string, uint64_t>* b) {
+                  return a->first < b->first;
+              });
+    std::vector<const std::string*> names;
+    std::vector<uint64_t> handles;
+    names.reserve(entries.size());
+    handles.reserve(entries.size());
+    for (auto e : entries) {
+        names.push_back(&e->first);
+        handles.push_back(e->second);
+    }
+    written += write_strings(out, names);
+    written += write_array(out, handles);
     return written;
 }
 
-void graph_t::load(std::istream& in) {
-    //uint64_t written = 0;
+void graph_t::load(std::istream& in, uint64_t components) {
+    uint64_t magic = 0, version = 0;
+    in.read((char*)&magic,sizeof(magic));
+    in.read((char*)&version,sizeof(version));
+    if (!in || magic != graph_format_magic) {
+        throw std::runtime_error("[dg::graph_t] input is not a serialized dg graph");
+    }
+    if (version < graph_format_min_version || version > graph_format_version) {
+        throw std::runtime_error("[dg::graph_t] unsupported graph format version " + std::to_string(version));
+    }
     in.read((char*)&_max_node_id,sizeof(_max_node_id));
     in.read((char*)&_min_node_id,sizeof(_min_node_id));
     in.read((char*)&_node_count,sizeof(_node_count));
+    in.read((char*)&_hidden_count,sizeof(_hidden_count));
     in.read((char*)&_edge_count,sizeof(_edge_count));
     in.read((char*)&_path_count,sizeof(_path_count));
     in.read((char*)&_path_handle_next,sizeof(_path_handle_next));
-    graph_id_pv.load(in);
-    size_t i;
-    in.read((char*)&i,sizeof(size_t));
-    for (size_t j = 0; j < i; ++j) {
-        uint64_t k, v;
-        in.read((char*)&k,sizeof(uint64_t));
-        in.read((char*)&v,sizeof(uint64_t));
-        graph_id_map[k] = v;
+    uint64_t section_count = 0;
+    in.read((char*)&section_count,sizeof(section_count));
+    std::vector<graph_section_t> sections(section_count);
+    for (auto& record : sections) {
+        in.read((char*)&record,sizeof(record));
+    }
+    if (!in) {
+        throw std::runtime_error("[dg::graph_t] truncated graph header");
     }
+    uint64_t consumed = sizeof(magic) + sizeof(version)
+        + sizeof(_max_node_id) + sizeof(_min_node_id)
+        + sizeof(_node_count) + sizeof(_hidden_count) + sizeof(_edge_count)
+        + sizeof(_path_count) + sizeof(_path_handle_next)
+        + sizeof(section_count) + section_count * sizeof(graph_section_t);
+    // visit the sections in file order, so we never have to seek backwards
+    std::sort(sections.begin(), sections.end(),
+              [](const graph_section_t& a, const graph_section_t& b) {
+                  return a.offset < b.offset;
+              });
+    for (auto& record : sections) {
+        if (!(components & record.component)) continue;
+        // skip to the section, which can't begin inside one we've read
+        if (record.offset < consumed) {
+            throw std::runtime_error("[dg::graph_t] misplaced graph section " + std::to_string(record.component));
+        }
+        in.ignore(record.offset - consumed);
+        consumed = record.offset;
+        // pull it into memory and make sure it's intact before decoding it
+        std::string buffer(record.length, '\0');
+        in.read(&buffer[0], record.length);
+        consumed += record.length;
+        if (!in || section_checksum(buffer.data(), buffer.size()) != record.checksum) {
+            throw std::runtime_error("[dg::graph_t] checksum mismatch in graph section " + std::to_string(record.component));
+        }
+        if (record.encoding == ENCODING_ZLIB_BLOCKS) {
+            buffer = decompress_blocks(buffer);
+        } else if (record.encoding != ENCODING_RAW) {
+            throw std::runtime_error("[dg::graph_t] unknown encoding " + std::to_string(record.encoding)
+                                     + " for graph section " + std::to_string(record.component));
+        }
+        std::stringstream ss(buffer);
+        switch (record.component) {
+        case COMPONENT_TOPOLOGY:
+            load_topology(ss);
+            if (version < 4) drop_doubled_self_edges();
+            break;
+        case COMPONENT_SEQUENCE:
+            load_sequence(ss);
+            break;
+        case COMPONENT_PATHS:
+            load_paths(ss);
+            break;
+        case COMPONENT_NAMES:
+            load_names(ss);
+            break;
+        default:
+            // sections from newer writers that we don't understand are ignored
+            break;
+        }
+    }
+}
+
+void graph_t::drop_doubled_self_edges(void) {
+    auto drop = [](lciv_iv& edge_iv, suc_bv& edge_bv, suc_bv& edge_inv_bv) {
+        // walk back so removals don't move the entries still to visit; a
+        // record's delimiter is the only entry with its bit set in edge_bv
+        uint64_t seen = 0;
+        for (uint64_t i = edge_iv.size(); i-- > 0; ) {
+            if (edge_bv.at(i)) {
+                seen = 0;
+            } else if (edge_iv.at(i) == 1 && edge_inv_bv.at(i) && ++seen % 2 == 0) {
+                edge_iv.remove(i);
+                edge_bv.remove(i);
+                edge_inv_bv.remove(i);
+            }
+        }
+    };
+    drop(edge_fwd_iv, edge_fwd_bv, edge_fwd_inv_bv);
+    drop(edge_rev_iv, edge_rev_bv, edge_rev_inv_bv);
+}
+
+void graph_t::load_topology(std::istream& in) {
+    graph_id_pv.load(in);
+    graph_id_index.load(in);
+    std::vector<uint64_t> hidden;
+    read_array(in, hidden);
+    graph_id_hidden_set.reserve(hidden.size());
+    graph_id_hidden_set.insert(hidden.begin(), hidden.end());
     edge_fwd_iv.load(in);
     edge_fwd_bv.load(in);
     edge_fwd_inv_bv.load(in);
     edge_rev_iv.load(in);
     edge_rev_bv.load(in);
     edge_rev_inv_bv.load(in);
+}
+
+void graph_t::load_sequence(std::istream& in) {
     seq_pv.load(in);
     seq_bv.load(in);
+}
+
+void graph_t::load_paths(std::istream& in) {
     path_handle_wt.load(in);
     path_rev_iv.load(in);
     path_next_id_iv.load(in);
     path_next_rank_iv.load(in);
     path_prev_id_iv.load(in);
     path_prev_rank_iv.load(in);
-    in.read((char*)&i,sizeof(size_t));
-    for (size_t j = 0; j < i; ++j) {
-        uint64_t k;
-        in.read((char*)&k,sizeof(uint64_t));
-        auto& m = path_metadata_map[k];
-        in.read((char*)&m.length,sizeof(m.length));
-        in.read((char*)&m.first,sizeof(m.first));
-        in.read((char*)&m.last,sizeof(m.last));
-        uint64_t s;
-        in.read((char*)&s,sizeof(size_t));
-        char n[s+1]; n[s] = '\0';
-        in.read(n,s);
-        m.name = string(n);
-    }
-    in.read((char*)&i,sizeof(size_t));
-    for (size_t j = 0; j < i; ++j) {
-        uint64_t s;
-        in.read((char*)&s,sizeof(size_t));
-        char k[s+1]; k[s] = '\0';
-        in.read(k,s);
-        uint64_t v;
-        in.read((char*)&v,sizeof(uint64_t));
-        path_name_map[string(k)] = v;
+    std::vector<uint64_t> handles, lengths;
+    std::vector<occurrence_handle_t> firsts, lasts;
+    std::vector<std::string> names;
+    read_array(in, handles);
+    read_array(in, lengths);
+    read_array(in, firsts);
+    read_array(in, lasts);
+    read_strings(in, names);
+    uint64_t n = handles.size();
+    if (lengths.size() != n || firsts.size() != n || lasts.size() != n || names.size() != n) {
+        throw std::runtime_error("[dg::graph_t] inconsistent path metadata arrays");
+    }
+    path_metadata_map.reserve(n);
+    for (uint64_t j = 0; j < n; ++j) {
+        auto& m = path_metadata_map[handles[j]];
+        m.length = lengths[j];
+        m.first = firsts[j];
+        m.last = lasts[j];
+        m.name = std::move(names[j]);
+    }
+}
+
+void graph_t::load_names(std::istream& in) {
+    std::vector<std::string> names;
+    std::vector<uint64_t> handles;
+    read_strings(in, names);
+    read_array(in, handles);
+    if (names.size() != handles.size()) {
+        throw std::runtime_error("[dg::graph_t] inconsistent path name arrays");
+    }
+    path_name_map.reserve(names.size());
+    for (uint64_t j = 0; j < names.size(); ++j) {
+        path_name_map.insert(std::make_pair(std::move(names[j]), handles[j]));
     }
 }
 
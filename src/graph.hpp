@@ -17,9 +17,16 @@
 #include "dynamic.hpp"
 #include "dynamic_types.hpp"
 #include "hash_map.hpp"
+#include "id_index.hpp"
+#include "graph_format.hpp"
+#include "memory_usage.hpp"
+#include "profile.hpp"
 
 namespace dg {
 
+/// The component of a hidden node, which belongs to none
+const uint64_t no_component = UINT64_MAX;
+
 class graph_t : public MutablePathDeletableHandleGraph {
         
 public:
@@ -47,11 +54,13 @@ public:
         _max_node_id = other._max_node_id;
         _min_node_id = other._min_node_id;
         _node_count = other._node_count;
+        _hidden_count = other._hidden_count;
         _edge_count = other._edge_count;
         _path_count = other._path_count;
         _path_handle_next = other._path_handle_next;
         graph_id_pv = other.graph_id_pv;
-        graph_id_map = other.graph_id_map;
+        graph_id_index = other.graph_id_index;
+        graph_id_hidden_set = other.graph_id_hidden_set;
         edge_fwd_iv = other.edge_fwd_iv;
         edge_fwd_bv = other.edge_fwd_bv;
         edge_fwd_inv_bv = other.edge_fwd_inv_bv;
@@ -75,27 +84,29 @@ public:
         _max_node_id = other._max_node_id;
         _min_node_id = other._min_node_id;
         _node_count = other._node_count;
+        _hidden_count = other._hidden_count;
         _edge_count = other._edge_count;
         _path_count = other._path_count;
         _path_handle_next = other._path_handle_next;
-        graph_id_pv = other.graph_id_pv;
-        graph_id_map = other.graph_id_map;
-        edge_fwd_iv = other.edge_fwd_iv;
-        edge_fwd_bv = other.edge_fwd_bv;
-        edge_fwd_inv_bv = other.edge_fwd_inv_bv;
-        edge_rev_iv = other.edge_rev_iv;
-        edge_rev_bv = other.edge_rev_bv;
-        edge_rev_inv_bv = other.edge_rev_inv_bv;
-        seq_pv = other.seq_pv;
-        seq_bv = other.seq_bv;
-        path_handle_wt = other.path_handle_wt;
-        path_rev_iv = other.path_rev_iv;
-        path_next_id_iv = other.path_next_id_iv;
-        path_next_rank_iv = other.path_next_rank_iv;
-        path_prev_id_iv = other.path_prev_id_iv;
-        path_prev_rank_iv = other.path_prev_rank_iv;
-        path_metadata_map = other.path_metadata_map;
-        path_name_map = other.path_name_map;
+        graph_id_pv = std::move(other.graph_id_pv);
+        graph_id_index = std::move(other.graph_id_index);
+        graph_id_hidden_set = std::move(other.graph_id_hidden_set);
+        edge_fwd_iv = std::move(other.edge_fwd_iv);
+        edge_fwd_bv = std::move(other.edge_fwd_bv);
+        edge_fwd_inv_bv = std::move(other.edge_fwd_inv_bv);
+        edge_rev_iv = std::move(other.edge_rev_iv);
+        edge_rev_bv = std::move(other.edge_rev_bv);
+        edge_rev_inv_bv = std::move(other.edge_rev_inv_bv);
+        seq_pv = std::move(other.seq_pv);
+        seq_bv = std::move(other.seq_bv);
+        path_handle_wt = std::move(other.path_handle_wt);
+        path_rev_iv = std::move(other.path_rev_iv);
+        path_next_id_iv = std::move(other.path_next_id_iv);
+        path_next_rank_iv = std::move(other.path_next_rank_iv);
+        path_prev_id_iv = std::move(other.path_prev_id_iv);
+        path_prev_rank_iv = std::move(other.path_prev_rank_iv);
+        path_metadata_map = std::move(other.path_metadata_map);
+        path_name_map = std::move(other.path_name_map);
     }
 
     /// Copy assignment operator.
@@ -105,33 +116,35 @@ public:
         return *this;
     }
 
-    /// Move assignment operator.
+    /// Move assignment operator. The members are moved rather than copied,
+    /// so a graph rebuilt into a temporary replaces this one without a second copy.
     graph_t& operator=(graph_t&& other) noexcept {
-        // todo should we use std::swap ?
         _max_node_id = other._max_node_id;
         _min_node_id = other._min_node_id;
         _node_count = other._node_count;
+        _hidden_count = other._hidden_count;
         _edge_count = other._edge_count;
         _path_count = other._path_count;
         _path_handle_next = other._path_handle_next;
-        graph_id_pv = other.graph_id_pv;
-        graph_id_map = other.graph_id_map;
-        edge_fwd_iv = other.edge_fwd_iv;
-        edge_fwd_bv = other.edge_fwd_bv;
-        edge_fwd_inv_bv = other.edge_fwd_inv_bv;
-        edge_rev_iv = other.edge_rev_iv;
-        edge_rev_bv = other.edge_rev_bv;
-        edge_rev_inv_bv = other.edge_rev_inv_bv;
-        seq_pv = other.seq_pv;
-        seq_bv = other.seq_bv;
-        path_handle_wt = other.path_handle_wt;
-        path_rev_iv = other.path_rev_iv;
-        path_next_id_iv = other.path_next_id_iv;
-        path_next_rank_iv = other.path_next_rank_iv;
-        path_prev_id_iv = other.path_prev_id_iv;
-        path_prev_rank_iv = other.path_prev_rank_iv;
-        path_metadata_map = other.path_metadata_map;
-        path_name_map = other.path_name_map;
+        graph_id_pv = std::move(other.graph_id_pv);
+        graph_id_index = std::move(other.graph_id_index);
+        graph_id_hidden_set = std::move(other.graph_id_hidden_set);
+        edge_fwd_iv = std::move(other.edge_fwd_iv);
+        edge_fwd_bv = std::move(other.edge_fwd_bv);
+        edge_fwd_inv_bv = std::move(other.edge_fwd_inv_bv);
+        edge_rev_iv = std::move(other.edge_rev_iv);
+        edge_rev_bv = std::move(other.edge_rev_bv);
+        edge_rev_inv_bv = std::move(other.edge_rev_inv_bv);
+        seq_pv = std::move(other.seq_pv);
+        seq_bv = std::move(other.seq_bv);
+        path_handle_wt = std::move(other.path_handle_wt);
+        path_rev_iv = std::move(other.path_rev_iv);
+        path_next_id_iv = std::move(other.path_next_id_iv);
+        path_next_rank_iv = std::move(other.path_next_rank_iv);
+        path_prev_id_iv = std::move(other.path_prev_id_iv);
+        path_prev_rank_iv = std::move(other.path_prev_rank_iv);
+        path_metadata_map = std::move(other.path_metadata_map);
+        path_name_map = std::move(other.path_name_map);
         return *this;
     }
 
@@ -155,6 +168,9 @@ public:
     
     /// Get the sequence of a node, presented in the handle's local forward orientation.
     std::string get_sequence(const handle_t& handle) const;
+
+    /// Append the sequence of a node, in the handle's orientation, to a buffer
+    void append_sequence(const handle_t& handle, std::string& buffer) const;
     
     /// Loop over all the handles to next/previous (right/left) nodes. Passes
     /// them to a callback which returns false to stop iterating and true to
@@ -168,6 +184,24 @@ public:
     /// order is not defined.
     void for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
     
+    /// Loop over the handles to next/previous (right/left) nodes like
+    /// follow_edges, with the iteratee inlined rather than called through a
+    /// std::function. The iteratee may return bool (false to stop) or void.
+    /// Returns true if we finished and false if we stopped early.
+    template<typename F>
+    bool follow_edges_fast(const handle_t& handle, bool go_left, F&& iteratee) const;
+    
+    /// Loop over all the nodes in the graph like for_each_handle, with the
+    /// iteratee inlined. The iteratee may return bool (false to stop) or void.
+    template<typename F>
+    void for_each_handle_fast(F&& iteratee, bool parallel = false) const;
+    
+    /// Follow the edges on one side of each of n handles at once. The
+    /// neighbors of in[i] are left in out in the order follow_edges would
+    /// visit them. The edge records are looked up in rank order, so nearby
+    /// handles share one select over the edge delimiters.
+    void follow_edges_batch(const handle_t* in, size_t n, bool go_left, neighbor_batch_t& out) const;
+    
     /// Return the number of nodes in the graph
     /// TODO: can't be node_count because XG has a field named node_count.
     size_t node_size(void) const;
@@ -206,17 +240,9 @@ public:
         // get_handle call (which is the shortest handle_t-typed expression I
         // could think of).
         
-        // Make a wrapper that puts a bool return type on.
-        std::function<bool(const handle_t&)> lambda = [&](const handle_t& found) {
-            iteratee(found);
-            return true;
-        };
-        
-        // Use that
-        follow_edges(handle, go_left, lambda);
-        
-        // During development I managed to get earlier versions of this template to build infinitely recursive functions.
-        static_assert(!std::is_void<decltype(lambda(get_handle(0, false)))>::value, "can't take our own lambda");
+        // The inlined loop takes void-returning iteratees directly, so there
+        // is no std::function wrapper to go through.
+        follow_edges_fast(handle, go_left, iteratee);
     }
     
     /// Loop over all the nodes in the graph in their local forward
@@ -225,14 +251,7 @@ public:
     template <typename T>
     auto for_each_handle(T&& iteratee, bool parallel = false) const
     -> typename std::enable_if<std::is_void<decltype(iteratee(get_handle(0, false)))>::value>::type {
-        // Make a wrapper that puts a bool return type on.
-        std::function<bool(const handle_t&)> lambda = [&](const handle_t& found) {
-            iteratee(found);
-            return true;
-        };
-        
-        // Use that
-        for_each_handle(lambda, parallel);
+        for_each_handle_fast(iteratee, parallel);
     }
 
     void for_each_edge(const std::function<bool(const edge_t&)>& iteratee, bool parallel = false);
@@ -481,14 +500,65 @@ public:
     /// A helper function to visualize the state of the graph
     void display(void) const;
 
-    /// Convert to GFA (for debugging)
+    /// Convert to GFA, formatting in parallel (see gfa.hpp)
     void to_gfa(std::ostream& out) const;
 
-    /// Serialize
-    uint64_t serialize(std::ostream& out) const;
-
-    /// Load
-    void load(std::istream& in);
+    /// Label each node with its weakly connected component: component[rank]
+    /// is the component of the node of that internal rank. Components are
+    /// numbered in the order of their lowest-ranked nodes. Hidden nodes are
+    /// labeled no_component and are not counted. The edges are merged in
+    /// parallel with a lock-free union-find. Returns the number of
+    /// components.
+    uint64_t weakly_connected_components(std::vector<uint64_t>& component) const;
+
+    /// Copy the given nodes and every node within context steps of them,
+    /// with the edges among them, into the empty graph into. The node
+    /// records are gathered in parallel and appended there in one pass, in
+    /// the order of their ranks here. The paths are clipped to the region:
+    /// each stretch of a path through it becomes a path of its own, named
+    /// name[k] with k counting the stretches of that path, unless the whole
+    /// path lies in the region and keeps its name. Throws if into is not empty.
+    void extract(const std::vector<handle_t>& nodes, uint64_t context, graph_t& into) const;
+
+    /// Extract the nodes with ids from first through last, and their
+    /// context, as above. The range is found with a parallel scan of the ids.
+    void extract(id_t first, id_t last, uint64_t context, graph_t& into) const;
+
+    /// Merge each maximal chain of nodes joined by single edges into one
+    /// node, wherever every path that visits one node of a link goes straight
+    /// on to the other. A merged node takes the id of the first node of its
+    /// chain, read in the orientation that leaves that node forward, and
+    /// paths step through it once. The links are found in parallel and the
+    /// graph is rebuilt in one pass, so all handles are invalidated.
+    void unchop(void);
+
+    /// Split every node longer than max_length into pieces of max_length,
+    /// the last piece taking what is left. The first piece of a node keeps
+    /// its id and the others take new ids above the largest one. Paths step
+    /// through each piece. The pieces are gathered in parallel over blocks of
+    /// ranks and streamed into a rebuilt graph, so all handles are invalidated.
+    void chop(uint64_t max_length);
+
+    /// Measure the bytes used by each backing structure, grouped into nodes,
+    /// edges, sequence and paths. Each group carries the bits it uses per
+    /// node, edge, base or path step respectively. Hash map sizes are estimates.
+    memory_usage_t memory_usage(void) const;
+
+    /// Write the counts and cycle totals of the instrumented succinct
+    /// primitives, summed over every thread. Only collected in builds
+    /// configured with -DDG_PROFILE=ON; otherwise this says so.
+    static void dump_profile(std::ostream& out);
+
+    /// Serialize, writing a header, a table of checksummed sections and then
+    /// the sections themselves (see graph_format.hpp). If compress is set, the
+    /// sequence and path sections are stored as independently compressed blocks.
+    uint64_t serialize(std::ostream& out, bool compress = false) const;
+
+    /// Load, materializing only the components (graph_component_t) set in the
+    /// mask. Sections for other components are skipped without being decoded,
+    /// and the structures backing them are left empty. Throws if the stream is
+    /// not a serialized graph or if a loaded section fails its checksum.
+    void load(std::istream& in, uint64_t components = COMPONENT_ALL);
     
 /// These are the backing data structures that we use to fulfill the above functions
 
@@ -497,8 +567,8 @@ private:
     /// Records node ids to allow for random access and random order
     /// Use the special value "0" to indicate deleted nodes
     dyn::packed_vector graph_id_pv;
-    /// efficient id to handle conversion
-    hash_map<uint64_t, uint64_t> graph_id_map;
+    /// efficient id to handle conversion, dense when the ids are compact
+    id_index_t graph_id_index;
     id_t _max_node_id = 0;
     id_t _min_node_id = 0;
     /// records nodes that are hidden, but used to store path sequence that has been removed from the node space
@@ -587,6 +657,20 @@ private:
     /// Helper to convert between ids and stored edge
     uint64_t edge_to_delta(const handle_t& left, const handle_t& right) const;
 
+    /// The stored edge value for the step from one id to another
+    static uint64_t id_to_delta(id_t from, id_t to);
+
+    /// Helper to append a node together with its edge records, for building
+    /// a graph in rank order without inserting into the middle of the edge
+    /// vectors. Each neighbor is the id and orientation that follow_edges
+    /// would give from the forward handle, and may not exist yet. Each edge
+    /// is counted in the record of its end with the larger id, whatever the
+    /// order the nodes are appended in. A self edge is counted in the right
+    /// record, or in the left one if it joins the left side to itself.
+    handle_t append_handle(const std::string& sequence, id_t id,
+                           const std::vector<std::pair<id_t, bool>>& right,
+                           const std::vector<std::pair<id_t, bool>>& left);
+
     /// Helper to simplify removal of path handle records
     void destroy_path_handle_records(uint64_t i);
 
@@ -605,8 +689,76 @@ private:
     /// The internal rank of the occurrence
     uint64_t occurrence_rank(const occurrence_handle_t& occurrence_handle) const;
 
+    /// Helpers to write and read the structures belonging to each section of the serialized graph
+    uint64_t serialize_topology(std::ostream& out) const;
+    uint64_t serialize_sequence(std::ostream& out) const;
+    uint64_t serialize_paths(std::ostream& out) const;
+    uint64_t serialize_names(std::ostream& out) const;
+    void load_topology(std::istream& in);
+    void load_sequence(std::istream& in);
+    void load_paths(std::istream& in);
+    void load_names(std::istream& in);
+
+    /// Drop the second of each pair of entries that a version 3 file holds
+    /// for a reversing self edge
+    void drop_doubled_self_edges(void);
+
 };
 
+inline uint64_t graph_t::edge_delta_to_id(uint64_t base, uint64_t delta) const {
+    assert(delta != 0);
+    if (delta == 1) {
+        return base;
+    } else if (delta % 2 == 0) {
+        return base + delta/2;
+    } else { //if (delta-1 % 2 == 0) {
+        return base - (delta-1)/2;
+    }
+}
+
+template<typename F>
+bool graph_t::follow_edges_fast(const handle_t& handle, bool go_left, F&& iteratee) const {
+    uint64_t offset = handle_helper::unpack_number(handle);
+    bool is_rev = handle_helper::unpack_bit(handle);
+    uint64_t base = graph_id_pv.at(offset);
+    // NB edges are stored in canonical orientation, forward to reverse prefered
+    bool fwd = !go_left && !is_rev || go_left && is_rev;
+    const lciv_iv& edge_iv = fwd ? edge_fwd_iv : edge_rev_iv;
+    const suc_bv& edge_inv_bv = fwd ? edge_fwd_inv_bv : edge_rev_inv_bv;
+    uint64_t edges_begin = DG_PROFILE_EXPR(PROF_EDGE_SELECT, (fwd ? edge_fwd_bv : edge_rev_bv).select1(offset))+1;
+    for (uint64_t i = edges_begin; ; ++i) {
+        uint64_t x = edge_iv.at(i);
+        if (x==0) break; // end of record
+        // stored values are zigzag deltas: 1 for the same id, 2d for +d, 2d+1 for -d
+        id_t id = edge_delta_to_id(base, x);
+        uint64_t rank = DG_PROFILE_EXPR(PROF_ID_LOOKUP, graph_id_index.get(id));
+        bool inv = edge_inv_bv.at(i);
+        if (!keep_iterating(iteratee, handle_helper::pack(rank, inv ? !is_rev : is_rev))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename F>
+void graph_t::for_each_handle_fast(F&& iteratee, bool parallel) const {
+    uint64_t node_count = graph_id_pv.size();
+    if (parallel) {
+        volatile bool stop = false;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (stop) continue;
+            if (!keep_iterating(iteratee, handle_helper::pack(i, false))) {
+                stop = true;
+            }
+        }
+    } else {
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (!keep_iterating(iteratee, handle_helper::pack(i, false))) break;
+        }
+    }
+}
+
 } // end dankness
 
 #endif /* dgraph_hpp */
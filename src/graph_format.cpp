@@ -0,0 +1,88 @@
+//
+//  graph_format.cpp
+//
+
+#include "graph_format.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace dg {
+
+std::string compress_blocks(const std::string& raw, uint64_t block_size) {
+    uint64_t raw_length = raw.size();
+    uint64_t block_count = (raw_length + block_size - 1) / block_size;
+    std::vector<std::string> blocks(block_count);
+    volatile bool failed = false;
+#pragma omp parallel for schedule(dynamic)
+    for (uint64_t i = 0; i < block_count; ++i) {
+        const char* begin = raw.data() + i * block_size;
+        uLong length = std::min(block_size, raw_length - i * block_size);
+        uLongf bound = compressBound(length);
+        std::string& block = blocks[i];
+        block.resize(bound);
+        if (compress2((Bytef*)&block[0], &bound, (const Bytef*)begin, length, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            failed = true;
+        }
+        block.resize(bound);
+    }
+    if (failed) {
+        throw std::runtime_error("[dg::compress_blocks] zlib compression failed");
+    }
+    std::string stored;
+    stored.append((char*)&raw_length, sizeof(raw_length));
+    stored.append((char*)&block_size, sizeof(block_size));
+    stored.append((char*)&block_count, sizeof(block_count));
+    for (auto& block : blocks) {
+        uint64_t length = block.size();
+        stored.append((char*)&length, sizeof(length));
+    }
+    for (auto& block : blocks) {
+        stored.append(block);
+    }
+    return stored;
+}
+
+std::string decompress_blocks(const std::string& stored) {
+    const uint64_t header = 3 * sizeof(uint64_t);
+    if (stored.size() < header) {
+        throw std::runtime_error("[dg::decompress_blocks] truncated block header");
+    }
+    const uint64_t* fields = (const uint64_t*)stored.data();
+    uint64_t raw_length = fields[0];
+    uint64_t block_size = fields[1];
+    uint64_t block_count = fields[2];
+    if (block_size == 0
+        || block_count > (stored.size() - header) / sizeof(uint64_t)
+        || block_count != (raw_length + block_size - 1) / block_size) {
+        throw std::runtime_error("[dg::decompress_blocks] malformed block table");
+    }
+    // find where each compressed block starts
+    std::vector<uint64_t> offsets(block_count+1);
+    offsets[0] = header + block_count * sizeof(uint64_t);
+    for (uint64_t i = 0; i < block_count; ++i) {
+        offsets[i+1] = offsets[i] + fields[3+i];
+    }
+    if (offsets[block_count] != stored.size()) {
+        throw std::runtime_error("[dg::decompress_blocks] block sizes don't match section length");
+    }
+    std::string raw(raw_length, '\0');
+    volatile bool failed = false;
+#pragma omp parallel for schedule(dynamic)
+    for (uint64_t i = 0; i < block_count; ++i) {
+        uLongf expected = std::min(block_size, raw_length - i * block_size);
+        uLongf length = expected;
+        if (uncompress((Bytef*)&raw[i * block_size], &length,
+                       (const Bytef*)stored.data() + offsets[i], offsets[i+1] - offsets[i]) != Z_OK
+            || length != expected) {
+            failed = true;
+        }
+    }
+    if (failed) {
+        throw std::runtime_error("[dg::decompress_blocks] zlib decompression failed");
+    }
+    return raw;
+}
+
+}
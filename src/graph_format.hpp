@@ -0,0 +1,170 @@
+#ifndef dgraph_graph_format_hpp
+#define dgraph_graph_format_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+/** \file
+ * graph_format.hpp: constants and helpers describing the on-disk layout
+ * written by graph_t::serialize.
+ *
+ * A serialized graph is laid out as
+ *
+ *     magic | version | scalar counters | section count | section table | sections...
+ *
+ * where every entry of the section table records which component the section
+ * holds, how it is encoded, its byte offset from the start of the stream, its
+ * length and a checksum of its stored bytes. Loaders can use the table to skip
+ * the components they don't need.
+ *
+ * Sections can optionally be stored as independently deflated blocks, so that
+ * they can be compressed and decompressed in parallel:
+ *
+ *     raw length | block size | block count | compressed block sizes | blocks...
+ *
+ * Hash maps are not written entry by entry. Their keys are sorted and written
+ * together with their values as contiguous arrays, so that loading them is a
+ * handful of bulk reads followed by a single reserve and insertion pass.
+ */
+
+namespace dg {
+
+/// Magic number opening every serialized graph ("DGGRAPH\0" in little-endian byte order)
+const uint64_t graph_format_magic = 0x0048504152474744ULL;
+
+/// Version of the layout written by graph_t::serialize:
+///  1. sections with checksums
+///  2. block-compressed sequence and path sections; later also the id index
+///     in the topology section, which was written under the same number
+///  3. id, hidden-node and path maps as sorted bulk arrays
+///  4. a reversing self edge stored as one entry rather than two
+const uint64_t graph_format_version = 4;
+
+/// Oldest version that graph_t::load still reads. Version 2 covers two
+/// different layouts, so it can't be read and is refused by number.
+const uint64_t graph_format_min_version = 3;
+
+/// Amount of raw section data that is deflated as one independent block
+const uint64_t graph_format_block_size = 1 << 20;
+
+/// Components of a graph that are stored in separate sections, and which can
+/// be selectively materialized by graph_t::load by or-ing them into a mask
+enum graph_component_t : uint64_t {
+    /// node ids, the id to rank index and the edge lists
+    COMPONENT_TOPOLOGY = 1,
+    /// node sequences
+    COMPONENT_SEQUENCE = 2,
+    /// path occurrences and per-path metadata
+    COMPONENT_PATHS = 4,
+    /// the path name to path handle index
+    COMPONENT_NAMES = 8,
+    /// everything
+    COMPONENT_ALL = 15
+};
+
+/// How the bytes of a section are stored
+enum graph_encoding_t : uint64_t {
+    /// as written by the structures' own serialize methods
+    ENCODING_RAW = 0,
+    /// as a series of independently zlib-compressed blocks
+    ENCODING_ZLIB_BLOCKS = 1
+};
+
+/// One record in the section table
+struct graph_section_t {
+    /// the graph_component_t stored in the section
+    uint64_t component;
+    /// the graph_encoding_t of the stored bytes
+    uint64_t encoding;
+    /// byte offset of the section from the start of the serialized graph
+    uint64_t offset;
+    /// length of the section in bytes
+    uint64_t length;
+    /// section_checksum of the section's stored bytes
+    uint64_t checksum;
+};
+
+/// 64-bit FNV-1a hash of a section's bytes
+inline uint64_t section_checksum(const char* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (uint8_t)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/// Write a vector of plain values as its length followed by one contiguous block
+template<typename T>
+uint64_t write_array(std::ostream& out, const std::vector<T>& values) {
+    uint64_t n = values.size();
+    out.write((char*)&n,sizeof(n));
+    out.write((char*)values.data(),n*sizeof(T));
+    return sizeof(n) + n*sizeof(T);
+}
+
+/// Read a vector written by write_array in one bulk read
+template<typename T>
+void read_array(std::istream& in, std::vector<T>& values) {
+    uint64_t n = 0;
+    in.read((char*)&n,sizeof(n));
+    if (!in) {
+        throw std::runtime_error("[dg::graph_format] truncated array length");
+    }
+    values.resize(n);
+    in.read((char*)values.data(),n*sizeof(T));
+    if (!in) {
+        throw std::runtime_error("[dg::graph_format] truncated array");
+    }
+}
+
+/// Write strings as an array of end offsets followed by their concatenated bytes
+inline uint64_t write_strings(std::ostream& out, const std::vector<const std::string*>& strings) {
+    std::vector<uint64_t> ends;
+    ends.reserve(strings.size());
+    std::string bytes;
+    for (auto s : strings) {
+        bytes.append(*s);
+        ends.push_back(bytes.size());
+    }
+    uint64_t written = write_array(out, ends);
+    out.write(bytes.data(),bytes.size());
+    return written + bytes.size();
+}
+
+/// Read strings written by write_strings
+inline void read_strings(std::istream& in, std::vector<std::string>& strings) {
+    std::vector<uint64_t> ends;
+    read_array(in, ends);
+    std::string bytes(ends.empty() ? 0 : ends.back(), '\0');
+    in.read(&bytes[0],bytes.size());
+    if (!in) {
+        throw std::runtime_error("[dg::graph_format] truncated string data");
+    }
+    strings.clear();
+    strings.reserve(ends.size());
+    uint64_t begin = 0;
+    for (auto end : ends) {
+        if (end < begin || end > bytes.size()) {
+            throw std::runtime_error("[dg::graph_format] malformed string offsets");
+        }
+        strings.push_back(bytes.substr(begin, end - begin));
+        begin = end;
+    }
+}
+
+/// Encode the raw bytes of a section as independently compressed blocks of
+/// the given raw size. Blocks are compressed in parallel.
+std::string compress_blocks(const std::string& raw, uint64_t block_size = graph_format_block_size);
+
+/// Decode a section stored by compress_blocks back into its raw bytes.
+/// Blocks are decompressed in parallel. Throws if the encoding is damaged.
+std::string decompress_blocks(const std::string& stored);
+
+}
+
+#endif
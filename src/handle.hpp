@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <vector>
 #include <cassert>
+#include <type_traits>
 
 namespace dg {
 
@@ -93,6 +94,41 @@ struct handle_helper {
 
 };
 
+/// Call an iteratee on a handle and report whether iteration should go on.
+/// Iteratees that return void always go on. Lets the templated iteration
+/// entry points take either kind of callback without a std::function.
+template<typename F>
+inline auto keep_iterating(F& iteratee, const handle_t& handle)
+    -> typename std::enable_if<std::is_void<decltype(iteratee(handle))>::value, bool>::type {
+    iteratee(handle);
+    return true;
+}
+
+/// Call a bool-returning iteratee on a handle; false means stop.
+template<typename F>
+inline auto keep_iterating(F& iteratee, const handle_t& handle)
+    -> typename std::enable_if<!std::is_void<decltype(iteratee(handle))>::value, bool>::type {
+    return iteratee(handle);
+}
+
+/// The neighbors of a batch of handles, in compressed sparse row form: the
+/// neighbors of the i-th handle asked about are handles[offsets[i]] up to
+/// handles[offsets[i+1]]. Can be reused across batches to keep its storage.
+struct neighbor_batch_t {
+    std::vector<uint64_t> offsets;
+    std::vector<handle_t> handles;
+
+    /// The number of handles the batch was asked about
+    inline size_t size(void) const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    /// The number of neighbors of the i-th handle
+    inline size_t degree(size_t i) const {
+        return offsets[i+1] - offsets[i];
+    }
+};
+
 /// A path handle is an opaque reference to a named path in a graph.
 struct path_handle_t {
     char data[sizeof(int64_t)];
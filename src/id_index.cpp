@@ -0,0 +1,186 @@
+//
+//  id_index.cpp
+//
+
+#include "id_index.hpp"
+#include "graph_format.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace dg {
+
+void id_index_t::set(uint64_t id, uint64_t rank) {
+    bool is_new = !has(id);
+    if (is_new) {
+        if (count == 0) {
+            min_id = id;
+            max_id = id;
+        } else {
+            min_id = std::min(min_id, id);
+            max_id = std::max(max_id, id);
+        }
+        ++count;
+    }
+    uint64_t spread = max_id - min_id + 1;
+    if (dense && spread > sparse_min_spread * count) {
+        make_sparse();
+    } else if (!dense && spread <= dense_max_spread * count) {
+        make_dense();
+    }
+    if (dense) {
+        extend_dense(id);
+        dense_iv.set(id - dense_base, rank + 1);
+    } else {
+        sparse_map[id] = rank;
+    }
+}
+
+void id_index_t::erase(uint64_t id) {
+    if (!has(id)) return;
+    if (dense) {
+        dense_iv.set(id - dense_base, 0);
+    } else {
+        sparse_map.erase(id);
+    }
+    if (--count == 0) {
+        // start over, so that the next ids choose the representation afresh
+        clear();
+    }
+}
+
+void id_index_t::clear(void) {
+    dense = true;
+    dense_base = 0;
+    dense_iv.clear();
+    sparse_map = hash_map<uint64_t, uint64_t>();
+    count = 0;
+    min_id = 0;
+    max_id = 0;
+}
+
+void id_index_t::extend_dense(uint64_t id) {
+    if (dense_iv.empty()) {
+        dense_base = id;
+    } else if (id < dense_base) {
+        // shift everything up, leaving headroom below so that runs of
+        // descending ids don't shift on every insertion
+        uint64_t headroom = std::min(dense_iv.size(), id);
+        uint64_t new_base = id - headroom;
+        uint64_t shift = dense_base - new_base;
+        SuccinctDynamicVector shifted;
+        for (uint64_t i = 0; i < shift; ++i) {
+            shifted.append(0);
+        }
+        for (uint64_t i = 0; i < dense_iv.size(); ++i) {
+            shifted.append(dense_iv.get(i));
+        }
+        dense_iv = std::move(shifted);
+        dense_base = new_base;
+    }
+    while (id - dense_base >= dense_iv.size()) {
+        dense_iv.append(0);
+    }
+}
+
+void id_index_t::make_dense(void) {
+    dense = true;
+    dense_base = min_id;
+    dense_iv.clear();
+    for (uint64_t id = min_id; id <= max_id; ++id) {
+        dense_iv.append(0);
+    }
+    for (auto& p : sparse_map) {
+        dense_iv.set(p.first - dense_base, p.second + 1);
+    }
+    sparse_map = hash_map<uint64_t, uint64_t>();
+}
+
+void id_index_t::make_sparse(void) {
+    dense = false;
+    sparse_map.reserve(count);
+    for (uint64_t i = 0; i < dense_iv.size(); ++i) {
+        uint64_t v = dense_iv.get(i);
+        if (v) sparse_map[dense_base + i] = v - 1;
+    }
+    dense_iv.clear();
+    dense_base = 0;
+}
+
+void id_index_t::for_each(const std::function<void(uint64_t, uint64_t)>& iteratee) const {
+    if (dense) {
+        for (uint64_t i = 0; i < dense_iv.size(); ++i) {
+            uint64_t v = dense_iv.get(i);
+            if (v) iteratee(dense_base + i, v - 1);
+        }
+    } else {
+        for (auto& p : sparse_map) {
+            iteratee(p.first, p.second);
+        }
+    }
+}
+
+uint64_t id_index_t::bit_size(void) const {
+    if (dense) {
+        return dense_iv.bit_size() + sizeof(dense_base) * 8;
+    } else {
+        // sparsepp stores its entries plus a few bits of bookkeeping per bucket
+        return (sparse_map.size() * sizeof(std::pair<uint64_t, uint64_t>)
+                + sparse_map.bucket_count() / 2) * 8;
+    }
+}
+
+uint64_t id_index_t::serialize(std::ostream& out) const {
+    uint64_t written = 0;
+    out.write((char*)&dense,sizeof(dense));
+    written += sizeof(dense);
+    out.write((char*)&count,sizeof(count));
+    written += sizeof(count);
+    out.write((char*)&min_id,sizeof(min_id));
+    written += sizeof(min_id);
+    out.write((char*)&max_id,sizeof(max_id));
+    written += sizeof(max_id);
+    if (dense) {
+        out.write((char*)&dense_base,sizeof(dense_base));
+        written += sizeof(dense_base);
+        written += dense_iv.serialize(out);
+    } else {
+        // sorted parallel arrays of ids and ranks
+        std::vector<std::pair<uint64_t, uint64_t>> entries(sparse_map.begin(), sparse_map.end());
+        std::sort(entries.begin(), entries.end());
+        std::vector<uint64_t> ids, ranks;
+        ids.reserve(entries.size());
+        ranks.reserve(entries.size());
+        for (auto& e : entries) {
+            ids.push_back(e.first);
+            ranks.push_back(e.second);
+        }
+        written += write_array(out, ids);
+        written += write_array(out, ranks);
+    }
+    return written;
+}
+
+void id_index_t::load(std::istream& in) {
+    clear();
+    in.read((char*)&dense,sizeof(dense));
+    in.read((char*)&count,sizeof(count));
+    in.read((char*)&min_id,sizeof(min_id));
+    in.read((char*)&max_id,sizeof(max_id));
+    if (dense) {
+        in.read((char*)&dense_base,sizeof(dense_base));
+        dense_iv.load(in);
+    } else {
+        std::vector<uint64_t> ids, ranks;
+        read_array(in, ids);
+        read_array(in, ranks);
+        if (ids.size() != count || ranks.size() != count) {
+            throw std::runtime_error("[dg::id_index_t] id and rank arrays disagree with the id count");
+        }
+        sparse_map.reserve(count);
+        for (uint64_t j = 0; j < count; ++j) {
+            sparse_map.insert(std::make_pair(ids[j], ranks[j]));
+        }
+    }
+}
+
+}
@@ -0,0 +1,125 @@
+//
+//  id_index.hpp
+//
+// Maps node ids to the internal ranks of their nodes. When the ids in use are
+// compact, ranks are kept in a dense vector addressed by id; otherwise they
+// are kept in a hash map.
+//
+
+#ifndef dgraph_id_index_hpp
+#define dgraph_id_index_hpp
+
+#include <cstdio>
+#include <cstdint>
+#include <cassert>
+#include <iostream>
+#include <functional>
+#include "dynamic_structs.hpp"
+#include "hash_map.hpp"
+
+namespace dg {
+
+class id_index_t {
+
+public:
+
+    /// Check if the id is present
+    inline bool has(uint64_t id) const;
+
+    /// Get the rank of the id, which must be present
+    inline uint64_t get(uint64_t id) const;
+
+    /// Record the rank of the id, replacing any previous rank
+    void set(uint64_t id, uint64_t rank);
+
+    /// Remove the id, if it's present
+    void erase(uint64_t id);
+
+    /// Return the number of ids present
+    inline size_t size(void) const;
+
+    /// Are the ranks currently held in the dense vector?
+    inline bool is_dense(void) const;
+
+    /// Remove all ids
+    void clear(void);
+
+    /// Run the iteratee on each id and its rank, in no particular order
+    void for_each(const std::function<void(uint64_t, uint64_t)>& iteratee) const;
+
+    /// Approximate number of bits used by whichever representation is active
+    uint64_t bit_size(void) const;
+
+    /// Serialize
+    uint64_t serialize(std::ostream& out) const;
+
+    /// Load
+    void load(std::istream& in);
+
+private:
+
+    /// Switch to the dense vector once the ids span at most this many times as many slots as there are ids
+    const static uint64_t dense_max_spread = 2;
+
+    /// Fall back to the hash map once the ids span more than this many times as many slots as there are ids
+    const static uint64_t sparse_min_spread = 8;
+
+    /// Are we using the dense vector?
+    bool dense = true;
+
+    /// The id stored in the first slot of dense_iv
+    uint64_t dense_base = 0;
+
+    /// Stores rank+1 for each id from dense_base onward, with 0 marking ids that aren't present
+    SuccinctDynamicVector dense_iv;
+
+    /// Stores the ranks when the ids are too spread out for dense_iv
+    hash_map<uint64_t, uint64_t> sparse_map;
+
+    /// The number of ids present
+    uint64_t count = 0;
+
+    /// The smallest and largest ids present (not updated on removal)
+    uint64_t min_id = 0;
+    uint64_t max_id = 0;
+
+    /// Move the ranks from the hash map into the dense vector
+    void make_dense(void);
+
+    /// Move the ranks from the dense vector into the hash map
+    void make_sparse(void);
+
+    /// Grow the dense vector so that it covers the given id
+    void extend_dense(uint64_t id);
+};
+
+inline bool id_index_t::has(uint64_t id) const {
+    if (dense) {
+        return id >= dense_base
+            && id - dense_base < dense_iv.size()
+            && dense_iv.get(id - dense_base) != 0;
+    } else {
+        return sparse_map.find(id) != sparse_map.end();
+    }
+}
+
+inline uint64_t id_index_t::get(uint64_t id) const {
+    assert(has(id));
+    if (dense) {
+        return dense_iv.get(id - dense_base) - 1;
+    } else {
+        return sparse_map.find(id)->second;
+    }
+}
+
+inline size_t id_index_t::size(void) const {
+    return count;
+}
+
+inline bool id_index_t::is_dense(void) const {
+    return dense;
+}
+
+}
+
+#endif
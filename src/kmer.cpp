@@ -0,0 +1,149 @@
+//
+//  kmer.cpp
+//
+
+#include "kmer.hpp"
+#include <algorithm>
+
+namespace dg {
+
+/// The 2-bit code of each base character, with 4 for anything else
+static const struct base_codes_t {
+    uint8_t code[256];
+    base_codes_t(void) {
+        std::fill(code, code + 256, 4);
+        code['A'] = code['a'] = 0;
+        code['C'] = code['c'] = 1;
+        code['G'] = code['g'] = 2;
+        code['T'] = code['t'] = 3;
+    }
+} base_codes;
+
+/// The forward and reverse complement forms of the last k bases added, and
+/// how many of the last bases were A, C, G or T
+struct rolling_kmer_t {
+    uint64_t fwd = 0;
+    uint64_t rc = 0;
+    uint64_t run = 0;
+};
+
+/// A walk to extend: the node it last entered, the bases spelled so far from
+/// the start of the first node, the k-mer state and the edges crossed
+struct kmer_walk_t {
+    handle_t handle;
+    uint64_t length;
+    rolling_kmer_t state;
+    uint64_t edges;
+};
+
+void for_each_kmer_on_handle(const graph_t& graph, const handle_t& handle, const kmer_params_t& params,
+                             const std::function<void(const kmer_pos_t&)>& callback) {
+    const uint64_t k = params.k;
+    if (k == 0 || k > 32) {
+        throw std::runtime_error("[dg::for_each_kmer_on_handle] k must be from 1 to 32");
+    }
+    const uint64_t mask = k == 32 ? ~0ULL : (1ULL << (2 * k)) - 1;
+    const uint64_t rc_shift = 2 * (k - 1);
+    kmer_pos_t found;
+    found.id = graph.get_id(handle);
+    found.is_rev = graph.get_is_reverse(handle);
+    // add a base, and report the k-mer it ends if that k-mer is whole and
+    // starts at the given offset in the first node
+    auto push = [&](rolling_kmer_t& state, char c, uint64_t start) {
+        uint64_t code = base_codes.code[(uint8_t)c];
+        if (code > 3) {
+            state.run = 0;
+            return;
+        }
+        state.fwd = (state.fwd << 2 | code) & mask;
+        state.rc = state.rc >> 2 | (3 - code) << rc_shift;
+        if (++state.run < k) return;
+        if (params.canonical) {
+            if (state.fwd > state.rc) return;
+        }
+        found.kmer = state.fwd;
+        found.offset = start;
+        callback(found);
+    };
+    std::string sequence;
+    graph.append_sequence(handle, sequence);
+    const uint64_t first_length = sequence.size();
+    rolling_kmer_t state;
+    for (uint64_t i = 0; i < first_length; ++i) {
+        push(state, sequence[i], i + 1 - k);
+    }
+    // walks are worth extending while some k-mer starting in the first node is unfinished
+    const uint64_t last_end = first_length + k - 1;
+    if (first_length >= last_end || params.max_edges == 0) return;
+    std::vector<kmer_walk_t> stack;
+    stack.push_back({handle, first_length, state, 0});
+    while (!stack.empty()) {
+        kmer_walk_t walk = stack.back();
+        stack.pop_back();
+        graph.follow_edges_fast(walk.handle, false, [&](const handle_t& next) {
+                sequence.clear();
+                graph.append_sequence(next, sequence);
+                kmer_walk_t step = {next, walk.length, walk.state, walk.edges + 1};
+                for (uint64_t i = 0; i < sequence.size() && step.length < last_end; ++i) {
+                    ++step.length;
+                    push(step.state, sequence[i], step.length - k);
+                }
+                if (step.length < last_end && step.edges < params.max_edges) {
+                    stack.push_back(step);
+                }
+            });
+    }
+}
+
+void for_each_kmer_batch(const graph_t& graph, const kmer_params_t& params,
+                         const std::function<void(const std::vector<kmer_pos_t>&)>& callback) {
+    // check here, where it can still be thrown
+    if (params.k == 0 || params.k > 32) {
+        throw std::runtime_error("[dg::for_each_kmer_batch] k must be from 1 to 32");
+    }
+    uint64_t rank_count = graph.node_size();
+    uint64_t chunk_count = (rank_count + kmer_chunk_ranks - 1) / kmer_chunk_ranks;
+#pragma omp parallel for ordered schedule(dynamic, 1)
+    for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+        std::vector<kmer_pos_t> kmers;
+        uint64_t end = std::min(rank_count, (chunk + 1) * kmer_chunk_ranks);
+        for (uint64_t i = chunk * kmer_chunk_ranks; i < end; ++i) {
+            for (bool is_rev : {false, true}) {
+                for_each_kmer_on_handle(graph, handle_helper::pack(i, is_rev), params,
+                                        [&](const kmer_pos_t& kmer) { kmers.push_back(kmer); });
+            }
+        }
+#pragma omp ordered
+        callback(kmers);
+    }
+}
+
+std::string kmer_to_string(uint64_t kmer, uint64_t k) {
+    static const char bases[] = "ACGT";
+    std::string spelled(k, 'N');
+    for (uint64_t i = 0; i < k; ++i) {
+        spelled[k - 1 - i] = bases[kmer >> (2 * i) & 3];
+    }
+    return spelled;
+}
+
+void write_kmer_header(std::ostream& out, const kmer_params_t& params) {
+    uint64_t canonical = params.canonical;
+    out.write((char*)&kmer_format_magic, sizeof(kmer_format_magic));
+    out.write((char*)&kmer_format_version, sizeof(kmer_format_version));
+    out.write((char*)&params.k, sizeof(params.k));
+    out.write((char*)&canonical, sizeof(canonical));
+}
+
+void write_kmer_records(std::ostream& out, const std::vector<kmer_pos_t>& kmers) {
+    std::vector<uint64_t> records;
+    records.reserve(3 * kmers.size());
+    for (auto& kmer : kmers) {
+        records.push_back(kmer.kmer);
+        records.push_back(kmer.id);
+        records.push_back((uint64_t)kmer.offset << 1 | kmer.is_rev);
+    }
+    out.write((char*)records.data(), records.size() * sizeof(uint64_t));
+}
+
+}
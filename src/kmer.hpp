@@ -0,0 +1,84 @@
+#ifndef dgraph_kmer_hpp
+#define dgraph_kmer_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "graph.hpp"
+
+/** \file
+ * kmer.hpp: enumeration of the k-mers spelled by walks through a graph_t.
+ *
+ * Every k-mer starts in some oriented node and runs to the right, possibly
+ * across edges into the nodes that follow. From each oriented node, the
+ * walks that can still finish a k-mer begun in it are searched depth-first
+ * with an explicit stack. Each k-mer is built with 2-bit rolling updates of
+ * its forward and reverse complement forms as bases are added. Each prefix
+ * of a walk is searched once, so a k-mer is reported once for each distinct
+ * walk that spells it. Nodes are handled in parallel, in chunks of ranks.
+ *
+ * A serialized k-mer stream is laid out as
+ *
+ *     magic | version | k | canonical | records...
+ *
+ * with each record holding the k-mer, the node id, and the offset shifted
+ * left one bit with the reverse flag in the low bit, as 64-bit integers.
+ */
+
+namespace dg {
+
+/// Magic number opening a k-mer stream ("DGKMERS\0" in little-endian byte order)
+const uint64_t kmer_format_magic = 0x005352454D4B4744ULL;
+
+/// Version of the k-mer stream layout
+const uint64_t kmer_format_version = 1;
+
+/// Node ranks whose k-mers are collected per parallel task
+const uint64_t kmer_chunk_ranks = 256;
+
+/// A k-mer and where it starts. The k-mer is packed 2 bits a base, A=0,
+/// C=1, G=2, T=3, with its first base in the highest bits used.
+struct kmer_pos_t {
+    uint64_t kmer;
+    id_t id;
+    uint32_t offset;
+    bool is_rev;
+};
+
+/// What to enumerate
+struct kmer_params_t {
+    /// k-mer length, from 1 to 32
+    uint64_t k = 16;
+    /// leave out k-mers that cross more than this many edges
+    uint64_t max_edges = 8;
+    /// report each k-mer as the lesser of it and its reverse complement, only
+    /// from the strand that spells that form, so that the two strands of a
+    /// walk don't both report it (except for reverse complement palindromes)
+    bool canonical = false;
+};
+
+/// Call the callback on each k-mer that starts in the oriented handle.
+/// K-mers holding anything but A, C, G and T are skipped.
+void for_each_kmer_on_handle(const graph_t& graph, const handle_t& handle, const kmer_params_t& params,
+                             const std::function<void(const kmer_pos_t&)>& callback);
+
+/// Collect the k-mers that start in each chunk of node ranks, in both
+/// orientations, in parallel. The callback gets each chunk's k-mers in
+/// turn, in rank order, and is never called by two threads at once.
+void for_each_kmer_batch(const graph_t& graph, const kmer_params_t& params,
+                         const std::function<void(const std::vector<kmer_pos_t>&)>& callback);
+
+/// Spell out a packed k-mer
+std::string kmer_to_string(uint64_t kmer, uint64_t k);
+
+/// Write the header of a k-mer stream
+void write_kmer_header(std::ostream& out, const kmer_params_t& params);
+
+/// Write k-mers as records of a k-mer stream
+void write_kmer_records(std::ostream& out, const std::vector<kmer_pos_t>& kmers);
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 
 // New subcommand system provides all the subcommands that used to live here
 #include "subcommand/subcommand.hpp"
+#include "graph.hpp"
 
 using namespace std;
 using namespace dg;
@@ -50,6 +51,19 @@ int main(int argc, char *argv[]) {
     // set a higher value for tcmalloc warnings
     setenv("TCMALLOC_LARGE_ALLOC_REPORT_THRESHOLD", "1000000000000000", 1);
 
+    // --profile may appear anywhere; take it out before dispatching
+    bool profile = false;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--profile") {
+            profile = true;
+            for (int j = i; j < argc; ++j) {
+                argv[j] = argv[j+1];
+            }
+            --argc;
+            --i;
+        }
+    }
+
     if (argc == 1) {
         dg_help(argv);
         return 1;
@@ -58,7 +72,11 @@ int main(int argc, char *argv[]) {
     auto* subcommand = dg::subcommand::Subcommand::get(argc, argv);
     if (subcommand != nullptr) {
         // We found a matching subcommand, so run it
-        return (*subcommand)(argc, argv);
+        int status = (*subcommand)(argc, argv);
+        if (profile) {
+            graph_t::dump_profile(cerr);
+        }
+        return status;
     } else {
         // No subcommand found
         string command = argv[1];
@@ -0,0 +1,54 @@
+//
+//  memory_usage.cpp
+//
+
+#include "memory_usage.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace dg {
+
+void memory_usage_t::add(const memory_usage_t& child) {
+    bytes += child.bytes;
+    children.push_back(child);
+}
+
+void memory_usage_t::write_table(std::ostream& out) const {
+    write_table(out, 0);
+}
+
+void memory_usage_t::write_table(std::ostream& out, size_t depth) const {
+    out << std::string(2 * depth, ' ') << name << "\t" << bytes << std::endl;
+    for (auto& child : children) {
+        child.write_table(out, depth + 1);
+    }
+    for (auto& rate : rates) {
+        std::stringstream value;
+        value << std::fixed << std::setprecision(2) << rate.second;
+        out << std::string(2 * depth + 2, ' ') << rate.first << "\t" << value.str() << std::endl;
+    }
+}
+
+void memory_usage_t::write_json(std::ostream& out) const {
+    // names are identifiers chosen by us, so they never need escaping
+    out << "{\"name\":\"" << name << "\",\"bytes\":" << bytes;
+    if (!rates.empty()) {
+        out << ",\"rates\":{";
+        for (size_t i = 0; i < rates.size(); ++i) {
+            if (i) out << ",";
+            out << "\"" << rates[i].first << "\":" << rates[i].second;
+        }
+        out << "}";
+    }
+    if (!children.empty()) {
+        out << ",\"children\":[";
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i) out << ",";
+            children[i].write_json(out);
+        }
+        out << "]";
+    }
+    out << "}";
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef dgraph_memory_usage_hpp
+#define dgraph_memory_usage_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+/** \file
+ * memory_usage.hpp: a tree of byte counts describing what each backing
+ * structure of a graph costs.
+ */
+
+namespace dg {
+
+struct memory_usage_t {
+
+    /// the structure or group of structures being measured
+    std::string name;
+
+    /// bytes used by this structure, including everything below it
+    uint64_t bytes = 0;
+
+    /// the structures this one is made of
+    std::vector<memory_usage_t> children;
+
+    /// derived figures such as bits per node, by name
+    std::vector<std::pair<std::string, double>> rates;
+
+    memory_usage_t(void) = default;
+    memory_usage_t(const std::string& name, uint64_t bytes = 0) : name(name), bytes(bytes) { }
+
+    /// Add a finished child, counting its bytes toward ours. Later changes
+    /// to the child are not reflected here, so build trees from the leaves up.
+    void add(const memory_usage_t& child);
+
+    /// Write an indented table with one structure per line
+    void write_table(std::ostream& out) const;
+
+    /// Write the tree as a JSON object
+    void write_json(std::ostream& out) const;
+
+private:
+
+    void write_table(std::ostream& out, size_t depth) const;
+};
+
+}
+
+#endif
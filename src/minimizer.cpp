@@ -0,0 +1,345 @@
+//
+//  minimizer.cpp
+//
+
+#include "minimizer.hpp"
+#include "graph_format.hpp"
+#include "hash_map.hpp"
+#include <algorithm>
+
+namespace dg {
+
+/// Marks a k-mer that holds something other than A, C, G and T
+static const uint64_t invalid_minimizer_pos = UINT64_MAX;
+
+/// Hashed k-mers per sorting bucket are split on this many top bits
+static const uint64_t minimizer_bucket_bits = 8;
+
+/// The 2-bit code of each base character, with 4 for anything else
+static const struct minimizer_codes_t {
+    uint8_t code[256];
+    minimizer_codes_t(void) {
+        std::fill(code, code + 256, 4);
+        code['A'] = code['a'] = 0;
+        code['C'] = code['c'] = 1;
+        code['G'] = code['g'] = 2;
+        code['T'] = code['t'] = 3;
+    }
+} minimizer_codes;
+
+/// The last k bases and the last w k-mers of a sequence spelled base by base
+struct minimizer_state_t {
+    uint64_t fwd = 0;
+    uint64_t rc = 0;
+    /// how many of the last bases were A, C, G or T
+    uint64_t run = 0;
+    /// how many bases were added
+    uint64_t bases = 0;
+    /// the packed positions of the last k bases, by base count modulo k
+    uint64_t base_pos[32];
+    /// the hash and canonical start of the last w k-mers, by k-mer count modulo w
+    uint64_t kmer_hash[minimizer_max_window];
+    uint64_t kmer_pos[minimizer_max_window];
+    /// the last minimizer reported, so adjacent windows don't repeat it
+    uint64_t last_hash = 0;
+    uint64_t last_pos = invalid_minimizer_pos;
+};
+
+/// Add a base at a packed position, given also as the same base read on the
+/// other strand. Returns true and fills in the hash and canonical start of
+/// the minimizer if a window ends here with a minimizer not just reported.
+static inline bool push_minimizer_base(minimizer_state_t& state, const minimizer_params_t& params,
+                                       char c, uint64_t pos, uint64_t flipped,
+                                       uint64_t& hash, uint64_t& start) {
+    const uint64_t k = params.k, w = params.w;
+    uint64_t code = minimizer_codes.code[(uint8_t)c];
+    state.base_pos[state.bases % k] = pos;
+    ++state.bases;
+    if (code > 3) {
+        state.run = 0;
+    } else {
+        uint64_t mask = k == 32 ? ~0ULL : (1ULL << (2 * k)) - 1;
+        state.fwd = (state.fwd << 2 | code) & mask;
+        state.rc = state.rc >> 2 | (3 - code) << (2 * (k - 1));
+        ++state.run;
+    }
+    if (state.bases < k) return false;
+    uint64_t kmer_count = state.bases - k + 1;
+    uint64_t slot = (kmer_count - 1) % w;
+    if (state.run >= k) {
+        // the reverse complement starts where this k-mer ends, on the other strand
+        bool is_fwd = state.fwd <= state.rc;
+        state.kmer_hash[slot] = wang_hash_64(is_fwd ? state.fwd : state.rc);
+        state.kmer_pos[slot] = is_fwd ? state.base_pos[state.bases % k] : flipped;
+    } else {
+        state.kmer_pos[slot] = invalid_minimizer_pos;
+    }
+    if (kmer_count < w) return false;
+    uint64_t best = w;
+    // scan the window from its first k-mer, so ties go to the leftmost
+    for (uint64_t i = 0; i < w; ++i) {
+        uint64_t j = (kmer_count + i) % w;
+        if (state.kmer_pos[j] != invalid_minimizer_pos
+            && (best == w || state.kmer_hash[j] < state.kmer_hash[best])) {
+            best = j;
+        }
+    }
+    if (best == w) return false;
+    if (state.kmer_hash[best] == state.last_hash && state.kmer_pos[best] == state.last_pos) {
+        return false;
+    }
+    state.last_hash = hash = state.kmer_hash[best];
+    state.last_pos = start = state.kmer_pos[best];
+    return true;
+}
+
+/// A walk to extend, from the node it last entered
+struct minimizer_walk_t {
+    handle_t handle;
+    uint64_t edges;
+    minimizer_state_t state;
+};
+
+/// Collect the minimizers of the windows that start in an oriented node
+static void collect_minimizers(const graph_t& graph, const handle_t& handle, const minimizer_params_t& params,
+                               std::string& sequence, std::vector<minimizer_walk_t>& stack,
+                               std::vector<std::pair<uint64_t, uint64_t>>& found) {
+    uint64_t hash = 0, start = 0;
+    // add the bases of a node to a walk
+    auto spell = [&](const handle_t& h, minimizer_state_t& state, uint64_t last_end) {
+        sequence.clear();
+        graph.append_sequence(h, sequence);
+        uint64_t rank = handle_helper::unpack_number(h);
+        bool is_rev = handle_helper::unpack_bit(h);
+        uint64_t length = sequence.size();
+        for (uint64_t i = 0; i < length && state.bases < last_end; ++i) {
+            if (push_minimizer_base(state, params, sequence[i],
+                                    pack_minimizer_pos(rank, i, is_rev),
+                                    pack_minimizer_pos(rank, length - 1 - i, !is_rev),
+                                    hash, start)) {
+                found.push_back(std::make_pair(hash, start));
+            }
+        }
+    };
+    stack.clear();
+    stack.emplace_back();
+    stack.back().handle = handle;
+    stack.back().edges = 0;
+    spell(handle, stack.back().state, UINT64_MAX);
+    // walks are worth extending while some window starting in the first node is unfinished
+    const uint64_t last_end = stack.back().state.bases + params.k + params.w - 2;
+    if (stack.back().state.bases >= last_end || params.max_edges == 0) return;
+    while (!stack.empty()) {
+        minimizer_walk_t walk = stack.back();
+        stack.pop_back();
+        graph.follow_edges_fast(walk.handle, false, [&](const handle_t& next) {
+                stack.push_back(walk);
+                minimizer_walk_t& step = stack.back();
+                step.handle = next;
+                ++step.edges;
+                spell(next, step.state, last_end);
+                if (step.state.bases >= last_end || step.edges >= params.max_edges) {
+                    stack.pop_back();
+                }
+            });
+    }
+}
+
+void for_each_read_minimizer(const std::string& read, const minimizer_params_t& params,
+                             const std::function<void(uint64_t, uint64_t)>& callback) {
+    minimizer_state_t state;
+    uint64_t hash = 0, start = 0;
+    const uint64_t length = read.size();
+    for (uint64_t i = 0; i < length; ++i) {
+        // positions are packed like graph positions, with the read as a node of rank 0
+        if (push_minimizer_base(state, params, read[i], pack_minimizer_pos(0, i, false),
+                                pack_minimizer_pos(0, length - 1 - i, true), hash, start)) {
+            callback(hash, start);
+        }
+    }
+}
+
+void minimizer_index_t::build(const graph_t& graph, const minimizer_params_t& new_params) {
+    if (new_params.k == 0 || new_params.k > 32
+        || new_params.w == 0 || new_params.w > minimizer_max_window) {
+        throw std::runtime_error("[dg::minimizer_index_t] k must be from 1 to 32 and w from 1 to "
+                                 + std::to_string(minimizer_max_window));
+    }
+    uint64_t rank_count = graph.node_size();
+    // packed positions hold 31 bits of rank and 32 of offset
+    if (rank_count >= 1ULL << 31) {
+        throw std::runtime_error("[dg::minimizer_index_t] graphs of 2^31 nodes or more can't be indexed");
+    }
+    uint64_t longest = 0;
+#pragma omp parallel for schedule(static) reduction(max:longest)
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        longest = std::max(longest, (uint64_t)graph.get_length(handle_helper::pack(i, false)));
+    }
+    if (longest >= 1ULL << 32) {
+        throw std::runtime_error("[dg::minimizer_index_t] nodes of 2^32 bases or more can't be indexed");
+    }
+    params = new_params;
+    uint64_t chunk_count = (rank_count + minimizer_chunk_ranks - 1) / minimizer_chunk_ranks;
+    const uint64_t bucket_count = 1ULL << minimizer_bucket_bits;
+    const uint64_t bucket_shift = 64 - minimizer_bucket_bits;
+    // each chunk's (hash, position) pairs, and how many fall in each bucket
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> found(chunk_count);
+    std::vector<uint64_t> bucket_offsets(chunk_count * bucket_count, 0);
+#pragma omp parallel
+    {
+        std::string sequence;
+        std::vector<minimizer_walk_t> stack;
+#pragma omp for schedule(dynamic, 1)
+        for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+            auto& pairs = found[chunk];
+            uint64_t end = std::min(rank_count, (chunk + 1) * minimizer_chunk_ranks);
+            for (uint64_t i = chunk * minimizer_chunk_ranks; i < end; ++i) {
+                for (bool is_rev : {false, true}) {
+                    collect_minimizers(graph, handle_helper::pack(i, is_rev), params, sequence, stack, pairs);
+                }
+            }
+            for (auto& p : pairs) {
+                ++bucket_offsets[chunk * bucket_count + (p.first >> bucket_shift)];
+            }
+        }
+    }
+    // lay the buckets out one after another, with each chunk's share in chunk order
+    std::vector<uint64_t> bucket_begin(bucket_count + 1, 0);
+    uint64_t total = 0;
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        bucket_begin[b] = total;
+        for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+            uint64_t count = bucket_offsets[chunk * bucket_count + b];
+            bucket_offsets[chunk * bucket_count + b] = total;
+            total += count;
+        }
+    }
+    bucket_begin[bucket_count] = total;
+    std::vector<std::pair<uint64_t, uint64_t>> all(total);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+        uint64_t* offsets = &bucket_offsets[chunk * bucket_count];
+        for (auto& p : found[chunk]) {
+            all[offsets[p.first >> bucket_shift]++] = p;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>>().swap(found[chunk]);
+    }
+    // sort each bucket, dropping the hits found from several walks
+    std::vector<uint64_t> bucket_size(bucket_count);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        auto begin = all.begin() + bucket_begin[b];
+        auto end = all.begin() + bucket_begin[b + 1];
+        std::sort(begin, end);
+        bucket_size[b] = std::unique(begin, end) - begin;
+    }
+    // the buckets are in hash order, so the runs of each hash come out in order
+    std::vector<uint64_t> keys;
+    hits.clear();
+    hit_offsets.clear();
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        for (uint64_t i = bucket_begin[b]; i < bucket_begin[b] + bucket_size[b]; ++i) {
+            if (keys.empty() || all[i].first != keys.back()) {
+                keys.push_back(all[i].first);
+                hit_offsets.push_back(hits.size());
+            }
+            hits.push_back(all[i].second);
+        }
+    }
+    hit_offsets.push_back(hits.size());
+    std::vector<std::pair<uint64_t, uint64_t>>().swap(all);
+    // place each distinct hash in a table at most half full
+    uint64_t capacity = 16;
+    while (capacity < 2 * keys.size()) capacity *= 2;
+    slot_keys.assign(capacity, 0);
+    slot_entries.assign(capacity, 0);
+    for (uint64_t i = 0; i < keys.size(); ++i) {
+        uint64_t slot = find_slot(keys[i]);
+        slot_keys[slot] = keys[i];
+        slot_entries[slot] = i + 1;
+    }
+}
+
+std::pair<const uint64_t*, const uint64_t*> minimizer_index_t::find(uint64_t hash) const {
+    if (slot_keys.empty()) {
+        return std::make_pair(hits.data(), hits.data());
+    }
+    uint64_t entry = slot_entries[find_slot(hash)];
+    if (!entry) {
+        return std::make_pair(hits.data(), hits.data());
+    }
+    return std::make_pair(hits.data() + hit_offsets[entry - 1], hits.data() + hit_offsets[entry]);
+}
+
+void minimizer_index_t::find_batch(const std::vector<std::string>& reads,
+                                   std::vector<std::vector<minimizer_match_t>>& matches,
+                                   uint64_t max_hits) const {
+    matches.clear();
+    matches.resize(reads.size());
+#pragma omp parallel
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> minimizers;
+#pragma omp for schedule(dynamic, 16)
+        for (uint64_t r = 0; r < reads.size(); ++r) {
+            minimizers.clear();
+            for_each_read_minimizer(reads[r], params, [&](uint64_t hash, uint64_t pos) {
+                    minimizers.push_back(std::make_pair(hash, pos));
+                });
+            if (slot_keys.empty()) continue;
+            // start every probe of the read before the first one is needed
+            uint64_t mask = slot_keys.size() - 1;
+            for (auto& m : minimizers) {
+                __builtin_prefetch(&slot_keys[m.first & mask]);
+                __builtin_prefetch(&slot_entries[m.first & mask]);
+            }
+            auto& read_matches = matches[r];
+            for (auto& m : minimizers) {
+                auto range = find(m.first);
+                uint64_t count = range.second - range.first;
+                if (max_hits && count > max_hits) continue;
+                for (const uint64_t* hit = range.first; hit < range.second; ++hit) {
+                    read_matches.push_back({m.first, m.second, *hit});
+                }
+            }
+        }
+    }
+}
+
+uint64_t minimizer_index_t::serialize(std::ostream& out) const {
+    uint64_t written = 0;
+    for (uint64_t value : {minimizer_format_magic, minimizer_format_version,
+                           params.k, params.w, params.max_edges}) {
+        out.write((char*)&value, sizeof(value));
+        written += sizeof(value);
+    }
+    written += write_array(out, slot_keys);
+    written += write_array(out, slot_entries);
+    written += write_array(out, hit_offsets);
+    written += write_array(out, hits);
+    return written;
+}
+
+void minimizer_index_t::load(std::istream& in) {
+    uint64_t magic = 0, version = 0;
+    in.read((char*)&magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    if (!in || magic != minimizer_format_magic) {
+        throw std::runtime_error("[dg::minimizer_index_t] input is not a serialized minimizer index");
+    }
+    if (version != minimizer_format_version) {
+        throw std::runtime_error("[dg::minimizer_index_t] unsupported minimizer index version " + std::to_string(version));
+    }
+    in.read((char*)&params.k, sizeof(params.k));
+    in.read((char*)&params.w, sizeof(params.w));
+    in.read((char*)&params.max_edges, sizeof(params.max_edges));
+    read_array(in, slot_keys);
+    read_array(in, slot_entries);
+    read_array(in, hit_offsets);
+    read_array(in, hits);
+    if (hit_offsets.empty() || slot_keys.size() != slot_entries.size()
+        || (slot_keys.size() & (slot_keys.size() - 1))) {
+        throw std::runtime_error("[dg::minimizer_index_t] malformed minimizer index");
+    }
+}
+
+}
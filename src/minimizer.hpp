@@ -0,0 +1,176 @@
+#ifndef dgraph_minimizer_hpp
+#define dgraph_minimizer_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <functional>
+#include "graph.hpp"
+
+/** \file
+ * minimizer.hpp: a (w,k)-minimizer index of a graph_t, for seeding read
+ * mappings.
+ *
+ * A window is w consecutive k-mers, spelled along a node or a walk across
+ * edges. Its minimizer is the k-mer whose canonical form has the smallest
+ * hash, the leftmost one on a tie. Windows holding no k-mer free of N have
+ * none. The graph's windows are found the way kmer.hpp finds k-mers. From
+ * each oriented node, the walks out to the end of the last window starting
+ * in it are searched with an explicit stack. Nodes are handled in parallel,
+ * in chunks of ranks.
+ *
+ * A hit is a packed position (node rank, offset, strand) from which the
+ * canonical form of the minimizer is spelled going right. The positions
+ * are ranks, so an index only fits the graph it was built from until the
+ * graph is changed.
+ *
+ * The hits are sorted by hash in parallel. Each distinct hash is placed in
+ * an open addressing table that points at the run of hits with that hash.
+ * A serialized index is laid out as
+ *
+ *     magic | version | k | w | max_edges | slot keys | slot entries | hit offsets | hits
+ *
+ * with each array written as its length and then its values.
+ */
+
+namespace dg {
+
+/// Magic number opening a serialized minimizer index ("DGMINIDX" in little-endian byte order)
+const uint64_t minimizer_format_magic = 0x5844494E494D4744ULL;
+
+/// Version of the minimizer index layout
+const uint64_t minimizer_format_version = 1;
+
+/// Node ranks whose minimizers are collected per parallel task
+const uint64_t minimizer_chunk_ranks = 256;
+
+/// The widest window, in k-mers
+const uint64_t minimizer_max_window = 64;
+
+/// What to index
+struct minimizer_params_t {
+    /// k-mer length, from 1 to 32
+    uint64_t k = 15;
+    /// k-mers per window, from 1 to minimizer_max_window
+    uint64_t w = 10;
+    /// leave out windows that cross more than this many edges
+    uint64_t max_edges = 8;
+};
+
+/// Pack a graph position into one integer. Ranks must be below 2^31, and
+/// offsets below 2^32.
+inline uint64_t pack_minimizer_pos(uint64_t rank, uint64_t offset, bool is_rev) {
+    return rank << 33 | offset << 1 | is_rev;
+}
+
+inline uint64_t minimizer_pos_rank(uint64_t pos) {
+    return pos >> 33;
+}
+
+inline uint64_t minimizer_pos_offset(uint64_t pos) {
+    return pos >> 1 & 0xFFFFFFFFULL;
+}
+
+inline bool minimizer_pos_is_rev(uint64_t pos) {
+    return pos & 1;
+}
+
+/// A minimizer of a read and one graph position where it occurs. Both
+/// positions are packed the same way, with the read as a node of rank 0.
+/// Each is the offset, on the strand given, at which the canonical form of
+/// the minimizer starts and is spelled going right. Offsets on a reverse
+/// strand count from the end of the forward sequence, so a reverse position
+/// at offset o starts at forward base length - 1 - o and reads leftwards.
+struct minimizer_match_t {
+    uint64_t hash;
+    uint64_t read_pos;
+    uint64_t graph_pos;
+};
+
+/// Call the callback on the hash and packed read position (as in
+/// minimizer_match_t) of each minimizer of a read, in order, with repeats
+/// from adjacent windows left out
+void for_each_read_minimizer(const std::string& read, const minimizer_params_t& params,
+                             const std::function<void(uint64_t, uint64_t)>& callback);
+
+class minimizer_index_t {
+
+public:
+
+    /// Index the minimizers of the graph, in parallel, replacing any held.
+    /// Throws if a node rank or offset won't fit in a packed position.
+    void build(const graph_t& graph, const minimizer_params_t& params);
+
+    /// Get the hits of a minimizer hash as a range of packed positions, in
+    /// increasing order. The range is empty if the hash isn't present.
+    std::pair<const uint64_t*, const uint64_t*> find(uint64_t hash) const;
+
+    /// Find the minimizers of many reads and look them up, in parallel.
+    /// Each read's matches are left in matches at the read's index, in
+    /// read order. Minimizers with more than max_hits hits are skipped,
+    /// unless max_hits is 0.
+    void find_batch(const std::vector<std::string>& reads,
+                    std::vector<std::vector<minimizer_match_t>>& matches,
+                    uint64_t max_hits = 0) const;
+
+    /// The parameters the index was built with
+    inline const minimizer_params_t& get_params(void) const;
+
+    /// Return the number of distinct minimizers
+    inline uint64_t size(void) const;
+
+    /// Return the number of hits
+    inline uint64_t hit_count(void) const;
+
+    /// Serialize
+    uint64_t serialize(std::ostream& out) const;
+
+    /// Load
+    void load(std::istream& in);
+
+private:
+
+    minimizer_params_t params;
+
+    /// The hash held in each slot of the table
+    std::vector<uint64_t> slot_keys;
+
+    /// The index of the hash's hits in hit_offsets plus 1 for each slot, with 0 for empty slots
+    std::vector<uint64_t> slot_entries;
+
+    /// The hits of the i-th distinct hash are hits[hit_offsets[i]] up to hits[hit_offsets[i+1]]
+    std::vector<uint64_t> hit_offsets = {0};
+
+    /// Packed graph positions, grouped by hash
+    std::vector<uint64_t> hits;
+
+    /// Find the slot holding the hash, or the empty slot where it would go
+    inline uint64_t find_slot(uint64_t hash) const;
+};
+
+inline const minimizer_params_t& minimizer_index_t::get_params(void) const {
+    return params;
+}
+
+inline uint64_t minimizer_index_t::size(void) const {
+    return hit_offsets.size() - 1;
+}
+
+inline uint64_t minimizer_index_t::hit_count(void) const {
+    return hits.size();
+}
+
+inline uint64_t minimizer_index_t::find_slot(uint64_t hash) const {
+    uint64_t mask = slot_keys.size() - 1;
+    uint64_t slot = hash & mask;
+    while (slot_entries[slot] && slot_keys[slot] != hash) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+}
+
+#endif
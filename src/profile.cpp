@@ -0,0 +1,108 @@
+//
+//  profile.cpp
+//
+
+#include "profile.hpp"
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <mutex>
+
+namespace dg {
+
+const char* profile_event_name(profile_event_t event) {
+    static const char* names[PROF_COUNT] = {
+        "id_lookup",
+        "edge_select",
+        "edge_insert",
+        "edge_remove",
+        "seq_select",
+        "seq_decode",
+        "seq_insert",
+        "seq_remove",
+        "path_select",
+        "path_insert",
+        "path_remove",
+        "path_map_lookup"
+    };
+    return event < PROF_COUNT ? names[event] : "unknown";
+}
+
+#ifdef DG_PROFILE
+
+/// Every thread's counters. They are never freed, so that the counts of
+/// finished threads still get reported.
+static std::vector<profile_counters_t*>& profile_registry(void) {
+    static std::vector<profile_counters_t*> registry;
+    return registry;
+}
+
+static std::mutex& profile_registry_mutex(void) {
+    static std::mutex mutex;
+    return mutex;
+}
+
+profile_counters_t& thread_profile_counters(void) {
+    static thread_local profile_counters_t* counters = nullptr;
+    if (!counters) {
+        counters = new profile_counters_t();
+        std::lock_guard<std::mutex> guard(profile_registry_mutex());
+        profile_registry().push_back(counters);
+    }
+    return *counters;
+}
+
+bool profile_enabled(void) {
+    return true;
+}
+
+void dump_profile(std::ostream& out) {
+    profile_counters_t total;
+    {
+        std::lock_guard<std::mutex> guard(profile_registry_mutex());
+        for (auto counters : profile_registry()) {
+            for (size_t i = 0; i < PROF_COUNT; ++i) {
+                total.count[i] += counters->count[i];
+                total.ticks[i] += counters->ticks[i];
+            }
+        }
+    }
+    std::stringstream ss;
+    ss << std::left << std::setw(20) << "event"
+       << std::right << std::setw(16) << "count"
+       << std::setw(20) << "ticks"
+       << std::setw(14) << "ticks/op" << std::endl;
+    ss << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < PROF_COUNT; ++i) {
+        if (!total.count[i]) continue;
+        ss << std::left << std::setw(20) << profile_event_name((profile_event_t)i)
+           << std::right << std::setw(16) << total.count[i]
+           << std::setw(20) << total.ticks[i]
+           << std::setw(14) << (double)total.ticks[i] / total.count[i] << std::endl;
+    }
+    out << ss.str();
+}
+
+void reset_profile(void) {
+    std::lock_guard<std::mutex> guard(profile_registry_mutex());
+    for (auto counters : profile_registry()) {
+        *counters = profile_counters_t();
+    }
+}
+
+#else
+
+bool profile_enabled(void) {
+    return false;
+}
+
+void dump_profile(std::ostream& out) {
+    out << "profiling is not compiled in; configure with -DDG_PROFILE=ON" << std::endl;
+}
+
+void reset_profile(void) {
+}
+
+#endif
+
+}
@@ -0,0 +1,126 @@
+#ifndef dgraph_profile_hpp
+#define dgraph_profile_hpp
+
+#include <cstdint>
+#include <iostream>
+
+/** \file
+ * profile.hpp: optional counters and cycle timers around the succinct
+ * primitives that graph_t is built from.
+ *
+ * Instrumentation is only compiled in when DG_PROFILE is defined (configure
+ * with -DDG_PROFILE=ON). Otherwise DG_PROFILE_SCOPE expands to nothing and
+ * DG_PROFILE_EXPR to the bare expression. Counters are kept per thread and
+ * summed when they are reported.
+ */
+
+#ifdef DG_PROFILE
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace dg {
+
+/// The instrumented kinds of primitive operation
+enum profile_event_t {
+    /// id to rank lookups in the id index
+    PROF_ID_LOOKUP = 0,
+    /// select on the edge delimiter bitvectors
+    PROF_EDGE_SELECT,
+    /// insertions into the edge vectors
+    PROF_EDGE_INSERT,
+    /// removals from the edge vectors
+    PROF_EDGE_REMOVE,
+    /// select on the sequence delimiter bitvector
+    PROF_SEQ_SELECT,
+    /// decoding node sequences out of seq_pv
+    PROF_SEQ_DECODE,
+    /// insertions into the sequence vectors
+    PROF_SEQ_INSERT,
+    /// removals from the sequence vectors
+    PROF_SEQ_REMOVE,
+    /// select on the path handle wavelet tree
+    PROF_PATH_SELECT,
+    /// insertions into the path vectors
+    PROF_PATH_INSERT,
+    /// removals from the path vectors
+    PROF_PATH_REMOVE,
+    /// lookups in the path name and path metadata hash maps
+    PROF_PATH_MAP_LOOKUP,
+    /// number of events
+    PROF_COUNT
+};
+
+/// Printable name of an event
+const char* profile_event_name(profile_event_t event);
+
+/// Write the summed counts and timings of every event that occurred
+void dump_profile(std::ostream& out);
+
+/// Zero the counters of every thread
+void reset_profile(void);
+
+/// Is the instrumentation compiled in?
+bool profile_enabled(void);
+
+#ifdef DG_PROFILE
+
+/// One thread's counters
+struct profile_counters_t {
+    uint64_t count[PROF_COUNT] = {};
+    uint64_t ticks[PROF_COUNT] = {};
+};
+
+/// The calling thread's counters, registered for reporting on first use
+profile_counters_t& thread_profile_counters(void);
+
+/// A cheap monotonic tick: the cycle counter where there is one
+inline uint64_t profile_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// Counts an event and times it until the end of the scope
+class profile_scope_t {
+public:
+    inline profile_scope_t(profile_event_t event) : event(event), start(profile_ticks()) { }
+    inline ~profile_scope_t(void) {
+        profile_counters_t& counters = thread_profile_counters();
+        ++counters.count[event];
+        counters.ticks[event] += profile_ticks() - start;
+    }
+private:
+    profile_event_t event;
+    uint64_t start;
+};
+
+/// Evaluate the function as one timed event
+template<typename F>
+inline auto profile_call(profile_event_t event, F&& f) -> decltype(f()) {
+    profile_scope_t scope(event);
+    return f();
+}
+
+#define DG_PROFILE_CONCAT_(a, b) a##b
+#define DG_PROFILE_CONCAT(a, b) DG_PROFILE_CONCAT_(a, b)
+/// Time the rest of the enclosing scope as one event
+#define DG_PROFILE_SCOPE(event) ::dg::profile_scope_t DG_PROFILE_CONCAT(dg_profile_scope_, __LINE__)(event)
+/// Time the evaluation of an expression as one event
+#define DG_PROFILE_EXPR(event, expr) (::dg::profile_call(event, [&]() { return (expr); }))
+
+#else
+
+#define DG_PROFILE_SCOPE(event)
+#define DG_PROFILE_EXPR(event, expr) (expr)
+
+#endif
+
+}
+
+#endif
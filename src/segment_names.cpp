@@ -0,0 +1,105 @@
+//
+//  segment_names.cpp
+//
+
+#include "segment_names.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace dg {
+
+/// FNV-1a over the bytes of a name
+static inline uint64_t hash_name(const char* name, uint64_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t i = 0; i < length; ++i) {
+        hash ^= (uint8_t)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t segment_names_t::find_slot(const char* name, uint64_t length) const {
+    uint64_t mask = slots.size() - 1;
+    uint64_t slot = hash_name(name, length) & mask;
+    while (slots[slot]) {
+        uint64_t begin = offsets[slots[slot] - 1];
+        uint64_t end = offsets[slots[slot]];
+        if (end - begin == length && std::memcmp(pool.data() + begin, name, length) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void segment_names_t::grow(void) {
+    std::vector<uint32_t> old_slots(std::max((uint64_t)1024, 2 * (uint64_t)slots.size()), 0);
+    std::swap(slots, old_slots);
+    for (auto id : old_slots) {
+        if (id) {
+            slots[find_slot(pool.data() + offsets[id - 1], offsets[id] - offsets[id - 1])] = id;
+        }
+    }
+}
+
+id_t segment_names_t::intern(const char* name, uint64_t length) {
+    // keep the table at most half full
+    if (2 * (size() + 1) > slots.size()) {
+        grow();
+    }
+    uint64_t slot = find_slot(name, length);
+    if (!slots[slot]) {
+        if (size() == std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("[dg::segment_names_t] too many names");
+        }
+        pool.append(name, length);
+        offsets.push_back(pool.size());
+        slots[slot] = size();
+    }
+    return slots[slot];
+}
+
+id_t segment_names_t::get_id(const std::string& name) const {
+    if (slots.empty()) return 0;
+    return slots[find_slot(name.data(), name.size())];
+}
+
+std::string segment_names_t::get_name(id_t id) const {
+    return pool.substr(offsets[id - 1], offsets[id] - offsets[id - 1]);
+}
+
+void segment_names_t::clear(void) {
+    pool.clear();
+    offsets = {0};
+    slots.clear();
+}
+
+void segment_names_t::serialize(std::ostream& out) const {
+    std::string line;
+    for (uint64_t id = 1; id <= size(); ++id) {
+        line.assign(pool, offsets[id - 1], offsets[id] - offsets[id - 1]);
+        line.push_back('\t');
+        line.append(std::to_string(id));
+        line.push_back('\n');
+        out.write(line.data(), line.size());
+    }
+}
+
+void segment_names_t::load(std::istream& in) {
+    clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        // each line must give a new name the next id
+        size_t tab = line.rfind('\t');
+        uint64_t next_id = size() + 1;
+        if (tab == std::string::npos
+            || line.compare(tab + 1, std::string::npos, std::to_string(next_id)) != 0
+            || intern(line.data(), tab) != next_id) {
+            throw std::runtime_error("[dg::segment_names_t] bad name table line: " + line);
+        }
+    }
+}
+
+}
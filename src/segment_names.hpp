@@ -0,0 +1,70 @@
+//
+//  segment_names.hpp
+//
+// Translates the segment names of a GFA file into dense node ids. Names are
+// interned back to back in one string pool, and found through an open
+// addressing table of ids hashed on the name bytes, so no name costs more
+// than its characters and a few words.
+//
+
+#ifndef dgraph_segment_names_hpp
+#define dgraph_segment_names_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "handle.hpp"
+
+namespace dg {
+
+class segment_names_t {
+
+public:
+
+    /// Get the id of a name, giving the name the next id, from 1 up, if it's new
+    id_t intern(const char* name, uint64_t length);
+
+    /// Get the id of a name, or 0 if it has none
+    id_t get_id(const std::string& name) const;
+
+    /// Get the name with the given id, which must have been handed out
+    std::string get_name(id_t id) const;
+
+    /// Return the number of names
+    inline uint64_t size(void) const;
+
+    /// Remove all names
+    void clear(void);
+
+    /// Write the table as lines of name and id, tab-separated, in id order
+    void serialize(std::ostream& out) const;
+
+    /// Load a table written by serialize, replacing the names held
+    void load(std::istream& in);
+
+private:
+
+    /// The names, back to back
+    std::string pool;
+
+    /// Where the name of each id starts in the pool, with the end of the pool last
+    std::vector<uint64_t> offsets = {0};
+
+    /// The id of each name at the slot for its hash or after it, with 0 for empty slots
+    std::vector<uint32_t> slots;
+
+    /// Find the slot holding the name, or the empty slot where it would go
+    uint64_t find_slot(const char* name, uint64_t length) const;
+
+    /// Double the table and place the ids again
+    void grow(void);
+};
+
+inline uint64_t segment_names_t::size(void) const {
+    return offsets.size() - 1;
+}
+
+}
+
+#endif
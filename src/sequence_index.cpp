@@ -0,0 +1,127 @@
+//
+//  sequence_index.cpp
+//
+
+#include "sequence_index.hpp"
+#include "graph_format.hpp"
+#include "sdsl/construct.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace dg {
+
+void sequence_index_t::build(const graph_t& graph) {
+    uint64_t rank_count = graph.node_size();
+    uint64_t chunk_count = (rank_count + sequence_index_chunk_ranks - 1) / sequence_index_chunk_ranks;
+    // each oriented node takes its length plus a separator, on both strands
+    node_starts.assign(2 * rank_count + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+        uint64_t end = std::min(rank_count, (chunk + 1) * sequence_index_chunk_ranks);
+        for (uint64_t i = chunk * sequence_index_chunk_ranks; i < end; ++i) {
+            uint64_t length = graph.get_length(handle_helper::pack(i, false)) + 1;
+            node_starts[i + 1] = length;
+            node_starts[rank_count + i + 1] = length;
+        }
+    }
+    for (uint64_t i = 1; i < node_starts.size(); ++i) {
+        node_starts[i] += node_starts[i - 1];
+    }
+    std::string text(node_starts.back(), sequence_index_separator);
+#pragma omp parallel
+    {
+        std::string sequence;
+#pragma omp for schedule(dynamic, 1)
+        for (uint64_t chunk = 0; chunk < chunk_count; ++chunk) {
+            uint64_t end = std::min(rank_count, (chunk + 1) * sequence_index_chunk_ranks);
+            for (uint64_t i = chunk * sequence_index_chunk_ranks; i < end; ++i) {
+                for (bool is_rev : {false, true}) {
+                    sequence.clear();
+                    graph.append_sequence(handle_helper::pack(i, is_rev), sequence);
+                    std::memcpy(&text[node_starts[is_rev * rank_count + i]], sequence.data(), sequence.size());
+                }
+            }
+        }
+    }
+    csa = sdsl::csa_wt<>();
+    if (!text.empty()) {
+        sdsl::construct_im(csa, text, 1);
+    }
+}
+
+bool sequence_index_t::normalize(const std::string& pattern, std::string& normal) const {
+    if (pattern.empty() || node_count() == 0) return false;
+    normal.resize(pattern.size());
+    for (uint64_t i = 0; i < pattern.size(); ++i) {
+        char c = std::toupper((unsigned char)pattern[i]);
+        if (c == sequence_index_separator || c == '\0') return false;
+        normal[i] = c;
+    }
+    return true;
+}
+
+std::vector<std::pair<handle_t, uint64_t>> sequence_index_t::locate(const std::string& pattern) const {
+    std::vector<std::pair<handle_t, uint64_t>> hits;
+    std::string normal;
+    if (!normalize(pattern, normal)) return hits;
+    auto occurrences = sdsl::locate(csa, normal.begin(), normal.end());
+    uint64_t rank_count = node_count();
+    hits.reserve(occurrences.size());
+    for (uint64_t pos : occurrences) {
+        uint64_t i = std::upper_bound(node_starts.begin(), node_starts.end(), pos) - node_starts.begin() - 1;
+        bool is_rev = i >= rank_count;
+        hits.push_back(std::make_pair(handle_helper::pack(is_rev ? i - rank_count : i, is_rev),
+                                      pos - node_starts[i]));
+    }
+    std::sort(hits.begin(), hits.end(), [](const std::pair<handle_t, uint64_t>& a,
+                                           const std::pair<handle_t, uint64_t>& b) {
+                  return as_integer(a.first) < as_integer(b.first)
+                      || (a.first == b.first && a.second < b.second);
+              });
+    return hits;
+}
+
+uint64_t sequence_index_t::count(const std::string& pattern) const {
+    std::string normal;
+    if (!normalize(pattern, normal)) return 0;
+    return sdsl::count(csa, normal.begin(), normal.end());
+}
+
+uint64_t sequence_index_t::serialize(std::ostream& out) const {
+    uint64_t written = 0;
+    out.write((char*)&sequence_index_format_magic, sizeof(sequence_index_format_magic));
+    out.write((char*)&sequence_index_format_version, sizeof(sequence_index_format_version));
+    written += sizeof(sequence_index_format_magic) + sizeof(sequence_index_format_version);
+    written += write_array(out, node_starts);
+    // an empty text has no suffix array
+    if (node_starts.back() > 0) {
+        written += csa.serialize(out);
+    }
+    return written;
+}
+
+void sequence_index_t::load(std::istream& in) {
+    uint64_t magic = 0, version = 0;
+    in.read((char*)&magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    if (!in || magic != sequence_index_format_magic) {
+        throw std::runtime_error("[dg::sequence_index_t] input is not a serialized sequence index");
+    }
+    if (version != sequence_index_format_version) {
+        throw std::runtime_error("[dg::sequence_index_t] unsupported sequence index version " + std::to_string(version));
+    }
+    read_array(in, node_starts);
+    if (node_starts.size() % 2 == 0) {
+        throw std::runtime_error("[dg::sequence_index_t] malformed sequence index");
+    }
+    csa = sdsl::csa_wt<>();
+    if (node_starts.back() > 0) {
+        csa.load(in);
+    }
+    if (!in) {
+        throw std::runtime_error("[dg::sequence_index_t] sequence index is truncated");
+    }
+}
+
+}
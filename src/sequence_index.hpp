@@ -0,0 +1,91 @@
+#ifndef dgraph_sequence_index_hpp
+#define dgraph_sequence_index_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include "graph.hpp"
+#include "sdsl/suffix_arrays.hpp"
+
+/** \file
+ * sequence_index.hpp: a static FM-index of the node sequences of a graph_t,
+ * for finding exact matches of short sequences such as primers and probes.
+ *
+ * The indexed text holds each node's forward sequence, in rank order, then
+ * each node's reverse complement, also in rank order, each followed by a
+ * separator that no pattern holds. Every match therefore lies within one
+ * oriented node, and matches on both strands are found without searching
+ * the pattern's reverse complement. The text is spelled in parallel, in
+ * chunks of ranks, and the compressed suffix array (sdsl's csa_wt) is then
+ * built over it. The index is separate from the graph and is built on
+ * request. It refers to nodes by rank, so it only fits the graph it was
+ * built from until the graph is changed.
+ *
+ * A serialized index is laid out as
+ *
+ *     magic | version | node starts | compressed suffix array
+ *
+ * with the node starts written as their length and then their values.
+ */
+
+namespace dg {
+
+/// Magic number opening a serialized sequence index ("DGSEQIDX" in little-endian byte order)
+const uint64_t sequence_index_format_magic = 0x5844495145534744ULL;
+
+/// Version of the sequence index layout
+const uint64_t sequence_index_format_version = 1;
+
+/// Node ranks whose sequences are spelled per parallel task
+const uint64_t sequence_index_chunk_ranks = 1024;
+
+/// Follows each oriented node in the indexed text
+const char sequence_index_separator = '#';
+
+class sequence_index_t {
+
+public:
+
+    /// Index the sequences of the graph's nodes on both strands, replacing any held
+    void build(const graph_t& graph);
+
+    /// Get each oriented node and offset where the pattern starts, sorted
+    /// by rank, orientation and offset. A hit on a reverse handle means the
+    /// pattern is spelled by the node's reverse complement.
+    std::vector<std::pair<handle_t, uint64_t>> locate(const std::string& pattern) const;
+
+    /// Return the number of places the pattern occurs, on either strand
+    uint64_t count(const std::string& pattern) const;
+
+    /// Return the number of nodes indexed
+    inline uint64_t node_count(void) const;
+
+    /// Serialize
+    uint64_t serialize(std::ostream& out) const;
+
+    /// Load
+    void load(std::istream& in);
+
+private:
+
+    /// The compressed suffix array of the text
+    sdsl::csa_wt<> csa;
+
+    /// Where each oriented node starts in the text, forward strands first,
+    /// then reverse, with the end of the text last
+    std::vector<uint64_t> node_starts = {0};
+
+    /// Put the pattern in the form the text is spelled in, or return false
+    /// if it can't occur
+    bool normalize(const std::string& pattern, std::string& normal) const;
+};
+
+inline uint64_t sequence_index_t::node_count(void) const {
+    return (node_starts.size() - 1) / 2;
+}
+
+}
+
+#endif
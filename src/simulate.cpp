@@ -0,0 +1,201 @@
+//
+//  simulate.cpp
+//
+
+#include "simulate.hpp"
+#include <random>
+#include <vector>
+#include <algorithm>
+
+namespace dg {
+
+/// The kinds of variant site, and how many nodes each one adds
+enum site_type_t : uint8_t {
+    SITE_SNP = 0,       // ref, alt
+    SITE_INDEL = 1,     // optional node
+    SITE_INVERSION = 2  // node taken in either orientation
+};
+
+struct site_t {
+    /// id of the first node of the site
+    uint64_t id;
+    site_type_t type;
+};
+
+/// splitmix64, used to make per-site and per-haplotype choices that can be
+/// recomputed when the paths are walked without storing them
+static inline uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/// Does the haplotype carry the alternate allele at the site?
+static inline bool takes_alt(uint64_t seed, uint64_t site, uint64_t hap) {
+    // alt allele frequencies are spread evenly across (0.05, 0.95)
+    double freq = 0.05 + 0.9 * (mix(seed ^ mix(site)) >> 11) * (1.0 / (1ULL << 53));
+    double draw = (mix(mix(seed + hap) ^ mix(site)) >> 11) * (1.0 / (1ULL << 53));
+    return draw < freq;
+}
+
+void simulate_graph(const simulate_params_t& params,
+                    const std::function<void(uint64_t id, const std::string& seq)>& on_node,
+                    const std::function<void(uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev)>& on_edge,
+                    const std::function<void(const std::string& path_name, uint64_t id, bool is_rev)>& on_step) {
+    std::mt19937_64 rng(params.seed);
+    uint64_t mean = std::max<uint64_t>(1, params.node_length);
+    std::uniform_int_distribution<uint64_t> uniform_length(1, 2 * mean - 1);
+    std::geometric_distribution<uint64_t> geometric_length(1.0 / mean);
+    std::uniform_int_distribution<uint64_t> indel_length(1, std::max<uint64_t>(1, params.max_indel));
+    std::uniform_int_distribution<int> base(0, 3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto node_length = [&](void) -> uint64_t {
+        switch (params.node_length_dist) {
+        case NODE_LENGTH_FIXED:
+            return mean;
+        case NODE_LENGTH_GEOMETRIC:
+            return 1 + geometric_length(rng);
+        default:
+            return uniform_length(rng);
+        }
+    };
+    std::string seq;
+    auto random_seq = [&](uint64_t length) -> const std::string& {
+        seq.resize(length);
+        for (auto& c : seq) c = "ACGT"[base(rng)];
+        return seq;
+    };
+    double site_rate = params.snp_rate + params.indel_rate + params.inversion_rate;
+
+    // lay out the graph, remembering only where the sites are
+    std::vector<site_t> sites;
+    // node ends that should be joined to the next backbone node
+    std::vector<std::pair<uint64_t, bool>> tails;
+    uint64_t next_id = 1;
+    uint64_t pos = 0;
+    while (true) {
+        // a backbone node
+        uint64_t remaining = pos < params.length ? params.length - pos : 1;
+        uint64_t length = std::max<uint64_t>(1, std::min(node_length(), remaining));
+        uint64_t anchor = next_id++;
+        on_node(anchor, random_seq(length));
+        for (auto& t : tails) {
+            on_edge(t.first, t.second, anchor, false);
+        }
+        tails.clear();
+        tails.push_back(std::make_pair(anchor, false));
+        pos += length;
+        // the graph always ends on a backbone node
+        if (pos >= params.length) break;
+        // which may be followed by a site
+        if (unit(rng) >= site_rate * length) continue;
+        double kind = unit(rng) * site_rate;
+        if (kind < params.snp_rate) {
+            uint64_t ref = next_id++;
+            uint64_t alt = next_id++;
+            int b = base(rng);
+            on_node(ref, std::string(1, "ACGT"[b]));
+            on_node(alt, std::string(1, "ACGT"[(b + 1 + base(rng) % 3) % 4]));
+            on_edge(anchor, false, ref, false);
+            on_edge(anchor, false, alt, false);
+            tails = { std::make_pair(ref, false), std::make_pair(alt, false) };
+            sites.push_back({ ref, SITE_SNP });
+            pos += 1;
+        } else if (kind < params.snp_rate + params.indel_rate) {
+            uint64_t indel = next_id++;
+            on_node(indel, random_seq(indel_length(rng)));
+            on_edge(anchor, false, indel, false);
+            // the anchor stays in the tails, making the node skippable
+            tails.push_back(std::make_pair(indel, false));
+            sites.push_back({ indel, SITE_INDEL });
+        } else {
+            uint64_t inv = next_id++;
+            uint64_t inv_length = node_length();
+            on_node(inv, random_seq(inv_length));
+            on_edge(anchor, false, inv, false);
+            on_edge(anchor, false, inv, true);
+            tails = { std::make_pair(inv, false), std::make_pair(inv, true) };
+            sites.push_back({ inv, SITE_INVERSION });
+            pos += inv_length;
+        }
+    }
+    uint64_t max_id = next_id - 1;
+
+    // walk each haplotype through the layout
+    for (uint64_t hap = 0; hap < params.path_count; ++hap) {
+        std::string name = "hap" + std::to_string(hap);
+        auto site = sites.begin();
+        for (uint64_t id = 1; id <= max_id; ) {
+            if (site == sites.end() || site->id != id) {
+                on_step(name, id, false);
+                ++id;
+                continue;
+            }
+            bool alt = takes_alt(params.seed, site - sites.begin(), hap);
+            switch (site->type) {
+            case SITE_SNP:
+                on_step(name, alt ? id + 1 : id, false);
+                id += 2;
+                break;
+            case SITE_INDEL:
+                if (alt) on_step(name, id, false);
+                id += 1;
+                break;
+            case SITE_INVERSION:
+                on_step(name, id, alt);
+                id += 1;
+                break;
+            }
+            ++site;
+        }
+    }
+}
+
+void simulate_graph(const simulate_params_t& params, graph_t& graph) {
+    std::string curr_name;
+    path_handle_t path;
+    simulate_graph(params,
+                   [&](uint64_t id, const std::string& seq) {
+                       graph.create_handle(seq, id);
+                   },
+                   [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                       graph.create_edge(graph.get_handle(from_id, from_rev),
+                                         graph.get_handle(to_id, to_rev));
+                   },
+                   [&](const std::string& path_name, uint64_t id, bool is_rev) {
+                       if (path_name != curr_name) {
+                           path = graph.create_path_handle(path_name);
+                           curr_name = path_name;
+                       }
+                       graph.append_occurrence(path, graph.get_handle(id, is_rev));
+                   });
+}
+
+void simulate_gfa(const simulate_params_t& params, std::ostream& out) {
+    std::string curr_name;
+    out << "H\tVN:Z:1.0\n";
+    simulate_graph(params,
+                   [&](uint64_t id, const std::string& seq) {
+                       out << "S\t" << id << "\t" << seq << "\n";
+                   },
+                   [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                       out << "L\t" << from_id << "\t" << (from_rev ? "-" : "+")
+                           << "\t" << to_id << "\t" << (to_rev ? "-" : "+") << "\t0M\n";
+                   },
+                   [&](const std::string& path_name, uint64_t id, bool is_rev) {
+                       if (path_name != curr_name) {
+                           // close the previous path line
+                           if (!curr_name.empty()) out << "\t*\n";
+                           out << "P\t" << path_name << "\t";
+                           curr_name = path_name;
+                       } else {
+                           out << ",";
+                       }
+                       out << id << (is_rev ? "-" : "+");
+                   });
+    if (!curr_name.empty()) out << "\t*\n";
+    out.flush();
+}
+
+}
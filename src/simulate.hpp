@@ -0,0 +1,71 @@
+#ifndef dgraph_simulate_hpp
+#define dgraph_simulate_hpp
+
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <iostream>
+#include "graph.hpp"
+
+/** \file
+ * simulate.hpp: generates synthetic pangenome graphs for benchmarking.
+ *
+ * The graph is a linear backbone broken into nodes, interrupted by variant
+ * sites. A SNP site is a pair of parallel single-base nodes, an indel site is
+ * a node that can be skipped, and an inversion site is a node that can be
+ * traversed in either orientation. Each haplotype path walks the backbone and
+ * picks one allele at every site, with a per-site allele frequency. The same
+ * parameters always produce the same graph.
+ */
+
+namespace dg {
+
+/// How simulated node lengths are drawn
+enum node_length_dist_t {
+    /// every node has the mean length
+    NODE_LENGTH_FIXED,
+    /// uniform between 1 and twice the mean, less one
+    NODE_LENGTH_UNIFORM,
+    /// geometric with the given mean
+    NODE_LENGTH_GEOMETRIC
+};
+
+/// Parameters of a simulated graph
+struct simulate_params_t {
+    /// approximate number of bases in the backbone
+    uint64_t length = 1000000;
+    /// mean length of backbone and inverted nodes
+    uint64_t node_length = 32;
+    /// distribution of backbone and inverted node lengths
+    node_length_dist_t node_length_dist = NODE_LENGTH_UNIFORM;
+    /// expected SNP sites per backbone base
+    double snp_rate = 0.001;
+    /// expected indel sites per backbone base
+    double indel_rate = 0.0002;
+    /// expected inversion sites per backbone base
+    double inversion_rate = 0.00001;
+    /// indel lengths are uniform between 1 and this
+    uint64_t max_indel = 20;
+    /// number of haplotype paths, named hap0, hap1, ...
+    uint64_t path_count = 10;
+    /// seed for everything
+    uint64_t seed = 27;
+};
+
+/// Generate a graph, reporting each node, then each edge once both of its
+/// nodes have been reported, and finally each path one step at a time. Steps
+/// of different paths are never interleaved.
+void simulate_graph(const simulate_params_t& params,
+                    const std::function<void(uint64_t id, const std::string& seq)>& on_node,
+                    const std::function<void(uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev)>& on_edge,
+                    const std::function<void(const std::string& path_name, uint64_t id, bool is_rev)>& on_step);
+
+/// Build a simulated graph into the given graph, which should be empty
+void simulate_graph(const simulate_params_t& params, graph_t& graph);
+
+/// Stream a simulated graph to the output as GFA, without keeping it in memory
+void simulate_gfa(const simulate_params_t& params, std::ostream& out);
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "subcommand.hpp"
+#include "bench.hpp"
+#include "args.hxx"
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_bench(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg bench";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    bench_params_t params;
+    args::ArgumentParser parser("run timed micro-benchmarks of the graph operations on a random graph");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<uint64_t> nodes(parser, "N", "build a benchmark graph with this many nodes [100000]", {'n', "nodes"});
+    args::ValueFlag<uint64_t> node_length(parser, "N", "mean node length in the benchmark graph [8]", {'l', "node-length"});
+    args::ValueFlag<uint64_t> queries(parser, "N", "run this many random queries per lookup benchmark [100000]", {'q', "queries"});
+    args::ValueFlag<uint64_t> divides(parser, "N", "split this many nodes in the divide_handle benchmark, or none if 0 [1000]", {'D', "divides"});
+    args::ValueFlag<uint64_t> seed(parser, "N", "seed the random graph and query order with this value [27]", {'s', "seed"});
+    args::Flag json(parser, "json", "write the results to stdout as JSON rather than as a table", {'j', "json"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (nodes) params.node_count = args::get(nodes);
+    if (node_length) params.node_length = args::get(node_length);
+    if (queries) params.query_count = args::get(queries);
+    if (divides) params.divide_count = args::get(divides);
+    if (seed) params.seed = args::get(seed);
+    if (params.node_length == 0) {
+        std::cerr << "error:[dg bench] node length must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<bench_result_t> results = run_graph_benchmarks(params);
+    if (args::get(json)) {
+        std::cout << "{\"params\":{"
+                  << "\"nodes\":" << params.node_count
+                  << ",\"node_length\":" << params.node_length
+                  << ",\"queries\":" << params.query_count
+                  << ",\"divides\":" << params.divide_count
+                  << ",\"seed\":" << params.seed
+                  << "},\"results\":";
+        write_bench_json(std::cout, results);
+        std::cout << "}" << std::endl;
+    } else {
+        write_bench_table(std::cout, results);
+    }
+    return 0;
+}
+
+static Subcommand dg_bench("bench", "benchmark graph operations",
+                           DEVELOPMENT, 1, main_bench);
+
+}
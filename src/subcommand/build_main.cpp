@@ -1,7 +1,10 @@
 #include "subcommand.hpp"
 #include "graph.hpp"
-#include "gfakluge.hpp"
+#include "trace.hpp"
+#include "gfa.hpp"
 #include "args.hxx"
+#include <memory>
+#include <fstream>
 //#include "io_helper.hpp"
 
 namespace dg {
@@ -20,9 +23,11 @@ int main_build(int argc, char** argv) {
     
     args::ArgumentParser parser("construct a dynamic succinct variation graph");
     args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
-    args::ValueFlag<std::string> gfa_file(parser, "FILE", "construct the graph from this GFA input file", {'g', "gfa"});
+    args::ValueFlag<std::string> gfa_file(parser, "FILE", "construct the graph from this GFA file, which may be gzipped, or - for stdin", {'g', "gfa"});
+    args::Flag translate_names(parser, "names", "give the GFA segments dense ids in order of appearance and store the name table in the index file name with .names appended", {'N', "names"});
     args::ValueFlag<std::string> dg_out_file(parser, "FILE", "store the index in this file", {'o', "out"});
     args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::Flag compress(parser, "compress", "compress the sequence and path sections of the stored index", {'z', "compress"});
     //args::ValueFlag<std::string> seqs(parser, "FILE", "the sequences used to generate the alignments", {'s', "seqs"});
     //args::ValueFlag<std::string> base(parser, "FILE", "build graph using this basename", {'b', "base"});
     //args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
@@ -31,6 +36,8 @@ int main_build(int argc, char** argv) {
     //args::ValueFlag<uint64_t> aln_min_length(parser, "N", "ignore alignments shorter than this", {'m', "aln-min-length"});
     args::Flag to_gfa(parser, "to_gfa", "write the graph to stdout in GFA format", {'G', "to-gfa"});
     args::Flag summarize(parser, "summarize", "summarize the graph properties and dimensions", {'S', "summarize"});
+    args::Flag json(parser, "json", "write the summary to stdout as JSON", {'j', "json"});
+    args::ValueFlag<std::string> trace_file(parser, "FILE", "record the graph operations used to build and summarize the graph in this trace", {'T', "trace"});
     args::Flag debug(parser, "debug", "enable debugging", {'d', "debug"});
     args::Flag progress(parser, "progress", "show progress updates", {'p', "progress"});
     try {
@@ -57,79 +64,56 @@ int main_build(int argc, char** argv) {
     }
     */
     graph_t graph;
+    // when tracing, all graph operations go through the traced wrapper
+    std::string tracefile = args::get(trace_file);
+    ofstream trace_out;
+    std::unique_ptr<trace_writer_t> trace;
+    std::unique_ptr<traced_graph_t> traced;
+    MutablePathDeletableHandleGraph* target = &graph;
+    if (tracefile.size()) {
+        trace_out.open(tracefile.c_str());
+        trace.reset(new trace_writer_t(trace_out));
+        traced.reset(new traced_graph_t(graph, *trace));
+        target = traced.get();
+    }
     
     //make_graph();
     assert(argc > 0);
     std::string gfa_filename = args::get(gfa_file);
+    segment_names_t names;
     if (gfa_filename.size()) {
-        char* filename = (char*)gfa_filename.c_str();
-        //std::cerr << "filename is " << filename << std::endl;
-        gfak::GFAKluge gg;
-        //double version = gg.detect_version_from_file(filename);
-        //std::cerr << version << " be version" << std::endl;
-        //assert(version == 1.0);
-        /*
-          uint64_t num_nodes = 0;
-          gg.for_each_sequence_line_in_file(filename, [&](gfak::sequence_elem s) {
-          ++num_nodes;
-          });
-          graph_t graph(num_nodes+1); // include delimiter
-        */
-        uint64_t i = 0;
-        gg.for_each_sequence_line_in_file(filename, [&](gfak::sequence_elem s) {
-                uint64_t id = stol(s.name);
-                graph.create_handle(s.sequence, id);
-                if (args::get(progress)) {
-                    if (i % 1000 == 0) std::cerr << "node " << i << "\r";
-                    ++i;
-                }
-            });
-        if (args::get(progress)) {
-            i = 0; std::cerr << std::endl;
+        // read in one pass, so the input may be a pipe
+        ifstream gfa_in;
+        if (gfa_filename != "-") {
+            gfa_in.open(gfa_filename.c_str(), std::ios::binary);
+            if (!gfa_in) {
+                std::cerr << "error:[dg build] could not open " << gfa_filename << std::endl;
+                return 1;
+            }
         }
-        gg.for_each_edge_line_in_file(filename, [&](gfak::edge_elem e) {
-                if (e.source_name.empty()) return;
-                handle_t a = graph.get_handle(stol(e.source_name), !e.source_orientation_forward);
-                handle_t b = graph.get_handle(stol(e.sink_name), !e.sink_orientation_forward);
-                graph.create_edge(a, b);
-                if (args::get(progress)) {
-                    if (i % 1000 == 0) std::cerr << "edge " << i << "\r";
-                    ++i;
-                }
-            });
-        if (args::get(progress)) {
-            i = 0; std::cerr << std::endl;
+        try {
+            read_gfa(gfa_filename == "-" ? std::cin : gfa_in, *target,
+                     args::get(translate_names) ? &names : nullptr, args::get(progress));
+        } catch (const std::runtime_error& e) {
+            std::cerr << "error:[dg build] " << e.what() << std::endl;
+            return 1;
         }
-        gg.for_each_path_element_in_file(filename, [&](const std::string& path_name, const std::string& node_id, bool is_rev, const std::string& cigar) {
-                path_handle_t path;
-                if (!graph.has_path(path_name)) {
-                    path = graph.create_path_handle(path_name);
-                    if (args::get(progress) && i != 0) {
-                        std::cerr << std::endl;
-                    }
-                    i = 0;
-                } else {
-                    path = graph.get_path_handle(path_name);
-                }
-                handle_t occ = graph.get_handle(stol(node_id), is_rev);
-                graph.append_occurrence(path, occ);
-                if (args::get(progress)) {
-                    if (i % 1000 == 0) std::cerr << "path " << path_name << " " << i << "\r";
-                    ++i;
-                }
-                // ignores overlaps
-            });
     }
     std::string infile = args::get(dg_in_file);
     if (infile.size()) {
+        // every section is loaded, since the summary measures them all
         ifstream f(infile.c_str());
-        graph.load(f);
+        try {
+            graph.load(f);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "error:[dg build] " << e.what() << std::endl;
+            return 1;
+        }
         f.close();
     }
     if (args::get(progress)) {
         std::cerr << std::endl;
     }
-    // here we should measure memory usage etc.
     if (args::get(debug)) {
         graph.display();
     }
@@ -137,28 +121,46 @@ int main_build(int argc, char** argv) {
         graph.to_gfa(std::cout);
     }
     if (args::get(summarize)) {
-        uint64_t length_in_bp = 0, node_count = 0, edge_count = 0, path_count = 0;
-        graph.for_each_handle([&](const handle_t& h) {
-                length_in_bp += graph.get_length(h);
+        uint64_t length_in_bp = 0, node_count = 0, edge_count = 0;
+        target->for_each_handle([&](const handle_t& h) {
+                length_in_bp += target->get_length(h);
                 ++node_count;
             });
-        graph.for_each_edge([&](const edge_t& e) {
+        target->for_each_edge([&](const edge_t& e) {
                 ++edge_count;
                 return true;
             });
-        graph.for_each_path_handle([&](const path_handle_t& p) {
-                ++path_count;
-            });
-        std::cerr << "length:\t" << length_in_bp << std::endl;
-        std::cerr << "nodes:\t" << node_count << std::endl;
-        std::cerr << "edges:\t" << edge_count << std::endl;
-        std::cerr << "paths:\t" << path_count << std::endl;
+        uint64_t path_count = target->get_path_count();
+        memory_usage_t usage = graph.memory_usage();
+        if (args::get(json)) {
+            std::cout << "{\"length\":" << length_in_bp
+                      << ",\"nodes\":" << node_count
+                      << ",\"edges\":" << edge_count
+                      << ",\"paths\":" << path_count
+                      << ",\"memory\":";
+            usage.write_json(std::cout);
+            std::cout << "}" << std::endl;
+        } else {
+            std::cerr << "length:\t" << length_in_bp << std::endl;
+            std::cerr << "nodes:\t" << node_count << std::endl;
+            std::cerr << "edges:\t" << edge_count << std::endl;
+            std::cerr << "paths:\t" << path_count << std::endl;
+            std::cerr << "memory (bytes):" << std::endl;
+            usage.write_table(std::cerr);
+        }
     }
     std::string outfile = args::get(dg_out_file);
     if (outfile.size()) {
         ofstream f(outfile.c_str());
-        graph.serialize(f);
+        graph.serialize(f, args::get(compress));
         f.close();
+        if (args::get(translate_names)) {
+            ofstream names_out((outfile + ".names").c_str());
+            names.serialize(names_out);
+        }
+    }
+    if (trace) {
+        trace->flush();
     }
     //if (args::get(
     return 0;
@@ -0,0 +1,99 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "bgraph.hpp"
+#include "compare.hpp"
+#include "args.hxx"
+#include <sstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_compare(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg compare";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    bench_params_t params;
+    args::ArgumentParser parser("run the same workload against each graph backend and report time and memory side by side");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> gfa_file(parser, "FILE", "load this GFA into each backend, which may be gzipped and may have non-numeric segment names, or - for stdin", {'g', "gfa"});
+    args::ValueFlag<std::string> backends(parser, "LIST", "compare these comma-separated backends [graph_t,bgraph]", {'b', "backends"});
+    args::ValueFlag<uint64_t> queries(parser, "N", "run this many random queries per lookup benchmark [100000]", {'q', "queries"});
+    args::ValueFlag<uint64_t> divides(parser, "N", "split this many nodes in the divide_handle benchmark, or none if 0 [1000]", {'D', "divides"});
+    args::ValueFlag<uint64_t> seed(parser, "N", "seed the query order with this value [27]", {'s', "seed"});
+    args::Flag json(parser, "json", "write the results to stdout as JSON rather than as a table", {'j', "json"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (queries) params.query_count = args::get(queries);
+    if (divides) params.divide_count = args::get(divides);
+    if (seed) params.seed = args::get(seed);
+    std::string gfa_filename = args::get(gfa_file);
+    if (gfa_filename.empty()) {
+        std::cerr << "error:[dg compare] a GFA input is required (-g)" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> names;
+    std::stringstream list(backends ? args::get(backends) : "graph_t,bgraph");
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        if (name != "graph_t" && name != "bgraph") {
+            std::cerr << "error:[dg compare] unknown backend " << name << std::endl;
+            return 1;
+        }
+        names.push_back(name);
+    }
+
+    gfa_records_t gfa;
+    try {
+        gfa = read_gfa_records(gfa_filename);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg compare] " << e.what() << std::endl;
+        return 1;
+    }
+    std::vector<backend_report_t> reports;
+    for (auto& backend : names) {
+        if (backend == "graph_t") {
+            reports.push_back(run_backend_workload<graph_t>(backend, gfa, params));
+        } else {
+            reports.push_back(run_backend_workload<betagraph::BGraph>(backend, gfa, params));
+        }
+    }
+    if (args::get(json)) {
+        std::cout << "{\"params\":{"
+                  << "\"nodes\":" << gfa.nodes.size()
+                  << ",\"edges\":" << gfa.edges.size()
+                  << ",\"paths\":" << gfa.paths.size()
+                  << ",\"queries\":" << params.query_count
+                  << ",\"divides\":" << params.divide_count
+                  << ",\"seed\":" << params.seed
+                  << "},\"backends\":";
+        write_compare_json(std::cout, reports);
+        std::cout << "}" << std::endl;
+    } else {
+        write_compare_table(std::cout, reports);
+    }
+    return 0;
+}
+
+static Subcommand dg_compare("compare", "compare graph backends on one workload",
+                             DEVELOPMENT, 4, main_compare);
+
+}
@@ -0,0 +1,132 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+#include <sstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_components(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg components";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("find the weakly connected components of the graph and optionally split it into them");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlag<std::string> out_prefix(parser, "PREFIX", "write each component to PREFIX.N.dg, numbered from 0", {'o', "out-prefix"});
+    args::Flag to_gfa(parser, "to_gfa", "write the components as PREFIX.N.gfa instead", {'G', "to-gfa"});
+    args::Flag compress(parser, "compress", "compress the sequence and path sections of the stored components", {'z', "compress"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg components] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    std::string prefix = args::get(out_prefix);
+    if (args::get(to_gfa) && prefix.empty()) {
+        std::cerr << "error:[dg components] -G needs an output prefix (-o)" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        // the paths are only needed to write the components out
+        graph.load(f, prefix.empty() ? COMPONENT_TOPOLOGY | COMPONENT_SEQUENCE : COMPONENT_ALL);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg components] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    std::vector<uint64_t> component;
+    uint64_t count = graph.weakly_connected_components(component);
+    // bucket the ranks by component, keeping rank order within each and
+    // leaving out the hidden nodes
+    std::vector<uint64_t> offsets(count + 1, 0);
+    for (auto k : component) {
+        if (k != no_component) ++offsets[k + 1];
+    }
+    for (uint64_t k = 0; k < count; ++k) {
+        offsets[k + 1] += offsets[k];
+    }
+    std::vector<uint64_t> ranks(offsets.back());
+    {
+        std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+        for (uint64_t i = 0; i < component.size(); ++i) {
+            if (component[i] != no_component) ranks[fill[component[i]]++] = i;
+        }
+    }
+    std::vector<uint64_t> length(count, 0);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (uint64_t k = 0; k < count; ++k) {
+        for (uint64_t i = offsets[k]; i < offsets[k + 1]; ++i) {
+            length[k] += graph.get_length(handle_helper::pack(ranks[i], false));
+        }
+    }
+    std::stringstream ss;
+    for (uint64_t k = 0; k < count; ++k) {
+        ss << k << "\t" << offsets[k + 1] - offsets[k] << "\t" << length[k] << "\n";
+    }
+    std::cout << ss.str();
+
+    if (prefix.empty()) return 0;
+    bool failed = false;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t k = 0; k < count; ++k) {
+        std::vector<handle_t> nodes;
+        nodes.reserve(offsets[k + 1] - offsets[k]);
+        for (uint64_t i = offsets[k]; i < offsets[k + 1]; ++i) {
+            nodes.push_back(handle_helper::pack(ranks[i], false));
+        }
+        // a component has no context beyond itself
+        graph_t part;
+        graph.extract(nodes, 0, part);
+        std::string outfile = prefix + "." + std::to_string(k) + (args::get(to_gfa) ? ".gfa" : ".dg");
+        ofstream out(outfile.c_str());
+        if (!out) {
+#pragma omp critical
+            {
+                std::cerr << "error:[dg components] could not write " << outfile << std::endl;
+                failed = true;
+            }
+            continue;
+        }
+        if (args::get(to_gfa)) {
+            part.to_gfa(out);
+        } else {
+            part.serialize(out, args::get(compress));
+        }
+    }
+    return failed ? 1 : 0;
+}
+
+static Subcommand dg_components("components", "find and split out the weakly connected components",
+                                TOOLKIT, 2, main_components);
+
+}
@@ -0,0 +1,119 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_extract(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg extract";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("extract the subgraph around some nodes or an id range, with the embedded paths clipped to it");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlagList<uint64_t> node_ids(parser, "ID", "extract around this node (may repeat)", {'n', "node"});
+    args::ValueFlag<std::string> id_range(parser, "FIRST:LAST", "extract around the nodes with ids from FIRST through LAST", {'r', "range"});
+    args::ValueFlag<uint64_t> context_steps(parser, "N", "also take the nodes up to this many edges away [0]", {'c', "context"});
+    args::ValueFlag<std::string> dg_out_file(parser, "FILE", "store the subgraph in this file", {'o', "out"});
+    args::Flag to_gfa(parser, "to_gfa", "write the subgraph to stdout in GFA format", {'G', "to-gfa"});
+    args::Flag compress(parser, "compress", "compress the sequence and path sections of the stored subgraph", {'z', "compress"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg extract] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    std::string outfile = args::get(dg_out_file);
+    if (outfile.empty() && !args::get(to_gfa)) {
+        std::cerr << "error:[dg extract] an output is required (-o or -G)" << std::endl;
+        return 1;
+    }
+    std::vector<uint64_t> ids = args::get(node_ids);
+    std::string range = args::get(id_range);
+    if (ids.empty() == range.empty()) {
+        std::cerr << "error:[dg extract] give either nodes (-n) or an id range (-r)" << std::endl;
+        return 1;
+    }
+    uint64_t first = 0, last = 0;
+    if (range.size()) {
+        size_t colon = range.find(':');
+        try {
+            if (colon == std::string::npos) throw std::invalid_argument(range);
+            first = std::stoull(range.substr(0, colon));
+            last = std::stoull(range.substr(colon + 1));
+        } catch (const std::logic_error& e) {
+            std::cerr << "error:[dg extract] could not parse the id range " << range << std::endl;
+            return 1;
+        }
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg extract] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    uint64_t context = args::get(context_steps);
+    graph_t subgraph;
+    if (range.size()) {
+        graph.extract(first, last, context, subgraph);
+    } else {
+        std::vector<handle_t> nodes;
+        nodes.reserve(ids.size());
+        for (auto id : ids) {
+            if (!graph.has_node(id)) {
+                std::cerr << "error:[dg extract] no node " << id << " in the graph" << std::endl;
+                return 1;
+            }
+            nodes.push_back(graph.get_handle(id));
+        }
+        graph.extract(nodes, context, subgraph);
+    }
+    if (args::get(to_gfa)) {
+        subgraph.to_gfa(std::cout);
+    }
+    if (outfile.size()) {
+        ofstream out(outfile.c_str());
+        if (!out) {
+            std::cerr << "error:[dg extract] could not write " << outfile << std::endl;
+            return 1;
+        }
+        subgraph.serialize(out, args::get(compress));
+    }
+    return 0;
+}
+
+static Subcommand dg_extract("extract", "extract the subgraph around nodes or an id range",
+                             TOOLKIT, 3, main_extract);
+
+}
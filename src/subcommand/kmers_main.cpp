@@ -0,0 +1,110 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "kmer.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_kmers(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg kmers";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("enumerate the k-mers spelled by walks through the graph, with where each one starts");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlag<uint64_t> kmer_length(parser, "K", "enumerate k-mers of this length, at most 32 [16]", {'k', "kmer-length"});
+    args::ValueFlag<uint64_t> max_edges(parser, "N", "leave out k-mers crossing more than this many edges [8]", {'e', "max-edges"});
+    args::Flag canonical(parser, "canonical", "report the lesser of each k-mer and its reverse complement, from the strand spelling it", {'c', "canonical"});
+    args::ValueFlag<std::string> kmers_out_file(parser, "FILE", "write the k-mers to this file instead of stdout", {'o', "out"});
+    args::Flag text(parser, "text", "write tab-separated k-mer, id, strand and offset lines instead of binary records", {'T', "text"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg kmers] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    kmer_params_t params;
+    if (kmer_length) params.k = args::get(kmer_length);
+    if (max_edges) params.max_edges = args::get(max_edges);
+    params.canonical = args::get(canonical);
+    if (params.k == 0 || params.k > 32) {
+        std::cerr << "error:[dg kmers] the k-mer length must be from 1 to 32" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg kmers] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    std::string outfile = args::get(kmers_out_file);
+    ofstream file_out;
+    if (outfile.size()) {
+        file_out.open(outfile.c_str(), std::ios::binary);
+        if (!file_out) {
+            std::cerr << "error:[dg kmers] could not write " << outfile << std::endl;
+            return 1;
+        }
+    } else {
+        std::ios::sync_with_stdio(false);
+    }
+    std::ostream& out = outfile.size() ? file_out : std::cout;
+    if (args::get(text)) {
+        std::string buffer;
+        for_each_kmer_batch(graph, params, [&](const std::vector<kmer_pos_t>& kmers) {
+                buffer.clear();
+                for (auto& kmer : kmers) {
+                    buffer.append(kmer_to_string(kmer.kmer, params.k));
+                    buffer.push_back('\t');
+                    buffer.append(std::to_string(kmer.id));
+                    buffer.append(kmer.is_rev ? "\t-\t" : "\t+\t");
+                    buffer.append(std::to_string(kmer.offset));
+                    buffer.push_back('\n');
+                }
+                out.write(buffer.data(), buffer.size());
+            });
+    } else {
+        write_kmer_header(out, params);
+        for_each_kmer_batch(graph, params, [&](const std::vector<kmer_pos_t>& kmers) {
+                write_kmer_records(out, kmers);
+            });
+    }
+    out.flush();
+    return 0;
+}
+
+static Subcommand dg_kmers("kmers", "enumerate the k-mers of walks through the graph",
+                           TOOLKIT, 7, main_kmers);
+
+}
@@ -0,0 +1,102 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "sequence_index.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_locate(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg locate";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("find exact matches of sequences in the graph's nodes, on either strand");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlag<std::string> seq_index_file(parser, "FILE", "use the sequence index in this file [the graph index file with .fmi appended]", {'x', "seq-idx"});
+    args::Flag build_index(parser, "build", "build the sequence index and store it (with -x, or next to the graph index)", {'b', "build"});
+    args::ValueFlagList<std::string> patterns(parser, "SEQ", "report each node, strand and offset where this sequence starts (may repeat)", {'s', "sequence"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg locate] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg locate] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    std::string index_file = seq_index_file ? args::get(seq_index_file) : infile + ".fmi";
+    sequence_index_t index;
+    if (args::get(build_index)) {
+        index.build(graph);
+        ofstream out(index_file.c_str(), std::ios::binary);
+        if (!out) {
+            std::cerr << "error:[dg locate] could not write " << index_file << std::endl;
+            return 1;
+        }
+        index.serialize(out);
+    } else {
+        ifstream in(index_file.c_str(), std::ios::binary);
+        if (!in) {
+            std::cerr << "error:[dg locate] no sequence index at " << index_file << ", build one with -b" << std::endl;
+            return 1;
+        }
+        try {
+            index.load(in);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "error:[dg locate] " << e.what() << std::endl;
+            return 1;
+        }
+        if (index.node_count() != graph.node_size()) {
+            std::cerr << "error:[dg locate] the sequence index in " << index_file << " was built from another graph" << std::endl;
+            return 1;
+        }
+    }
+
+    for (auto& pattern : args::get(patterns)) {
+        for (auto& hit : index.locate(pattern)) {
+            std::cout << pattern << "\t" << graph.get_id(hit.first)
+                      << "\t" << (graph.get_is_reverse(hit.first) ? "-" : "+")
+                      << "\t" << hit.second << std::endl;
+        }
+    }
+    return 0;
+}
+
+static Subcommand dg_locate("locate", "find exact matches of short sequences with an FM-index",
+                            TOOLKIT, 9, main_locate);
+
+}
@@ -0,0 +1,96 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "minimizer.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_minimizers(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg minimizers";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("index the (w,k)-minimizers of the graph's nodes and the walks across its edges");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlag<uint64_t> kmer_length(parser, "K", "use k-mers of this length, at most 32 [15]", {'k', "kmer-length"});
+    args::ValueFlag<uint64_t> window_length(parser, "W", "take a minimizer from each W consecutive k-mers, at most 64 [10]", {'w', "window-length"});
+    args::ValueFlag<uint64_t> max_edges(parser, "N", "leave out windows crossing more than this many edges [8]", {'e', "max-edges"});
+    args::ValueFlag<std::string> min_out_file(parser, "FILE", "store the minimizer index in this file [the graph index file with .min appended]", {'o', "out"});
+    args::Flag progress(parser, "progress", "report the size of the minimizer index", {'p', "progress"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg minimizers] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    minimizer_params_t params;
+    if (kmer_length) params.k = args::get(kmer_length);
+    if (window_length) params.w = args::get(window_length);
+    if (max_edges) params.max_edges = args::get(max_edges);
+    if (params.k == 0 || params.k > 32 || params.w == 0 || params.w > minimizer_max_window) {
+        std::cerr << "error:[dg minimizers] k must be from 1 to 32 and w from 1 to "
+                  << minimizer_max_window << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg minimizers] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    minimizer_index_t index;
+    try {
+        index.build(graph, params);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg minimizers] " << e.what() << std::endl;
+        return 1;
+    }
+    if (args::get(progress)) {
+        std::cerr << "minimizers:\t" << index.size() << std::endl;
+        std::cerr << "hits:\t" << index.hit_count() << std::endl;
+    }
+    std::string outfile = min_out_file ? args::get(min_out_file) : infile + ".min";
+    ofstream out(outfile.c_str(), std::ios::binary);
+    if (!out) {
+        std::cerr << "error:[dg minimizers] could not write " << outfile << std::endl;
+        return 1;
+    }
+    index.serialize(out);
+    return 0;
+}
+
+static Subcommand dg_minimizers("minimizers", "index the minimizers of the graph for read mapping",
+                                TOOLKIT, 8, main_minimizers);
+
+}
@@ -0,0 +1,86 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "fasta.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_paths(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg paths";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("write out the sequences spelled by the embedded paths");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::Flag fasta(parser, "fasta", "write the path sequences to stdout in FASTA format", {'f', "fasta"});
+    args::ValueFlagList<std::string> path_names(parser, "NAME", "write only this path (may repeat)", {'p', "path"});
+    args::ValueFlag<uint64_t> line_width(parser, "N", "wrap sequence lines at this many bases, or 0 for none [80]", {'w', "line-width"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg paths] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    if (!args::get(fasta)) {
+        std::cerr << "error:[dg paths] an output format is required (-f)" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg paths] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    std::vector<path_handle_t> paths;
+    std::vector<std::string> names = args::get(path_names);
+    if (names.empty()) {
+        graph.for_each_path_handle([&](const path_handle_t& p) { paths.push_back(p); });
+    } else {
+        for (auto& name : names) {
+            if (!graph.has_path(name)) {
+                std::cerr << "error:[dg paths] no path " << name << " in the graph" << std::endl;
+                return 1;
+            }
+            paths.push_back(graph.get_path_handle(name));
+        }
+    }
+    std::ios::sync_with_stdio(false);
+    write_path_fasta(graph, paths, line_width ? args::get(line_width) : 80, std::cout);
+    return 0;
+}
+
+static Subcommand dg_paths("paths", "write the sequences of embedded paths",
+                           TOOLKIT, 6, main_paths);
+
+}
@@ -0,0 +1,106 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "bgraph.hpp"
+#include "trace.hpp"
+#include "args.hxx"
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+/// Copy the nodes, edges and paths of a loaded graph into another backend
+static void copy_graph(const PathHandleGraph& from, MutablePathDeletableHandleGraph& to) {
+    from.for_each_handle([&](const handle_t& h) {
+            to.create_handle(from.get_sequence(h), from.get_id(h));
+        });
+    from.for_each_edge([&](const edge_t& e) {
+            to.create_edge(to.get_handle(from.get_id(e.first), from.get_is_reverse(e.first)),
+                           to.get_handle(from.get_id(e.second), from.get_is_reverse(e.second)));
+            return true;
+        });
+    from.for_each_path_handle([&](const path_handle_t& p) {
+            path_handle_t q = to.create_path_handle(from.get_path_name(p));
+            from.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) {
+                    handle_t h = from.get_occurrence(occ);
+                    to.append_occurrence(q, to.get_handle(from.get_id(h), from.get_is_reverse(h)));
+                });
+        });
+}
+
+int main_replay(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg replay";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("re-execute a recorded trace of graph operations, timing each kind of operation");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> trace_file(parser, "FILE", "replay the operations recorded in this trace", {'t', "trace"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "start from the graph stored in this index, rather than an empty graph", {'i', "idx"});
+    args::ValueFlag<std::string> backend(parser, "NAME", "replay against this graph implementation: graph_t or bgraph [graph_t]", {'b', "backend"});
+    args::Flag json(parser, "json", "write the timings to stdout as JSON rather than as a table", {'j', "json"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    std::string tracefile = args::get(trace_file);
+    if (tracefile.empty()) {
+        std::cerr << "error:[dg replay] a trace is required (-t)" << std::endl;
+        return 1;
+    }
+    std::string backend_name = backend ? args::get(backend) : "graph_t";
+    if (backend_name != "graph_t" && backend_name != "bgraph") {
+        std::cerr << "error:[dg replay] unknown backend " << backend_name << std::endl;
+        return 1;
+    }
+
+    graph_t graph;
+    betagraph::BGraph bgraph;
+    std::vector<bench_result_t> results;
+    try {
+        std::string infile = args::get(dg_in_file);
+        if (infile.size()) {
+            ifstream f(infile.c_str());
+            graph.load(f);
+        }
+        ifstream t(tracefile.c_str());
+        if (backend_name == "bgraph") {
+            copy_graph(graph, bgraph);
+            graph.clear();
+            results = replay_trace(t, bgraph);
+        } else {
+            results = replay_trace(t, graph);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg replay] " << e.what() << std::endl;
+        return 1;
+    }
+    if (args::get(json)) {
+        std::cout << "{\"backend\":\"" << backend_name << "\",\"results\":";
+        write_bench_json(std::cout, results);
+        std::cout << "}" << std::endl;
+    } else {
+        write_bench_table(std::cout, results);
+    }
+    return 0;
+}
+
+static Subcommand dg_replay("replay", "replay a trace of graph operations",
+                            DEVELOPMENT, 3, main_replay);
+
+}
@@ -0,0 +1,97 @@
+#include "subcommand.hpp"
+#include "simulate.hpp"
+#include "args.hxx"
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_simulate(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg simulate";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    simulate_params_t params;
+    args::ArgumentParser parser("generate a synthetic pangenome graph with variant bubbles and haplotype paths");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_out_file(parser, "FILE", "build the graph and store the index in this file", {'o', "out"});
+    args::Flag to_gfa(parser, "to_gfa", "stream the graph to stdout in GFA format without building it", {'G', "to-gfa"});
+    args::ValueFlag<uint64_t> length(parser, "N", "approximate number of bases in the backbone [1000000]", {'l', "length"});
+    args::ValueFlag<uint64_t> node_length(parser, "N", "mean node length [32]", {'n', "node-length"});
+    args::ValueFlag<std::string> node_length_dist(parser, "DIST", "node length distribution: fixed, uniform or geometric [uniform]", {'D', "node-length-dist"});
+    args::ValueFlag<double> snp_rate(parser, "X", "SNP sites per backbone base [0.001]", {'s', "snp-rate"});
+    args::ValueFlag<double> indel_rate(parser, "X", "indel sites per backbone base [0.0002]", {'i', "indel-rate"});
+    args::ValueFlag<double> inversion_rate(parser, "X", "inversion sites per backbone base [0.00001]", {'v', "inversion-rate"});
+    args::ValueFlag<uint64_t> max_indel(parser, "N", "maximum indel length [20]", {'m', "max-indel"});
+    args::ValueFlag<uint64_t> path_count(parser, "N", "number of haplotype paths [10]", {'P', "paths"});
+    args::ValueFlag<uint64_t> seed(parser, "N", "random seed [27]", {'S', "seed"});
+    args::Flag compress(parser, "compress", "compress the sequence and path sections of the stored index", {'z', "compress"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (length) params.length = args::get(length);
+    if (node_length) params.node_length = args::get(node_length);
+    if (snp_rate) params.snp_rate = args::get(snp_rate);
+    if (indel_rate) params.indel_rate = args::get(indel_rate);
+    if (inversion_rate) params.inversion_rate = args::get(inversion_rate);
+    if (max_indel) params.max_indel = args::get(max_indel);
+    if (path_count) params.path_count = args::get(path_count);
+    if (seed) params.seed = args::get(seed);
+    if (node_length_dist) {
+        std::string dist = args::get(node_length_dist);
+        if (dist == "fixed") {
+            params.node_length_dist = NODE_LENGTH_FIXED;
+        } else if (dist == "uniform") {
+            params.node_length_dist = NODE_LENGTH_UNIFORM;
+        } else if (dist == "geometric") {
+            params.node_length_dist = NODE_LENGTH_GEOMETRIC;
+        } else {
+            std::cerr << "error:[dg simulate] unknown node length distribution " << dist << std::endl;
+            return 1;
+        }
+    }
+    if (params.node_length == 0) {
+        std::cerr << "error:[dg simulate] node length must be positive" << std::endl;
+        return 1;
+    }
+    std::string outfile = args::get(dg_out_file);
+    if (args::get(to_gfa) && outfile.size()) {
+        std::cerr << "error:[dg simulate] choose one of -o and -G" << std::endl;
+        return 1;
+    }
+    if (args::get(to_gfa)) {
+        simulate_gfa(params, std::cout);
+    } else if (outfile.size()) {
+        graph_t graph;
+        simulate_graph(params, graph);
+        ofstream f(outfile.c_str());
+        graph.serialize(f, args::get(compress));
+        f.close();
+    } else {
+        std::cerr << "error:[dg simulate] one of -o or -G is required" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static Subcommand dg_simulate("simulate", "generate a synthetic pangenome graph",
+                              DEVELOPMENT, 2, main_simulate);
+
+}
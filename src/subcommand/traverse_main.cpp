@@ -0,0 +1,136 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "traverse.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+#include <sstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_traverse(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg traverse";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("walk the graph breadth-first or depth-first, or collect the context around seed nodes");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlagList<uint64_t> node_ids(parser, "ID", "start from this node (may repeat)", {'n', "node"});
+    args::ValueFlag<std::string> seed_file(parser, "FILE", "start from the node ids in this file, one per line", {'f', "seeds"});
+    args::ValueFlag<std::string> mode(parser, "MODE", "context: the context of each seed, one line per seed; bfs: distance from the nearest seed; dfs: depth-first order [context]", {'m', "mode"});
+    args::ValueFlag<uint64_t> max_steps(parser, "N", "go no more than this many edges from a seed (context and bfs) [1 for context]", {'s', "steps"});
+    args::ValueFlag<uint64_t> max_bp(parser, "N", "also take into the context the nodes with no more than this many bases between them and their seed", {'b', "bp"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string how = mode ? args::get(mode) : "context";
+    if (how != "context" && how != "bfs" && how != "dfs") {
+        std::cerr << "error:[dg traverse] unknown mode " << how << std::endl;
+        return 1;
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg traverse] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f, COMPONENT_TOPOLOGY | COMPONENT_SEQUENCE);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg traverse] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    std::vector<uint64_t> ids = args::get(node_ids);
+    std::string seedfile = args::get(seed_file);
+    if (seedfile.size()) {
+        ifstream seeds_in(seedfile.c_str());
+        if (!seeds_in) {
+            std::cerr << "error:[dg traverse] could not open " << seedfile << std::endl;
+            return 1;
+        }
+        uint64_t id;
+        while (seeds_in >> id) {
+            ids.push_back(id);
+        }
+    }
+    std::vector<handle_t> seeds;
+    seeds.reserve(ids.size());
+    for (auto id : ids) {
+        if (!graph.has_node(id)) {
+            std::cerr << "error:[dg traverse] no node " << id << " in the graph" << std::endl;
+            return 1;
+        }
+        seeds.push_back(graph.get_handle(id));
+    }
+    if (seeds.empty()) {
+        std::cerr << "error:[dg traverse] at least one seed node is required (-n or -f)" << std::endl;
+        return 1;
+    }
+
+    if (how == "bfs") {
+        bfs_levels_t levels = bfs(graph, seeds, max_steps ? args::get(max_steps) : UINT64_MAX);
+        std::stringstream ss;
+        for (uint64_t d = 0; d < levels.level_count(); ++d) {
+            for (uint64_t i = levels.level_offsets[d]; i < levels.level_offsets[d+1]; ++i) {
+                ss << graph.get_id(levels.nodes[i]) << "\t" << d << "\n";
+            }
+        }
+        std::cout << ss.str();
+    } else if (how == "dfs") {
+        std::stringstream ss;
+        dfs(graph, seeds, [&](const handle_t& h) {
+                ss << graph.get_id(h) << (graph.get_is_reverse(h) ? "-" : "+") << "\n";
+            }, nullptr);
+        std::cout << ss.str();
+    } else {
+        context_params_t params;
+        if (max_steps) params.max_steps = args::get(max_steps);
+        if (max_bp) params.max_bp = args::get(max_bp);
+        // contexts come back out of order, so they are written in order once all are done
+        std::vector<std::string> lines(seeds.size());
+        for_each_context(graph, seeds, params, [&](uint64_t i, const std::vector<handle_t>& nodes) {
+                std::stringstream ss;
+                ss << ids[i] << "\t";
+                for (uint64_t j = 0; j < nodes.size(); ++j) {
+                    if (j) ss << ",";
+                    ss << graph.get_id(nodes[j]);
+                }
+                lines[i] = ss.str();
+            });
+        for (auto& line : lines) {
+            std::cout << line << "\n";
+        }
+    }
+    return 0;
+}
+
+static Subcommand dg_traverse("traverse", "walk the graph or collect the context of seed nodes",
+                              TOOLKIT, 1, main_traverse);
+
+}
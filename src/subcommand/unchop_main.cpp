@@ -0,0 +1,88 @@
+#include "subcommand.hpp"
+#include "graph.hpp"
+#include "args.hxx"
+#include <omp.h>
+#include <fstream>
+
+namespace dg {
+
+using namespace dg::subcommand;
+
+int main_unchop(int argc, char** argv) {
+
+    // trick argumentparser to do the right thing with the subcommand
+    for (uint64_t i = 1; i < argc-1; ++i) {
+        argv[i] = argv[i+1];
+    }
+    std::string prog_name = "dg unchop";
+    argv[0] = (char*)prog_name.c_str();
+    --argc;
+
+    args::ArgumentParser parser("merge the non-branching chains of nodes that paths go straight through");
+    args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
+    args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
+    args::ValueFlag<std::string> dg_out_file(parser, "FILE", "store the merged graph in this file", {'o', "out"});
+    args::Flag to_gfa(parser, "to_gfa", "write the merged graph to stdout in GFA format", {'G', "to-gfa"});
+    args::Flag compress(parser, "compress", "compress the sequence and path sections of the stored graph", {'z', "compress"});
+    args::Flag progress(parser, "progress", "report the node counts before and after", {'p', "progress"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "use this many threads during parallel steps", {'t', "threads"});
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    if (argc==1) {
+        std::cout << parser;
+        return 1;
+    }
+    if (num_threads) {
+        omp_set_num_threads(args::get(num_threads));
+    }
+    std::string infile = args::get(dg_in_file);
+    if (infile.empty()) {
+        std::cerr << "error:[dg unchop] an index is required (-i)" << std::endl;
+        return 1;
+    }
+    std::string outfile = args::get(dg_out_file);
+    if (outfile.empty() && !args::get(to_gfa)) {
+        std::cerr << "error:[dg unchop] an output is required (-o or -G)" << std::endl;
+        return 1;
+    }
+    graph_t graph;
+    ifstream f(infile.c_str());
+    try {
+        graph.load(f);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error:[dg unchop] " << e.what() << std::endl;
+        return 1;
+    }
+    f.close();
+
+    uint64_t nodes_before = graph.node_size();
+    graph.unchop();
+    if (args::get(progress)) {
+        std::cerr << "nodes:\t" << nodes_before << " -> " << graph.node_size() << std::endl;
+    }
+    if (args::get(to_gfa)) {
+        graph.to_gfa(std::cout);
+    }
+    if (outfile.size()) {
+        ofstream out(outfile.c_str());
+        if (!out) {
+            std::cerr << "error:[dg unchop] could not write " << outfile << std::endl;
+            return 1;
+        }
+        graph.serialize(out, args::get(compress));
+    }
+    return 0;
+}
+
+static Subcommand dg_unchop("unchop", "merge non-branching chains of nodes",
+                            TOOLKIT, 4, main_unchop);
+
+}
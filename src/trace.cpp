@@ -0,0 +1,408 @@
+//
+//  trace.cpp
+//
+
+#include "trace.hpp"
+
+namespace dg {
+
+/// Flush the trace buffer once it holds this many bytes
+static const size_t trace_buffer_size = 1 << 20;
+
+static inline void put_varint(std::string& out, uint64_t x) {
+    while (x >= 0x80) {
+        out.push_back((char)(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back((char)x);
+}
+
+static inline bool get_varint(std::istream& in, uint64_t& x) {
+    x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF) return false;
+        x |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    throw std::runtime_error("[dg::trace] malformed varint");
+}
+
+const char* trace_op_name(trace_op_t op) {
+    static const char* names[OP_COUNT] = {
+        "name_path",
+        "has_node",
+        "get_handle",
+        "get_length",
+        "get_sequence",
+        "follow_edges",
+        "get_degree",
+        "for_each_handle",
+        "create_handle",
+        "create_edge",
+        "destroy_handle",
+        "destroy_edge",
+        "swap_handles",
+        "apply_orientation",
+        "divide_handle",
+        "clear",
+        "has_path",
+        "create_path",
+        "destroy_path",
+        "append_occurrence",
+        "get_occurrence_count",
+        "walk_path"
+    };
+    return op < OP_COUNT ? names[op] : "unknown";
+}
+
+trace_writer_t::trace_writer_t(std::ostream& out) : out(out) {
+    out.write((char*)&trace_format_magic,sizeof(trace_format_magic));
+    out.write((char*)&trace_format_version,sizeof(trace_format_version));
+}
+
+trace_writer_t::~trace_writer_t(void) {
+    flush();
+}
+
+void trace_writer_t::encode(const trace_record_t& record) {
+    buffer.push_back((char)record.op);
+    switch (record.op) {
+    case OP_CLEAR:
+        break;
+    case OP_NAME_PATH:
+    case OP_CREATE_HANDLE:
+        put_varint(buffer, record.a);
+        put_varint(buffer, record.text.size());
+        buffer.append(record.text);
+        break;
+    case OP_FOLLOW_EDGES:
+    case OP_GET_DEGREE:
+    case OP_CREATE_EDGE:
+    case OP_DESTROY_EDGE:
+    case OP_SWAP_HANDLES:
+    case OP_APPEND_OCCURRENCE:
+        put_varint(buffer, record.a);
+        put_varint(buffer, record.b);
+        break;
+    case OP_DIVIDE_HANDLE:
+        put_varint(buffer, record.a);
+        put_varint(buffer, record.offsets.size());
+        for (auto o : record.offsets) put_varint(buffer, o);
+        break;
+    default:
+        put_varint(buffer, record.a);
+        break;
+    }
+}
+
+void trace_writer_t::write(const trace_record_t& record) {
+    std::lock_guard<std::mutex> guard(mutex);
+    encode(record);
+    if (buffer.size() >= trace_buffer_size) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+uint64_t trace_writer_t::path_index(const std::string& name) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto f = path_indexes.find(name);
+    if (f != path_indexes.end()) return f->second;
+    uint64_t i = path_indexes.size();
+    path_indexes[name] = i;
+    trace_record_t record;
+    record.op = OP_NAME_PATH;
+    record.a = i;
+    record.text = name;
+    encode(record);
+    return i;
+}
+
+void trace_writer_t::flush(void) {
+    std::lock_guard<std::mutex> guard(mutex);
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+    out.flush();
+}
+
+trace_reader_t::trace_reader_t(std::istream& in) : in(in) {
+    uint64_t magic = 0, version = 0;
+    in.read((char*)&magic,sizeof(magic));
+    in.read((char*)&version,sizeof(version));
+    if (!in || magic != trace_format_magic) {
+        throw std::runtime_error("[dg::trace] input is not a dg trace");
+    }
+    if (version != trace_format_version) {
+        throw std::runtime_error("[dg::trace] unsupported trace version " + std::to_string(version));
+    }
+}
+
+bool trace_reader_t::next(trace_record_t& record) {
+    int c = in.get();
+    if (c == EOF) return false;
+    if (c >= OP_COUNT) {
+        throw std::runtime_error("[dg::trace] unknown op code " + std::to_string(c));
+    }
+    record.op = (trace_op_t)c;
+    record.a = record.b = 0;
+    record.text.clear();
+    record.offsets.clear();
+    bool ok = true;
+    uint64_t n = 0;
+    switch (record.op) {
+    case OP_CLEAR:
+        break;
+    case OP_NAME_PATH:
+    case OP_CREATE_HANDLE:
+        ok = get_varint(in, record.a) && get_varint(in, n);
+        if (ok) {
+            record.text.resize(n);
+            in.read(&record.text[0], n);
+            ok = (bool)in;
+        }
+        break;
+    case OP_FOLLOW_EDGES:
+    case OP_GET_DEGREE:
+    case OP_CREATE_EDGE:
+    case OP_DESTROY_EDGE:
+    case OP_SWAP_HANDLES:
+    case OP_APPEND_OCCURRENCE:
+        ok = get_varint(in, record.a) && get_varint(in, record.b);
+        break;
+    case OP_DIVIDE_HANDLE:
+        ok = get_varint(in, record.a) && get_varint(in, n);
+        for (uint64_t i = 0; ok && i < n; ++i) {
+            uint64_t o;
+            ok = get_varint(in, o);
+            record.offsets.push_back(o);
+        }
+        break;
+    default:
+        ok = get_varint(in, record.a);
+        break;
+    }
+    if (!ok) {
+        throw std::runtime_error("[dg::trace] truncated trace record");
+    }
+    return true;
+}
+
+traced_graph_t::traced_graph_t(MutablePathDeletableHandleGraph& graph, trace_writer_t& trace)
+    : graph(graph), trace(trace) {
+}
+
+uint64_t traced_graph_t::encode(const handle_t& handle) const {
+    return (uint64_t)graph.get_id(handle) << 1 | graph.get_is_reverse(handle);
+}
+
+uint64_t traced_graph_t::path_index(const path_handle_t& path) const {
+    return trace.path_index(graph.get_path_name(path));
+}
+
+void traced_graph_t::record(trace_op_t op, uint64_t a, uint64_t b) const {
+    trace_record_t r;
+    r.op = op;
+    r.a = a;
+    r.b = b;
+    trace.write(r);
+}
+
+bool traced_graph_t::has_node(id_t node_id) const {
+    record(OP_HAS_NODE, node_id);
+    return graph.has_node(node_id);
+}
+
+handle_t traced_graph_t::get_handle(const id_t& node_id, bool is_reverse) const {
+    record(OP_GET_HANDLE, (uint64_t)node_id << 1 | is_reverse);
+    return graph.get_handle(node_id, is_reverse);
+}
+
+id_t traced_graph_t::get_id(const handle_t& handle) const {
+    return graph.get_id(handle);
+}
+
+bool traced_graph_t::get_is_reverse(const handle_t& handle) const {
+    return graph.get_is_reverse(handle);
+}
+
+handle_t traced_graph_t::flip(const handle_t& handle) const {
+    return graph.flip(handle);
+}
+
+size_t traced_graph_t::get_length(const handle_t& handle) const {
+    record(OP_GET_LENGTH, encode(handle));
+    return graph.get_length(handle);
+}
+
+std::string traced_graph_t::get_sequence(const handle_t& handle) const {
+    record(OP_GET_SEQUENCE, encode(handle));
+    return graph.get_sequence(handle);
+}
+
+bool traced_graph_t::follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    record(OP_FOLLOW_EDGES, encode(handle), go_left);
+    return graph.follow_edges(handle, go_left, iteratee);
+}
+
+void traced_graph_t::for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    record(OP_FOR_EACH_HANDLE, parallel);
+    graph.for_each_handle(iteratee, parallel);
+}
+
+size_t traced_graph_t::node_size(void) const {
+    return graph.node_size();
+}
+
+id_t traced_graph_t::min_node_id(void) const {
+    return graph.min_node_id();
+}
+
+id_t traced_graph_t::max_node_id(void) const {
+    return graph.max_node_id();
+}
+
+size_t traced_graph_t::get_degree(const handle_t& handle, bool go_left) const {
+    record(OP_GET_DEGREE, encode(handle), go_left);
+    return graph.get_degree(handle, go_left);
+}
+
+bool traced_graph_t::has_path(const std::string& path_name) const {
+    record(OP_HAS_PATH, trace.path_index(path_name));
+    return graph.has_path(path_name);
+}
+
+path_handle_t traced_graph_t::get_path_handle(const std::string& path_name) const {
+    return graph.get_path_handle(path_name);
+}
+
+std::string traced_graph_t::get_path_name(const path_handle_t& path_handle) const {
+    return graph.get_path_name(path_handle);
+}
+
+size_t traced_graph_t::get_occurrence_count(const path_handle_t& path_handle) const {
+    record(OP_GET_OCCURRENCE_COUNT, path_index(path_handle));
+    return graph.get_occurrence_count(path_handle);
+}
+
+size_t traced_graph_t::get_path_count(void) const {
+    return graph.get_path_count();
+}
+
+void traced_graph_t::for_each_path_handle(const std::function<void(const path_handle_t&)>& iteratee) const {
+    graph.for_each_path_handle(iteratee);
+}
+
+handle_t traced_graph_t::get_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.get_occurrence(occurrence_handle);
+}
+
+occurrence_handle_t traced_graph_t::get_first_occurrence(const path_handle_t& path_handle) const {
+    return graph.get_first_occurrence(path_handle);
+}
+
+occurrence_handle_t traced_graph_t::get_last_occurrence(const path_handle_t& path_handle) const {
+    return graph.get_last_occurrence(path_handle);
+}
+
+bool traced_graph_t::has_next_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.has_next_occurrence(occurrence_handle);
+}
+
+bool traced_graph_t::has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.has_previous_occurrence(occurrence_handle);
+}
+
+occurrence_handle_t traced_graph_t::get_next_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.get_next_occurrence(occurrence_handle);
+}
+
+occurrence_handle_t traced_graph_t::get_previous_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.get_previous_occurrence(occurrence_handle);
+}
+
+path_handle_t traced_graph_t::get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const {
+    return graph.get_path_handle_of_occurrence(occurrence_handle);
+}
+
+std::vector<occurrence_handle_t> traced_graph_t::occurrences_of_handle(const handle_t& handle, bool match_orientation) const {
+    return graph.occurrences_of_handle(handle, match_orientation);
+}
+
+void traced_graph_t::for_each_occurrence_in_path(const path_handle_t& path, const std::function<void(const occurrence_handle_t&)>& iteratee) const {
+    record(OP_WALK_PATH, path_index(path));
+    graph.for_each_occurrence_in_path(path, iteratee);
+}
+
+handle_t traced_graph_t::create_handle(const std::string& sequence) {
+    trace_record_t r;
+    r.op = OP_CREATE_HANDLE;
+    r.text = sequence;
+    trace.write(r);
+    return graph.create_handle(sequence);
+}
+
+handle_t traced_graph_t::create_handle(const std::string& sequence, const id_t& id) {
+    trace_record_t r;
+    r.op = OP_CREATE_HANDLE;
+    r.a = id;
+    r.text = sequence;
+    trace.write(r);
+    return graph.create_handle(sequence, id);
+}
+
+void traced_graph_t::create_edge(const handle_t& left, const handle_t& right) {
+    record(OP_CREATE_EDGE, encode(left), encode(right));
+    graph.create_edge(left, right);
+}
+
+void traced_graph_t::swap_handles(const handle_t& a, const handle_t& b) {
+    record(OP_SWAP_HANDLES, encode(a), encode(b));
+    graph.swap_handles(a, b);
+}
+
+handle_t traced_graph_t::apply_orientation(const handle_t& handle) {
+    record(OP_APPLY_ORIENTATION, encode(handle));
+    return graph.apply_orientation(handle);
+}
+
+std::vector<handle_t> traced_graph_t::divide_handle(const handle_t& handle, const std::vector<size_t>& offsets) {
+    trace_record_t r;
+    r.op = OP_DIVIDE_HANDLE;
+    r.a = encode(handle);
+    r.offsets.assign(offsets.begin(), offsets.end());
+    trace.write(r);
+    return graph.divide_handle(handle, offsets);
+}
+
+void traced_graph_t::destroy_handle(const handle_t& handle) {
+    record(OP_DESTROY_HANDLE, encode(handle));
+    graph.destroy_handle(handle);
+}
+
+void traced_graph_t::destroy_edge(const handle_t& left, const handle_t& right) {
+    record(OP_DESTROY_EDGE, encode(left), encode(right));
+    graph.destroy_edge(left, right);
+}
+
+void traced_graph_t::clear(void) {
+    record(OP_CLEAR);
+    graph.clear();
+}
+
+void traced_graph_t::destroy_path(const path_handle_t& path) {
+    record(OP_DESTROY_PATH, path_index(path));
+    graph.destroy_path(path);
+}
+
+path_handle_t traced_graph_t::create_path_handle(const std::string& name) {
+    record(OP_CREATE_PATH, trace.path_index(name));
+    return graph.create_path_handle(name);
+}
+
+occurrence_handle_t traced_graph_t::append_occurrence(const path_handle_t& path, const handle_t& to_append) {
+    record(OP_APPEND_OCCURRENCE, path_index(path), encode(to_append));
+    return graph.append_occurrence(path, to_append);
+}
+
+}
@@ -0,0 +1,303 @@
+#ifndef dgraph_trace_hpp
+#define dgraph_trace_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include "handle.hpp"
+#include "hash_map.hpp"
+#include "bench.hpp"
+
+/** \file
+ * trace.hpp: recording of the operations applied to a handle graph, and
+ * replay of the recorded operations against any graph implementation.
+ *
+ * A trace is the magic number and version, followed by one record per
+ * operation: an op code byte and then its arguments as LEB128 varints.
+ * Handles are recorded as id*2+is_reverse so that traces stay meaningful
+ * across reloads and backends. Paths are recorded by a small index, which
+ * is bound to the path's name by an OP_NAME_PATH record the first time the
+ * path appears. Occurrence handles are backend specific and aren't recorded;
+ * walking a path with for_each_occurrence_in_path is.
+ */
+
+namespace dg {
+
+/// Magic number opening every trace ("DGTRACE\0" in little-endian byte order)
+const uint64_t trace_format_magic = 0x0045434152544744ULL;
+
+/// Version of the trace layout
+const uint64_t trace_format_version = 1;
+
+/// The traced operations
+enum trace_op_t : uint8_t {
+    OP_NAME_PATH = 0,         // path index, name
+    OP_HAS_NODE,              // id
+    OP_GET_HANDLE,            // handle
+    OP_GET_LENGTH,            // handle
+    OP_GET_SEQUENCE,          // handle
+    OP_FOLLOW_EDGES,          // handle, go_left
+    OP_GET_DEGREE,            // handle, go_left
+    OP_FOR_EACH_HANDLE,       // parallel
+    OP_CREATE_HANDLE,         // id (0 to let the graph choose), sequence
+    OP_CREATE_EDGE,           // handle, handle
+    OP_DESTROY_HANDLE,        // handle
+    OP_DESTROY_EDGE,          // handle, handle
+    OP_SWAP_HANDLES,          // handle, handle
+    OP_APPLY_ORIENTATION,     // handle
+    OP_DIVIDE_HANDLE,         // handle, offset count, offsets
+    OP_CLEAR,                 //
+    OP_HAS_PATH,              // path index
+    OP_CREATE_PATH,           // path index
+    OP_DESTROY_PATH,          // path index
+    OP_APPEND_OCCURRENCE,     // path index, handle
+    OP_GET_OCCURRENCE_COUNT,  // path index
+    OP_WALK_PATH,             // path index
+    OP_COUNT                  // number of op codes
+};
+
+/// Printable name of an op code
+const char* trace_op_name(trace_op_t op);
+
+/// One decoded trace record. Handles are in their id*2+is_reverse form.
+struct trace_record_t {
+    trace_op_t op = OP_CLEAR;
+    /// first handle, id, path index or flag
+    uint64_t a = 0;
+    /// second handle or flag
+    uint64_t b = 0;
+    /// sequence or path name
+    std::string text;
+    /// offsets for divide_handle
+    std::vector<uint64_t> offsets;
+};
+
+/// Appends records to a trace stream. Safe to use from several threads.
+class trace_writer_t {
+public:
+    /// Start a trace on the stream, writing its header
+    trace_writer_t(std::ostream& out);
+    /// Flushes any buffered records
+    ~trace_writer_t(void);
+    /// Append a record
+    void write(const trace_record_t& record);
+    /// The index of the named path, naming it in the trace if it's new
+    uint64_t path_index(const std::string& name);
+    /// Push buffered records to the stream
+    void flush(void);
+private:
+    std::ostream& out;
+    std::string buffer;
+    std::mutex mutex;
+    string_hash_map<std::string, uint64_t> path_indexes;
+    void encode(const trace_record_t& record);
+};
+
+/// Reads records back from a trace stream
+class trace_reader_t {
+public:
+    /// Start reading a trace, checking its header. Throws if it isn't a trace.
+    trace_reader_t(std::istream& in);
+    /// Read the next record, returning false at the end of the trace
+    bool next(trace_record_t& record);
+private:
+    std::istream& in;
+};
+
+/**
+ * A graph that passes every call through to another graph, recording the
+ * calls that make up a workload in a trace. Tracing is opt-in: code that
+ * should be traced works against this wrapper instead of the graph itself.
+ */
+class traced_graph_t : public MutablePathDeletableHandleGraph {
+public:
+    traced_graph_t(MutablePathDeletableHandleGraph& graph, trace_writer_t& trace);
+
+    bool has_node(id_t node_id) const;
+    handle_t get_handle(const id_t& node_id, bool is_reverse = false) const;
+    id_t get_id(const handle_t& handle) const;
+    bool get_is_reverse(const handle_t& handle) const;
+    handle_t flip(const handle_t& handle) const;
+    size_t get_length(const handle_t& handle) const;
+    std::string get_sequence(const handle_t& handle) const;
+    bool follow_edges(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+    void for_each_handle(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+    size_t node_size(void) const;
+    id_t min_node_id(void) const;
+    id_t max_node_id(void) const;
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+    using HandleGraph::follow_edges;
+    using HandleGraph::for_each_handle;
+
+    bool has_path(const std::string& path_name) const;
+    path_handle_t get_path_handle(const std::string& path_name) const;
+    std::string get_path_name(const path_handle_t& path_handle) const;
+    size_t get_occurrence_count(const path_handle_t& path_handle) const;
+    size_t get_path_count(void) const;
+    void for_each_path_handle(const std::function<void(const path_handle_t&)>& iteratee) const;
+    handle_t get_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    occurrence_handle_t get_first_occurrence(const path_handle_t& path_handle) const;
+    occurrence_handle_t get_last_occurrence(const path_handle_t& path_handle) const;
+    bool has_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    bool has_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    occurrence_handle_t get_next_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    occurrence_handle_t get_previous_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    path_handle_t get_path_handle_of_occurrence(const occurrence_handle_t& occurrence_handle) const;
+    std::vector<occurrence_handle_t> occurrences_of_handle(const handle_t& handle, bool match_orientation = false) const;
+    void for_each_occurrence_in_path(const path_handle_t& path, const std::function<void(const occurrence_handle_t&)>& iteratee) const;
+
+    handle_t create_handle(const std::string& sequence);
+    handle_t create_handle(const std::string& sequence, const id_t& id);
+    void create_edge(const handle_t& left, const handle_t& right);
+    void swap_handles(const handle_t& a, const handle_t& b);
+    handle_t apply_orientation(const handle_t& handle);
+    std::vector<handle_t> divide_handle(const handle_t& handle, const std::vector<size_t>& offsets);
+    void destroy_handle(const handle_t& handle);
+    void destroy_edge(const handle_t& left, const handle_t& right);
+    void clear(void);
+
+    void destroy_path(const path_handle_t& path);
+    path_handle_t create_path_handle(const std::string& name);
+    occurrence_handle_t append_occurrence(const path_handle_t& path, const handle_t& to_append);
+
+private:
+    MutablePathDeletableHandleGraph& graph;
+    trace_writer_t& trace;
+    /// Encode a handle of the wrapped graph for the trace
+    uint64_t encode(const handle_t& handle) const;
+    /// The trace's index for a path of the wrapped graph
+    uint64_t path_index(const path_handle_t& path) const;
+    void record(trace_op_t op, uint64_t a = 0, uint64_t b = 0) const;
+};
+
+/// Replay a trace against a graph, timing each kind of operation. Works with
+/// any graph offering the mutable path handle graph methods, virtual or not.
+/// Returns one result per op code that occurred, in op code order.
+template<class Graph>
+std::vector<bench_result_t> replay_trace(std::istream& in, Graph& graph) {
+    trace_reader_t reader(in);
+    std::vector<bench_result_t> results(OP_COUNT);
+    for (uint8_t i = 0; i < OP_COUNT; ++i) {
+        results[i].name = trace_op_name((trace_op_t)i);
+    }
+    std::vector<std::string> path_names;
+    uint64_t sink = 0;
+    auto handle = [&](uint64_t h) {
+        return graph.get_handle(h >> 1, h & 1);
+    };
+    auto path = [&](uint64_t i) -> const std::string& {
+        if (i >= path_names.size()) {
+            throw std::runtime_error("[dg::replay] reference to unnamed path " + std::to_string(i));
+        }
+        return path_names[i];
+    };
+    trace_record_t r;
+    while (reader.next(r)) {
+        auto start = std::chrono::steady_clock::now();
+        switch (r.op) {
+        case OP_NAME_PATH:
+            if (path_names.size() <= r.a) path_names.resize(r.a + 1);
+            path_names[r.a] = r.text;
+            break;
+        case OP_HAS_NODE:
+            sink += graph.has_node(r.a);
+            break;
+        case OP_GET_HANDLE:
+            sink += as_integer(handle(r.a));
+            break;
+        case OP_GET_LENGTH:
+            sink += graph.get_length(handle(r.a));
+            break;
+        case OP_GET_SEQUENCE:
+            sink += graph.get_sequence(handle(r.a)).size();
+            break;
+        case OP_FOLLOW_EDGES:
+            graph.follow_edges(handle(r.a), r.b, [&](const handle_t& h) {
+                    sink += as_integer(h);
+                    return true;
+                });
+            break;
+        case OP_GET_DEGREE:
+            sink += graph.get_degree(handle(r.a), r.b);
+            break;
+        case OP_FOR_EACH_HANDLE:
+            graph.for_each_handle([&](const handle_t& h) {
+                    return true;
+                }, r.a);
+            break;
+        case OP_CREATE_HANDLE:
+            if (r.a) {
+                graph.create_handle(r.text, r.a);
+            } else {
+                graph.create_handle(r.text);
+            }
+            break;
+        case OP_CREATE_EDGE:
+            graph.create_edge(handle(r.a), handle(r.b));
+            break;
+        case OP_DESTROY_HANDLE:
+            graph.destroy_handle(handle(r.a));
+            break;
+        case OP_DESTROY_EDGE:
+            graph.destroy_edge(handle(r.a), handle(r.b));
+            break;
+        case OP_SWAP_HANDLES:
+            graph.swap_handles(handle(r.a), handle(r.b));
+            break;
+        case OP_APPLY_ORIENTATION:
+            graph.apply_orientation(handle(r.a));
+            break;
+        case OP_DIVIDE_HANDLE:
+            graph.divide_handle(handle(r.a), std::vector<size_t>(r.offsets.begin(), r.offsets.end()));
+            break;
+        case OP_CLEAR:
+            graph.clear();
+            break;
+        case OP_HAS_PATH:
+            sink += graph.has_path(path(r.a));
+            break;
+        case OP_CREATE_PATH:
+            graph.create_path_handle(path(r.a));
+            break;
+        case OP_DESTROY_PATH:
+            graph.destroy_path(graph.get_path_handle(path(r.a)));
+            break;
+        case OP_APPEND_OCCURRENCE:
+            graph.append_occurrence(graph.get_path_handle(path(r.a)), handle(r.b));
+            break;
+        case OP_GET_OCCURRENCE_COUNT:
+            sink += graph.get_occurrence_count(graph.get_path_handle(path(r.a)));
+            break;
+        case OP_WALK_PATH:
+            graph.for_each_occurrence_in_path(graph.get_path_handle(path(r.a)), [&](const occurrence_handle_t& occ) {
+                    sink += as_integer(graph.get_occurrence(occ));
+                });
+            break;
+        default:
+            throw std::runtime_error("[dg::replay] unknown op code " + std::to_string(r.op));
+        }
+        auto end = std::chrono::steady_clock::now();
+        results[r.op].seconds += std::chrono::duration<double>(end - start).count();
+        ++results[r.op].ops;
+    }
+    // keep the results of the queries alive
+    volatile uint64_t keep = sink;
+    (void)keep;
+    std::vector<bench_result_t> seen;
+    uint64_t peak_rss = peak_rss_bytes();
+    for (auto& result : results) {
+        if (result.ops && result.name != trace_op_name(OP_NAME_PATH)) {
+            result.peak_rss = peak_rss;
+            seen.push_back(result);
+        }
+    }
+    return seen;
+}
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+//
+//  traverse.cpp
+//
+
+#include "traverse.hpp"
+#include <algorithm>
+
+namespace dg {
+
+void rank_bitset_t::reset(uint64_t size) {
+    n = size;
+    words.assign((size + 63) / 64, 0);
+}
+
+uint64_t rank_bitset_t::count(void) const {
+    uint64_t c = 0;
+    for (auto& word : words) {
+        c += __builtin_popcountll(word);
+    }
+    return c;
+}
+
+bfs_levels_t bfs(const graph_t& graph, const std::vector<handle_t>& seeds, uint64_t max_steps) {
+    bfs_levels_t levels;
+    levels.level_offsets.push_back(0);
+    uint64_t node_count = graph.node_size();
+    rank_bitset_t visited(node_count);
+    std::vector<handle_t> frontier;
+    for (auto& seed : seeds) {
+        uint64_t rank = handle_helper::unpack_number(seed);
+        if (visited.set(rank)) {
+            frontier.push_back(handle_helper::pack(rank, false));
+        }
+    }
+    // frontier nodes expanded together by one thread
+    const uint64_t batch_size = 1024;
+    // go bottom-up once the frontier holds more than this fraction of the graph
+    const uint64_t bottom_up_share = 20;
+    rank_bitset_t in_frontier;
+    uint64_t depth = 0;
+    while (!frontier.empty()) {
+        levels.nodes.insert(levels.nodes.end(), frontier.begin(), frontier.end());
+        levels.level_offsets.push_back(levels.nodes.size());
+        if (depth == max_steps) break;
+        ++depth;
+        std::vector<handle_t> next;
+        if (frontier.size() * bottom_up_share > node_count) {
+            in_frontier.reset(node_count);
+            for (auto& h : frontier) {
+                in_frontier.set(handle_helper::unpack_number(h));
+            }
+            auto outside = [&](const handle_t& h) {
+                return !in_frontier.test(handle_helper::unpack_number(h));
+            };
+#pragma omp parallel
+            {
+                std::vector<handle_t> found;
+#pragma omp for schedule(dynamic, 4096)
+                for (uint64_t rank = 0; rank < node_count; ++rank) {
+                    if (visited.test(rank)) continue;
+                    handle_t h = handle_helper::pack(rank, false);
+                    // each thread only sets the bits of its own ranks here
+                    if (!graph.follow_edges_fast(h, false, outside) || !graph.follow_edges_fast(h, true, outside)) {
+                        visited.set(rank);
+                        found.push_back(h);
+                    }
+                }
+#pragma omp critical
+                next.insert(next.end(), found.begin(), found.end());
+            }
+        } else {
+            uint64_t batch_count = (frontier.size() + batch_size - 1) / batch_size;
+#pragma omp parallel
+            {
+                std::vector<handle_t> found;
+                neighbor_batch_t batch;
+#pragma omp for schedule(dynamic, 1)
+                for (uint64_t b = 0; b < batch_count; ++b) {
+                    uint64_t begin = b * batch_size;
+                    uint64_t n = std::min(batch_size, frontier.size() - begin);
+                    for (bool go_left : {false, true}) {
+                        graph.follow_edges_batch(frontier.data() + begin, n, go_left, batch);
+                        for (auto& h : batch.handles) {
+                            uint64_t rank = handle_helper::unpack_number(h);
+                            if (visited.set(rank)) {
+                                found.push_back(handle_helper::pack(rank, false));
+                            }
+                        }
+                    }
+                }
+#pragma omp critical
+                next.insert(next.end(), found.begin(), found.end());
+            }
+        }
+        frontier.swap(next);
+    }
+    return levels;
+}
+
+void dfs(const graph_t& graph, const std::vector<handle_t>& starts,
+         const std::function<void(const handle_t&)>& pre,
+         const std::function<void(const handle_t&)>& post) {
+    rank_bitset_t visited(graph.node_size());
+    // a frame's successors are next[begin] up to next[end], of which those
+    // from cursor on are unexplored; a child's successors go after its
+    // parent's and are dropped when it is popped
+    struct frame_t {
+        handle_t handle;
+        uint64_t begin;
+        uint64_t cursor;
+        uint64_t end;
+    };
+    std::vector<frame_t> stack;
+    std::vector<handle_t> next;
+    auto enter = [&](const handle_t& h) {
+        if (pre) pre(h);
+        uint64_t begin = next.size();
+        graph.follow_edges_fast(h, false, [&](const handle_t& n) {
+                next.push_back(n);
+            });
+        stack.push_back({h, begin, begin, next.size()});
+    };
+    for (auto& start : starts) {
+        if (!visited.set(handle_helper::unpack_number(start))) continue;
+        enter(start);
+        while (!stack.empty()) {
+            frame_t& top = stack.back();
+            if (top.cursor < top.end) {
+                handle_t h = next[top.cursor++];
+                if (visited.set(handle_helper::unpack_number(h))) {
+                    enter(h);
+                }
+            } else {
+                handle_t h = top.handle;
+                next.resize(top.begin);
+                stack.pop_back();
+                if (post) post(h);
+            }
+        }
+    }
+}
+
+void expand_context(const graph_t& graph, const handle_t& seed, const context_params_t& params,
+                    context_scratch_t& scratch, std::vector<handle_t>& nodes) {
+    nodes.clear();
+    if (scratch.visited.size() != graph.node_size()) {
+        scratch.visited.reset(graph.node_size());
+        scratch.stepped.reset(graph.node_size());
+    }
+    auto& queue = scratch.queue;
+    queue.clear();
+    uint64_t seed_rank = handle_helper::unpack_number(seed);
+    auto visit = [&](uint64_t rank) {
+        if (scratch.visited.set(rank)) {
+            scratch.touched.push_back(rank);
+            return true;
+        }
+        return false;
+    };
+    if (!params.max_bp) {
+        // breadth-first by steps; the queue holds rank and depth
+        visit(seed_rank);
+        queue.push_back(std::make_pair(seed_rank, 0));
+        for (uint64_t i = 0; i < queue.size(); ++i) {
+            uint64_t rank = queue[i].first;
+            uint64_t depth = queue[i].second;
+            handle_t h = handle_helper::pack(rank, false);
+            nodes.push_back(h);
+            if (depth == params.max_steps) continue;
+            for (bool go_left : {false, true}) {
+                graph.follow_edges_fast(h, go_left, [&](const handle_t& n) {
+                        uint64_t next = handle_helper::unpack_number(n);
+                        if (visit(next)) {
+                            queue.push_back(std::make_pair(next, depth + 1));
+                        }
+                    });
+            }
+        }
+    } else {
+        // shortest gap in bases first; the queue is a heap of gap and rank,
+        // and a node is visited when it is first popped
+        std::greater<std::pair<uint64_t, uint64_t>> later;
+        queue.push_back(std::make_pair(0, seed_rank));
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), later);
+            uint64_t gap = queue.back().first;
+            uint64_t rank = queue.back().second;
+            queue.pop_back();
+            if (!visit(rank)) continue;
+            handle_t h = handle_helper::pack(rank, false);
+            nodes.push_back(h);
+            // the seed's neighbors are adjacent to it; others are past this node
+            uint64_t through = rank == seed_rank ? 0 : gap + graph.get_length(h);
+            if (through > params.max_bp) continue;
+            for (bool go_left : {false, true}) {
+                graph.follow_edges_fast(h, go_left, [&](const handle_t& n) {
+                        uint64_t next = handle_helper::unpack_number(n);
+                        if (!scratch.visited.test(next)) {
+                            queue.push_back(std::make_pair(through, next));
+                            std::push_heap(queue.begin(), queue.end(), later);
+                        }
+                    });
+            }
+        }
+        // then breadth-first by steps, through the nodes already collected,
+        // for any the bases left out; the queue holds rank and depth again
+        if (params.max_steps > 1) {
+            scratch.stepped.set(seed_rank);
+            queue.push_back(std::make_pair(seed_rank, 0));
+            for (uint64_t i = 0; i < queue.size(); ++i) {
+                uint64_t rank = queue[i].first;
+                uint64_t depth = queue[i].second;
+                handle_t h = handle_helper::pack(rank, false);
+                if (visit(rank)) nodes.push_back(h);
+                if (depth == params.max_steps) continue;
+                for (bool go_left : {false, true}) {
+                    graph.follow_edges_fast(h, go_left, [&](const handle_t& n) {
+                            uint64_t next = handle_helper::unpack_number(n);
+                            if (scratch.stepped.set(next)) {
+                                queue.push_back(std::make_pair(next, depth + 1));
+                            }
+                        });
+                }
+            }
+            for (auto& q : queue) {
+                scratch.stepped.unset(q.first);
+            }
+        }
+    }
+    for (auto rank : scratch.touched) {
+        scratch.visited.unset(rank);
+    }
+    scratch.touched.clear();
+}
+
+void for_each_context(const graph_t& graph, const std::vector<handle_t>& seeds,
+                      const context_params_t& params,
+                      const std::function<void(uint64_t, const std::vector<handle_t>&)>& callback) {
+#pragma omp parallel
+    {
+        context_scratch_t scratch;
+        std::vector<handle_t> nodes;
+#pragma omp for schedule(dynamic, 256)
+        for (uint64_t i = 0; i < seeds.size(); ++i) {
+            expand_context(graph, seeds[i], params, scratch, nodes);
+            callback(i, nodes);
+        }
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+#ifndef dgraph_traverse_hpp
+#define dgraph_traverse_hpp
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include "graph.hpp"
+
+/** \file
+ * traverse.hpp: breadth-first, depth-first and bounded context traversals
+ * of a graph_t.
+ *
+ * graph_t handles carry the node's internal rank, so visited state lives in
+ * a dense bitset over ranks rather than in a hash set of handles. Breadth
+ * first search and context expansion treat the graph as undirected and
+ * report nodes in their forward orientation. Depth-first search follows
+ * edges off the right side of oriented handles.
+ */
+
+namespace dg {
+
+/// A dense bitset over node ranks that several threads can set at once
+class rank_bitset_t {
+public:
+    rank_bitset_t(uint64_t size = 0) : n(size), words((size + 63) / 64, 0) { }
+
+    /// Cover this many ranks, with every bit clear
+    void reset(uint64_t size);
+
+    /// The number of ranks covered
+    inline uint64_t size(void) const { return n; }
+
+    /// Is the bit for this rank set
+    inline bool test(uint64_t rank) const {
+        return __atomic_load_n(&words[rank >> 6], __ATOMIC_RELAXED) >> (rank & 63) & 1;
+    }
+
+    /// Set the bit for this rank. Returns true if it was clear, so that only
+    /// one of several threads setting the same bit sees true.
+    inline bool set(uint64_t rank) {
+        uint64_t mask = 1ULL << (rank & 63);
+        return !(__atomic_fetch_or(&words[rank >> 6], mask, __ATOMIC_RELAXED) & mask);
+    }
+
+    /// Clear the bit for this rank. Not safe alongside other threads.
+    inline void unset(uint64_t rank) {
+        words[rank >> 6] &= ~(1ULL << (rank & 63));
+    }
+
+    /// The number of bits set
+    uint64_t count(void) const;
+
+private:
+    uint64_t n;
+    std::vector<uint64_t> words;
+};
+
+/// The nodes reached by a breadth-first search, by level: the nodes at
+/// distance d from the seeds are nodes[level_offsets[d]] up to
+/// nodes[level_offsets[d+1]]
+struct bfs_levels_t {
+    std::vector<handle_t> nodes;
+    std::vector<uint64_t> level_offsets;
+
+    /// The number of levels reached, the seeds being level 0
+    inline uint64_t level_count(void) const {
+        return level_offsets.empty() ? 0 : level_offsets.size() - 1;
+    }
+};
+
+/// Search breadth-first from the seeds, along the edges on both sides of
+/// each node, out to max_steps edges away. Levels are expanded in parallel,
+/// a batch of frontier nodes at a time. When the frontier holds a large
+/// share of the graph, a level is found bottom-up instead, by checking each
+/// unvisited node for a neighbor in the frontier. The order of the nodes
+/// within a level is not defined.
+bfs_levels_t bfs(const graph_t& graph, const std::vector<handle_t>& seeds,
+                 uint64_t max_steps = UINT64_MAX);
+
+/// Search depth-first along the edges off the right side of oriented
+/// handles, from each start in turn, without recursion. Each node is entered
+/// once, in the orientation it is first reached in. pre is called on a
+/// handle when it is entered and post once everything reachable from it has
+/// been; either may be empty.
+void dfs(const graph_t& graph, const std::vector<handle_t>& starts,
+         const std::function<void(const handle_t&)>& pre,
+         const std::function<void(const handle_t&)>& post);
+
+/// Bounds on the context around a seed node. A node is in the context if it
+/// is within max_steps edges of the seed or, when max_bp is set, if no more
+/// than max_bp bases lie between it and the seed. Both ignore orientation.
+/// The seed's neighbors have no bases between them and it, so a max_steps of
+/// 1 adds nothing to a max_bp bound.
+struct context_params_t {
+    uint64_t max_steps = 1;
+    uint64_t max_bp = 0;
+};
+
+/// Working space for context expansions. Many small expansions can share
+/// one, since it only clears the visited bits that each one set.
+struct context_scratch_t {
+    rank_bitset_t visited;
+    rank_bitset_t stepped;
+    std::vector<uint64_t> touched;
+    std::vector<std::pair<uint64_t, uint64_t>> queue;
+};
+
+/// Collect the context of a seed into nodes, as forward handles with the
+/// seed first and the rest in order of distance. Under both bounds, the
+/// nodes within max_bp come first, then the others within max_steps.
+void expand_context(const graph_t& graph, const handle_t& seed, const context_params_t& params,
+                    context_scratch_t& scratch, std::vector<handle_t>& nodes);
+
+/// Expand the context of every seed, in parallel. The callback gets the
+/// index of each seed and its context, and is called from several threads
+/// at once.
+void for_each_context(const graph_t& graph, const std::vector<handle_t>& seeds,
+                      const context_params_t& params,
+                      const std::function<void(uint64_t, const std::vector<handle_t>&)>& callback);
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef dgraph_union_find_hpp
+#define dgraph_union_find_hpp
+
+#include <cstdint>
+#include <vector>
+
+/** \file
+ * union_find.hpp: a lock-free disjoint set forest over dense integers.
+ *
+ * Any number of threads may call unite and find at once. Parents are only
+ * ever swung with compare-and-swap, a root is always linked under a smaller
+ * root, and finds halve the paths they walk. Since links only go downward,
+ * the root of every set ends up being its smallest member, whatever order
+ * the unions happened in.
+ */
+
+namespace dg {
+
+class concurrent_union_find_t {
+public:
+    /// Put each of 0 up to size in a set of its own
+    concurrent_union_find_t(uint64_t size = 0) {
+        reset(size);
+    }
+
+    inline void reset(uint64_t size) {
+        parent.resize(size);
+        for (uint64_t i = 0; i < size; ++i) {
+            parent[i] = i;
+        }
+    }
+
+    inline uint64_t size(void) const {
+        return parent.size();
+    }
+
+    /// The smallest member of the set holding x
+    inline uint64_t find(uint64_t x) {
+        while (true) {
+            uint64_t p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+            if (p == x) return x;
+            uint64_t gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+            if (p != gp) {
+                // halve the path; losing the race to another thread is fine
+                __atomic_compare_exchange_n(&parent[x], &p, gp, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            }
+            x = gp;
+        }
+    }
+
+    /// Merge the sets holding a and b
+    inline void unite(uint64_t a, uint64_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            // a is still a root unless another thread linked it first
+            uint64_t expected = a;
+            if (__atomic_compare_exchange_n(&parent[a], &expected, b, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> parent;
+};
+
+}
+
+#endif
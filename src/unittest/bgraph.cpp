@@ -0,0 +1,207 @@
+/**
+ * \file
+ * unittest/bgraph.cpp: test cases for the uncompressed BGraph backend.
+ */
+
+#include "catch.hpp"
+
+#include "bgraph.hpp"
+#include "graph.hpp"
+#include "simulate.hpp"
+
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+using betagraph::BGraph;
+
+typedef tuple<id_t, bool, id_t, bool> id_edge_t;
+
+/// Every edge of the graph by ids and orientations, in a form that does not
+/// depend on the strand it is read from
+static set<id_edge_t> edges_by_id(const HandleGraph& graph) {
+    set<id_edge_t> edges;
+    graph.for_each_handle([&](const handle_t& h) {
+            for (bool go_left : {false, true}) {
+                graph.follow_edges(h, go_left, [&](const handle_t& next) {
+                        handle_t left = go_left ? next : h;
+                        handle_t right = go_left ? h : next;
+                        id_edge_t e(graph.get_id(left), graph.get_is_reverse(left),
+                                    graph.get_id(right), graph.get_is_reverse(right));
+                        id_edge_t r(graph.get_id(right), !graph.get_is_reverse(right),
+                                    graph.get_id(left), !graph.get_is_reverse(left));
+                        edges.insert(min(e, r));
+                    });
+            }
+        });
+    return edges;
+}
+
+/// The sequence spelled by a path
+static string path_sequence(const PathHandleGraph& graph, const path_handle_t& path) {
+    string seq;
+    graph.for_each_occurrence_in_path(path, [&](const occurrence_handle_t& occ) {
+            seq += graph.get_sequence(graph.get_occurrence(occ));
+        });
+    return seq;
+}
+
+TEST_CASE("BGraph stores nodes, edges and paths", "[bgraph]") {
+
+    BGraph graph;
+    handle_t h1 = graph.create_handle("GATT", 1);
+    handle_t h2 = graph.create_handle("ACA", 2);
+    handle_t h3 = graph.create_handle("CA");
+    graph.create_edge(h1, h2);
+    graph.create_edge(h2, graph.flip(h3));
+    graph.create_edge(h3, graph.flip(h3));
+    graph.create_edge(h1, h2);
+    path_handle_t p = graph.create_path_handle("x");
+    graph.append_occurrence(p, h1);
+    graph.append_occurrence(p, h2);
+    graph.append_occurrence(p, graph.flip(h3));
+
+    SECTION("Nodes are found by id in either orientation") {
+        REQUIRE(graph.node_size() == 3);
+        REQUIRE(graph.has_node(3));
+        REQUIRE(!graph.has_node(4));
+        REQUIRE(graph.get_id(h3) == 3);
+        REQUIRE(graph.get_sequence(graph.get_handle(1, true)) == "AATC");
+        REQUIRE(graph.get_length(graph.get_handle(2)) == 3);
+        REQUIRE(graph.min_node_id() == 1);
+        REQUIRE(graph.max_node_id() == 3);
+    }
+
+    SECTION("Edges are seen from both ends and duplicates are ignored") {
+        REQUIRE(graph.edge_size() == 3);
+        REQUIRE(graph.has_edge(graph.flip(h2), graph.flip(h1)));
+        REQUIRE(graph.has_edge(h3, graph.flip(h2)));
+        REQUIRE(graph.has_edge(h3, graph.flip(h3)));
+        REQUIRE(graph.get_degree(h3, false) == 2);
+        REQUIRE(graph.get_degree(h3, true) == 0);
+        REQUIRE(graph.get_degree(h2, true) == 1);
+        graph.destroy_edge(h3, graph.flip(h3));
+        graph.destroy_edge(h3, graph.flip(h3));
+        REQUIRE(graph.edge_size() == 2);
+        REQUIRE(graph.get_degree(h3, false) == 1);
+    }
+
+    SECTION("Paths can be walked in both directions") {
+        REQUIRE(graph.get_path_count() == 1);
+        REQUIRE(graph.get_occurrence_count(p) == 3);
+        REQUIRE(path_sequence(graph, p) == "GATTACATG");
+        occurrence_handle_t occ = graph.get_last_occurrence(p);
+        REQUIRE(!graph.has_next_occurrence(occ));
+        occ = graph.get_previous_occurrence(occ);
+        REQUIRE(graph.get_occurrence(occ) == h2);
+        REQUIRE(graph.occurrences_of_handle(h3, true).empty());
+        REQUIRE(graph.occurrences_of_handle(h3).size() == 1);
+        graph.destroy_path(p);
+        REQUIRE(!graph.has_path("x"));
+        REQUIRE(graph.get_path_count() == 0);
+        REQUIRE(graph.occurrences_of_handle(h2).empty());
+    }
+
+    SECTION("Swapping and reorienting nodes keep the graph the same") {
+        set<id_edge_t> before = edges_by_id(graph);
+        graph.swap_handles(h1, h3);
+        REQUIRE(graph.get_sequence(graph.get_handle(3)) == "CA");
+        REQUIRE(edges_by_id(graph) == before);
+        REQUIRE(path_sequence(graph, p) == "GATTACATG");
+        handle_t h = graph.apply_orientation(graph.get_handle(2, true));
+        REQUIRE(graph.get_sequence(h) == "TGT");
+        REQUIRE(path_sequence(graph, p) == "GATTACATG");
+        REQUIRE(graph.has_edge(graph.get_handle(1), graph.flip(h)));
+        REQUIRE(graph.has_edge(graph.get_handle(3), h));
+        graph.apply_orientation(graph.get_handle(3, true));
+        REQUIRE(graph.has_edge(graph.get_handle(3, true), graph.get_handle(3)));
+    }
+
+    SECTION("Dividing a node keeps its edges and the paths through it") {
+        vector<handle_t> parts = graph.divide_handle(graph.flip(h1), {1, 3});
+        REQUIRE(parts.size() == 3);
+        REQUIRE(graph.get_sequence(parts[0]) == "A");
+        REQUIRE(graph.get_sequence(parts[1]) == "AT");
+        REQUIRE(graph.get_sequence(parts[2]) == "C");
+        REQUIRE(graph.has_edge(parts[0], parts[1]));
+        REQUIRE(graph.has_edge(graph.flip(h2), parts[0]));
+        REQUIRE(graph.node_size() == 5);
+        REQUIRE(graph.get_occurrence_count(p) == 5);
+        REQUIRE(path_sequence(graph, p) == "GATTACATG");
+        graph.divide_handle(h2, 1);
+        REQUIRE(path_sequence(graph, p) == "GATTACATG");
+    }
+
+    SECTION("Destroyed nodes take their edges with them") {
+        graph.destroy_path(p);
+        graph.destroy_handle(h2);
+        REQUIRE(graph.node_size() == 2);
+        REQUIRE(!graph.has_node(2));
+        REQUIRE(graph.edge_size() == 1);
+        REQUIRE(graph.get_degree(h1, false) == 0);
+        graph.compact();
+        REQUIRE(graph.get_sequence(graph.get_handle(3)) == "CA");
+        REQUIRE(graph.has_edge(h3, graph.flip(h3)));
+        size_t count = 0;
+        graph.for_each_handle([&](const handle_t& h) { ++count; });
+        REQUIRE(count == 2);
+    }
+}
+
+TEST_CASE("BGraph matches graph_t on a simulated graph", "[bgraph]") {
+
+    simulate_params_t params;
+    params.length = 5000;
+    params.path_count = 3;
+    graph_t reference;
+    simulate_graph(params, reference);
+
+    BGraph graph;
+    simulate_graph(params,
+                   [&](uint64_t id, const string& seq) {
+                       graph.create_handle(seq, id);
+                   },
+                   [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                       graph.create_edge(graph.get_handle(from_id, from_rev), graph.get_handle(to_id, to_rev));
+                   },
+                   [&](const string& path_name, uint64_t id, bool is_rev) {
+                       if (!graph.has_path(path_name)) {
+                           graph.create_path_handle(path_name);
+                       }
+                       graph.append_occurrence(graph.get_path_handle(path_name), graph.get_handle(id, is_rev));
+                   });
+
+    REQUIRE(graph.node_size() == reference.node_size());
+    REQUIRE(edges_by_id(graph) == edges_by_id(reference));
+    reference.for_each_path_handle([&](const path_handle_t& p) {
+            string name = reference.get_path_name(p);
+            REQUIRE(path_sequence(graph, graph.get_path_handle(name)) == path_sequence(reference, p));
+        });
+
+    // splitting every node leaves the paths spelling the same sequence
+    vector<string> before;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+            before.push_back(path_sequence(graph, p));
+        });
+    vector<handle_t> handles;
+    graph.for_each_handle([&](const handle_t& h) { handles.push_back(h); });
+    for (auto& h : handles) {
+        if (graph.get_length(h) > 1) {
+            graph.divide_handle(graph.flip(h), 1);
+        }
+    }
+    graph.compact();
+    vector<string> after;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+            after.push_back(path_sequence(graph, p));
+        });
+    REQUIRE(before == after);
+}
+
+}
+}
@@ -0,0 +1,150 @@
+/**
+ * \file
+ * unittest/chop.cpp: test cases for splitting nodes.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "simulate.hpp"
+#include "helpers.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// The number of edges, each counted once
+static uint64_t edge_count(graph_t& graph) {
+    uint64_t count = 0;
+    graph.for_each_edge([&](const edge_t& e) { ++count; return true; });
+    return count;
+}
+
+TEST_CASE("Chop splits every long node and keeps the paths", "[chop]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATTACA", 1);
+    handle_t b = graph.create_handle("CAT", 2);
+    handle_t c = graph.create_handle("TTAGGC", 3);
+    graph.create_edge(a, b);
+    graph.create_edge(b, graph.flip(c));
+    graph.create_edge(a, graph.flip(c));
+    // a self edge on the left of the first node
+    graph.create_edge(graph.flip(a), a);
+    path_handle_t x = graph.create_path_handle("x");
+    graph.append_occurrence(x, a);
+    graph.append_occurrence(x, b);
+    graph.append_occurrence(x, graph.flip(c));
+    auto before = path_sequences(graph);
+
+    graph.chop(3);
+    REQUIRE(graph.node_size() == 3 + 1 + 2);
+    graph.for_each_handle([&](const handle_t& h) {
+            REQUIRE(graph.get_length(h) <= 3);
+        });
+    // the first pieces keep the ids, and the others count up from the largest
+    REQUIRE(graph.get_sequence(graph.get_handle(1)) == "GAT");
+    REQUIRE(graph.get_sequence(graph.get_handle(4)) == "TAC");
+    REQUIRE(graph.get_sequence(graph.get_handle(5)) == "A");
+    REQUIRE(graph.get_sequence(graph.get_handle(3)) == "TTA");
+    REQUIRE(graph.get_sequence(graph.get_handle(6)) == "GGC");
+    REQUIRE(graph.has_edge(graph.get_handle(5), graph.get_handle(2)));
+    REQUIRE(graph.has_edge(graph.get_handle(2), graph.get_handle(6, true)));
+    REQUIRE(graph.has_edge(graph.get_handle(5), graph.get_handle(6, true)));
+    REQUIRE(graph.has_edge(graph.get_handle(1, true), graph.get_handle(1)));
+    REQUIRE(edge_count(graph) == 4 + 3);
+    REQUIRE(graph.get_occurrence_count(graph.get_path_handle("x")) == 6);
+    REQUIRE(path_sequences(graph) == before);
+}
+
+TEST_CASE("Chop keeps the pieces of hidden nodes hidden", "[chop]") {
+
+    graph_t graph;
+    graph.create_handle("GATTACA", 1);
+    handle_t h = graph.create_hidden_handle("CCGGTTA");
+    REQUIRE(graph.get_id(h) == 2);
+    REQUIRE(!graph.has_node(2));
+
+    graph.chop(3);
+    REQUIRE(graph.node_size() == 6);
+    // node 1 becomes 1, 3 and 4, and node 2 becomes 2, 5 and 6
+    for (id_t id : {1, 3, 4}) {
+        REQUIRE(graph.has_node(id));
+    }
+    for (id_t id : {2, 5, 6}) {
+        REQUIRE(!graph.has_node(id));
+    }
+    REQUIRE(graph.get_sequence(graph.get_handle(6)) == "A");
+    graph_t copy = graph;
+    REQUIRE(!copy.has_node(5));
+    REQUIRE(copy.has_node(4));
+}
+
+TEST_CASE("Unchopping a chopped graph gives the unchopped graph", "[chop]") {
+
+    simulate_params_t params;
+    params.length = 20000;
+    params.node_length = 40;
+    params.inversion_rate = 0.002;
+    params.path_count = 3;
+    graph_t graph;
+    simulate_graph(params, graph);
+    auto before = path_sequences(graph);
+
+    graph_t chopped = graph;
+    chopped.chop(7);
+    chopped.for_each_handle([&](const handle_t& h) {
+            REQUIRE(chopped.get_length(h) <= 7);
+        });
+    REQUIRE(chopped.node_size() > graph.node_size());
+    REQUIRE(path_sequences(chopped) == before);
+
+    graph.unchop();
+    chopped.unchop();
+    REQUIRE(chopped.node_size() == graph.node_size());
+    REQUIRE(edge_count(chopped) == edge_count(graph));
+    REQUIRE(path_sequences(chopped) == before);
+}
+
+TEST_CASE("Dividing a handle splits it in place", "[chop]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GAT", 1);
+    handle_t b = graph.create_handle("TACAGA", 2);
+    handle_t c = graph.create_handle("TTACA", 3);
+    graph.create_edge(a, b);
+    graph.create_edge(b, c);
+    graph.create_edge(a, c);
+    path_handle_t x = graph.create_path_handle("x");
+    graph.append_occurrence(x, a);
+    graph.append_occurrence(x, b);
+    graph.append_occurrence(x, c);
+    path_handle_t y = graph.create_path_handle("y");
+    graph.append_occurrence(y, graph.flip(c));
+    graph.append_occurrence(y, graph.flip(b));
+    auto before = path_sequences(graph);
+
+    // offsets are taken along the handle given
+    vector<handle_t> parts = graph.divide_handle(graph.flip(b), {2, 4});
+    REQUIRE(parts.size() == 3);
+    REQUIRE(graph.get_sequence(parts[0]) == "TC");
+    REQUIRE(graph.get_sequence(parts[1]) == "TG");
+    REQUIRE(graph.get_sequence(parts[2]) == "TA");
+    REQUIRE(graph.node_size() == 5);
+    REQUIRE(!graph.has_node(2));
+    REQUIRE(graph.has_edge(a, graph.flip(parts[2])));
+    REQUIRE(graph.has_edge(graph.flip(parts[0]), graph.get_handle(3)));
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(3)));
+    REQUIRE(edge_count(graph) == 5);
+    REQUIRE(path_sequences(graph) == before);
+    REQUIRE(graph.get_occurrence_count(graph.get_path_handle("x")) == 5);
+    REQUIRE(graph.get_occurrence_count(graph.get_path_handle("y")) == 4);
+}
+
+}
+}
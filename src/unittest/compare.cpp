@@ -0,0 +1,75 @@
+/**
+ * \file
+ * unittest/compare.cpp: test cases for the cross-backend comparison.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "bgraph.hpp"
+#include "compare.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Every backend runs the same comparison workload", "[compare]") {
+
+    gfa_records_t gfa;
+    gfa.nodes = {{1, "GATT"}, {2, "ACA"}, {3, "T"}, {4, "CA"}};
+    gfa.edges = {make_tuple(1, false, 2, false), make_tuple(1, false, 3, false),
+                 make_tuple(2, false, 4, false), make_tuple(3, false, 4, true)};
+    gfa.paths = {{"x", {{1, false}, {2, false}, {4, false}}}};
+
+    bench_params_t params;
+    params.query_count = 100;
+    vector<backend_report_t> reports;
+    reports.push_back(run_backend_workload<graph_t>("graph_t", gfa, params));
+    reports.push_back(run_backend_workload<betagraph::BGraph>("bgraph", gfa, params));
+
+    REQUIRE(reports[0].results.size() == reports[1].results.size());
+    for (size_t i = 0; i < reports[0].results.size(); ++i) {
+        REQUIRE(reports[0].results[i].name == reports[1].results[i].name);
+        REQUIRE(reports[0].results[i].ops == reports[1].results[i].ops);
+    }
+    REQUIRE(reports[1].memory.children.size() == 4);
+
+    stringstream table;
+    write_compare_table(table, reports);
+    REQUIRE(table.str().find("bits_per_base") != string::npos);
+    stringstream json;
+    write_compare_json(json, reports);
+    REQUIRE(json.str().front() == '[');
+    REQUIRE(json.str().find("\"backend\":\"bgraph\"") != string::npos);
+}
+
+TEST_CASE("GFA with named segments is read into comparison records", "[compare]") {
+
+    stringstream in("H\tVN:Z:1.0\n"
+                    "S\tchr1_a\tGATT\n"
+                    "S\tchr1_b\tACA\n"
+                    "L\tchr1_a\t+\tchr1_b\t-\t0M\n"
+                    "P\tx\tchr1_a+,chr1_b-\t*\n");
+    gfa_records_t gfa = read_gfa_records(in);
+    REQUIRE(gfa.nodes.size() == 2);
+    REQUIRE(gfa.nodes[0] == make_pair(id_t(1), string("GATT")));
+    REQUIRE(gfa.nodes[1] == make_pair(id_t(2), string("ACA")));
+    REQUIRE(gfa.edges.size() == 1);
+    REQUIRE(gfa.paths.size() == 1);
+    REQUIRE(gfa.paths[0].first == "x");
+    REQUIRE(gfa.paths[0].second.size() == 2);
+    REQUIRE(gfa.paths[0].second[1] == make_pair(id_t(2), true));
+
+    graph_t graph;
+    build_from_records(graph, gfa);
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(2, true)));
+    stringstream bad("S\tchr1_a\tGATT\nL\tchr1_a\t+\tchr9\t+\t0M\n");
+    REQUIRE_THROWS(read_gfa_records(bad));
+}
+
+}
+}
@@ -0,0 +1,115 @@
+/**
+ * \file
+ * unittest/components.cpp: test cases for the connected components.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "union_find.hpp"
+#include "traverse.hpp"
+#include "simulate.hpp"
+
+#include <random>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Concurrent unions give the same sets as serial ones", "[components]") {
+
+    uint64_t size = 20000;
+    vector<pair<uint64_t, uint64_t>> unions;
+    mt19937_64 rng(27);
+    uniform_int_distribution<uint64_t> pick(0, size - 1);
+    for (uint64_t i = 0; i < size / 2; ++i) {
+        unions.push_back(make_pair(pick(rng), pick(rng)));
+    }
+    concurrent_union_find_t serial(size), parallel(size);
+    for (auto& u : unions) {
+        serial.unite(u.first, u.second);
+    }
+#pragma omp parallel for
+    for (uint64_t i = 0; i < unions.size(); ++i) {
+        parallel.unite(unions[i].first, unions[i].second);
+    }
+    for (uint64_t i = 0; i < size; ++i) {
+        REQUIRE(parallel.find(i) == serial.find(i));
+        // roots are the smallest members of their sets
+        REQUIRE(serial.find(i) <= i);
+    }
+}
+
+TEST_CASE("Weakly connected components are found and numbered by lowest rank", "[components]") {
+
+    graph_t graph;
+    // a few separate simulated graphs, one after another, and a lone node
+    simulate_params_t params;
+    params.length = 2000;
+    params.inversion_rate = 0.002;
+    params.path_count = 2;
+    uint64_t offset = 0;
+    for (uint64_t part = 0; part < 3; ++part) {
+        params.seed = 27 + part;
+        uint64_t max_id = 0;
+        simulate_graph(params,
+                       [&](uint64_t id, const string& seq) {
+                           graph.create_handle(seq, offset + id);
+                           max_id = max(max_id, id);
+                       },
+                       [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                           graph.create_edge(graph.get_handle(offset + from_id, from_rev),
+                                             graph.get_handle(offset + to_id, to_rev));
+                       },
+                       [&](const string& path_name, uint64_t id, bool is_rev) {});
+        offset += max_id;
+    }
+    graph.create_handle("GATTACA", offset + 1);
+
+    vector<uint64_t> component;
+    uint64_t count = graph.weakly_connected_components(component);
+    REQUIRE(count == 4);
+    REQUIRE(component.size() == graph.node_size());
+    REQUIRE(component.front() == 0);
+    REQUIRE(component.back() == 3);
+    // every node reached from a node is in its component and no other is
+    vector<uint64_t> first_rank(count, UINT64_MAX);
+    for (uint64_t i = 0; i < component.size(); ++i) {
+        first_rank[component[i]] = min(first_rank[component[i]], i);
+    }
+    for (uint64_t k = 0; k < count; ++k) {
+        if (k) REQUIRE(first_rank[k - 1] < first_rank[k]);
+        bfs_levels_t reached = bfs(graph, {handle_helper::pack(first_rank[k], false)});
+        uint64_t members = 0;
+        for (auto& h : reached.nodes) {
+            REQUIRE(component[handle_helper::unpack_number(h)] == k);
+        }
+        for (auto c : component) {
+            if (c == k) ++members;
+        }
+        REQUIRE(members == reached.nodes.size());
+    }
+}
+
+TEST_CASE("Hidden nodes are in no component", "[components]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATTACA", 1);
+    graph.create_hidden_handle("CAT");
+    handle_t c = graph.create_handle("TTAG", 3);
+    handle_t d = graph.create_handle("A", 4);
+    graph.create_edge(a, d);
+
+    vector<uint64_t> component;
+    REQUIRE(graph.weakly_connected_components(component) == 2);
+    REQUIRE(component.size() == graph.node_size());
+    REQUIRE(component[handle_helper::unpack_number(a)] == 0);
+    REQUIRE(component[handle_helper::unpack_number(d)] == 0);
+    REQUIRE(component[1] == no_component);
+    REQUIRE(component[handle_helper::unpack_number(c)] == 1);
+}
+
+}
+}
@@ -0,0 +1,175 @@
+/**
+ * \file
+ * unittest/extract.cpp: test cases for subgraph extraction.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "traverse.hpp"
+#include "simulate.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <algorithm>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// The edges of a graph by the ids and orientations of their canonical ends
+static multiset<tuple<id_t, bool, id_t, bool>> edge_ids(graph_t& graph) {
+    multiset<tuple<id_t, bool, id_t, bool>> edges;
+    graph.for_each_edge([&](const edge_t& e) {
+            edge_t c = graph.edge_handle(e.first, e.second);
+            edges.insert(make_tuple(graph.get_id(c.first), graph.get_is_reverse(c.first),
+                                    graph.get_id(c.second), graph.get_is_reverse(c.second)));
+            return true;
+        });
+    return edges;
+}
+
+/// The steps of each path, by name
+static map<string, vector<pair<id_t, bool>>> path_steps(const graph_t& graph) {
+    map<string, vector<pair<id_t, bool>>> paths;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+            auto& steps = paths[graph.get_path_name(p)];
+            graph.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) {
+                    handle_t h = graph.get_occurrence(occ);
+                    steps.push_back(make_pair(graph.get_id(h), graph.get_is_reverse(h)));
+                });
+        });
+    return paths;
+}
+
+TEST_CASE("Extracted paths are clipped to the region", "[extract]") {
+
+    graph_t graph;
+    vector<handle_t> h;
+    for (id_t id = 1; id <= 6; ++id) {
+        h.push_back(graph.create_handle(string(id, 'A'), id));
+    }
+    for (size_t i = 0; i + 1 < h.size(); ++i) {
+        graph.create_edge(h[i], h[i+1]);
+    }
+    graph.create_edge(h[1], graph.flip(h[3]));
+    auto make_path = [&](const string& name, const vector<handle_t>& steps) {
+        path_handle_t p = graph.create_path_handle(name);
+        for (auto& s : steps) graph.append_occurrence(p, s);
+    };
+    make_path("x", h);
+    make_path("y", {h[2], graph.flip(h[3])});
+    // leaves the region and comes back
+    make_path("w", {h[2], h[5], h[3], h[0]});
+
+    graph_t sub;
+    graph.extract({h[2]}, 1, sub);
+    REQUIRE(sub.node_size() == 3);
+    for (id_t id : {2, 3, 4}) {
+        REQUIRE(sub.has_node(id));
+        REQUIRE(sub.get_sequence(sub.get_handle(id)) == string(id, 'A'));
+    }
+    REQUIRE(!sub.has_node(1));
+    REQUIRE(!sub.has_node(5));
+    REQUIRE(sub.has_edge(sub.get_handle(2), sub.get_handle(3)));
+    REQUIRE(sub.has_edge(sub.get_handle(3), sub.get_handle(4)));
+    REQUIRE(sub.has_edge(sub.get_handle(2), sub.get_handle(4, true)));
+    // only the reversing edge from 2 is left on the right of 4
+    REQUIRE(sub.get_degree(sub.get_handle(4), false) == 1);
+
+    auto paths = path_steps(sub);
+    REQUIRE(paths.size() == 4);
+    REQUIRE(paths["x[0]"] == vector<pair<id_t, bool>>({{2, false}, {3, false}, {4, false}}));
+    REQUIRE(paths["y"] == vector<pair<id_t, bool>>({{3, false}, {4, true}}));
+    REQUIRE(paths["w[0]"] == vector<pair<id_t, bool>>({{3, false}}));
+    REQUIRE(paths["w[1]"] == vector<pair<id_t, bool>>({{4, false}}));
+    path_handle_t y = sub.get_path_handle("y");
+    REQUIRE(!sub.has_previous_occurrence(sub.get_first_occurrence(y)));
+    REQUIRE(sub.has_previous_occurrence(sub.get_last_occurrence(y)));
+
+    graph_t more;
+    REQUIRE_THROWS(graph.extract({h[0]}, 0, sub));
+    graph.extract(5, 6, 0, more);
+    REQUIRE(more.node_size() == 2);
+    REQUIRE(path_steps(more)["x[0]"] == vector<pair<id_t, bool>>({{5, false}, {6, false}}));
+}
+
+TEST_CASE("Extraction by id range matches the context of the range", "[extract]") {
+
+    simulate_params_t params;
+    params.length = 20000;
+    params.snp_rate = 0.01;
+    params.indel_rate = 0.002;
+    params.inversion_rate = 0.002;
+    params.path_count = 3;
+    graph_t graph;
+    simulate_graph(params, graph);
+
+    id_t first = graph.min_node_id() + 100, last = first + 50;
+    graph_t sub;
+    graph.extract(first, last, 2, sub);
+
+    vector<handle_t> seeds;
+    for (id_t id = first; id <= last; ++id) {
+        if (graph.has_node(id)) seeds.push_back(graph.get_handle(id));
+    }
+    set<id_t> expected;
+    for (auto& h : bfs(graph, seeds, 2).nodes) {
+        expected.insert(graph.get_id(h));
+    }
+    set<id_t> got;
+    sub.for_each_handle([&](const handle_t& h) {
+            got.insert(sub.get_id(h));
+            REQUIRE(sub.get_sequence(h) == graph.get_sequence(graph.get_handle(sub.get_id(h))));
+        });
+    REQUIRE(got == expected);
+
+    // the edges are exactly those of the source among the extracted nodes
+    multiset<tuple<id_t, bool, id_t, bool>> among;
+    for (auto& e : edge_ids(graph)) {
+        if (expected.count(get<0>(e)) && expected.count(get<2>(e))) among.insert(e);
+    }
+    REQUIRE(edge_ids(sub) == among);
+
+    // every stretch is a run of consecutive steps of its source path
+    auto source = path_steps(graph);
+    for (auto& p : path_steps(sub)) {
+        string name = p.first.substr(0, p.first.find('['));
+        REQUIRE(source.count(name));
+        auto& steps = source[name];
+        REQUIRE(search(steps.begin(), steps.end(), p.second.begin(), p.second.end()) != steps.end());
+        for (auto& s : p.second) {
+            REQUIRE(expected.count(s.first));
+        }
+    }
+}
+
+TEST_CASE("Extracted hidden nodes stay hidden", "[extract]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATTACA", 1);
+    handle_t b = graph.create_handle("CAT", 2);
+    graph.create_edge(a, b);
+    handle_t c = graph.create_hidden_handle("TTAG");
+    REQUIRE(graph.get_id(c) == 3);
+    path_handle_t p = graph.create_path_handle("x");
+    graph.append_occurrence(p, a);
+    graph.append_occurrence(p, c);
+
+    graph_t sub;
+    graph.extract(1, 3, 0, sub);
+    REQUIRE(sub.node_size() == 3);
+    REQUIRE(sub.has_node(1));
+    REQUIRE(sub.has_node(2));
+    REQUIRE(!sub.has_node(3));
+    REQUIRE(path_steps(sub)["x"] == vector<pair<id_t, bool>>({{1, false}, {3, false}}));
+    graph_t copy = sub;
+    REQUIRE(!copy.has_node(3));
+}
+
+}
+}
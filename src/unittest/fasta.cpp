@@ -0,0 +1,91 @@
+/**
+ * \file
+ * unittest/fasta.cpp: test cases for writing path sequences as FASTA.
+ */
+
+#include "catch.hpp"
+
+#include "fasta.hpp"
+
+#include <omp.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Path sequences are written as wrapped FASTA records", "[fasta]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATT", 1);
+    handle_t b = graph.create_handle("ACA", 2);
+    graph.create_edge(a, b);
+    graph.create_edge(a, graph.flip(b));
+    path_handle_t x = graph.create_path_handle("x");
+    graph.append_occurrence(x, a);
+    graph.append_occurrence(x, graph.flip(b));
+    path_handle_t y = graph.create_path_handle("y");
+    graph.append_occurrence(y, a);
+    graph.append_occurrence(y, b);
+    path_handle_t z = graph.create_path_handle("z");
+
+    string spelled;
+    graph.append_sequence(graph.flip(b), spelled);
+    graph.append_sequence(a, spelled);
+    REQUIRE(spelled == "TGTGATT");
+
+    stringstream wrapped;
+    write_path_fasta(graph, {y, x, z}, 3, wrapped);
+    REQUIRE(wrapped.str() == ">y\nGAT\nTAC\nA\n>x\nGAT\nTTG\nT\n>z\n");
+    stringstream exact;
+    write_path_fasta(graph, {x}, 7, exact);
+    REQUIRE(exact.str() == ">x\nGATTTGT\n");
+    stringstream unwrapped;
+    write_path_fasta(graph, {x, z}, 0, unwrapped);
+    REQUIRE(unwrapped.str() == ">x\nGATTTGT\n>z\n");
+}
+
+TEST_CASE("Long paths are spelled in chunks that join up", "[fasta]") {
+
+    graph_t graph;
+    string seq;
+    for (uint64_t i = 0; i < 143; ++i) seq.append("GATTACA");
+    handle_t a = graph.create_handle(seq, 1);
+    handle_t b = graph.create_handle("CAT", 2);
+    graph.create_edge(a, b);
+    graph.create_edge(b, a);
+    graph.create_edge(b, graph.flip(a));
+    path_handle_t x = graph.create_path_handle("x");
+    path_handle_t y = graph.create_path_handle("y");
+    string expected_x;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        handle_t h = i % 3 ? a : graph.flip(a);
+        graph.append_occurrence(x, h);
+        graph.append_occurrence(x, b);
+        expected_x.append(graph.get_sequence(h));
+        expected_x.append("CAT");
+    }
+    graph.append_occurrence(y, b);
+    REQUIRE(expected_x.size() > 2 * fasta_chunk_bases);
+
+    string expected = ">x\n";
+    for (uint64_t i = 0; i < expected_x.size(); i += 60) {
+        expected.append(expected_x, i, 60);
+        expected.push_back('\n');
+    }
+    expected.append(">y\nCAT\n");
+    int threads = omp_get_max_threads();
+    for (int t : {1, 4}) {
+        omp_set_num_threads(t);
+        stringstream out;
+        write_path_fasta(graph, {x, y}, 60, out);
+        REQUIRE(out.str() == expected);
+    }
+    omp_set_num_threads(threads);
+}
+
+}
+}
@@ -0,0 +1,241 @@
+/**
+ * \file
+ * unittest/gfa.cpp: test cases for GFA input and output.
+ */
+
+#include "catch.hpp"
+
+#include "gfa.hpp"
+#include "simulate.hpp"
+
+#include <omp.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// Gzip some text as one member
+static string gzip(const string& text) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    string zipped(deflateBound(&stream, text.size()), '\0');
+    stream.next_in = (Bytef*)text.data();
+    stream.avail_in = text.size();
+    stream.next_out = (Bytef*)&zipped[0];
+    stream.avail_out = zipped.size();
+    deflate(&stream, Z_FINISH);
+    zipped.resize(stream.total_out);
+    deflateEnd(&stream);
+    return zipped;
+}
+
+/// The lines of a graph's GFA, sorted
+static vector<string> gfa_lines(const graph_t& graph) {
+    stringstream ss;
+    graph.to_gfa(ss);
+    vector<string> lines;
+    string line;
+    while (getline(ss, line)) lines.push_back(line);
+    sort(lines.begin(), lines.end());
+    return lines;
+}
+
+TEST_CASE("GFA output writes each edge once", "[gfa]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GAT", 1);
+    handle_t b = graph.create_handle("TA", 2);
+    handle_t c = graph.create_handle("CA", 3);
+    graph.create_edge(a, b);
+    // joining two right sides, and two left sides
+    graph.create_edge(b, graph.flip(c));
+    graph.create_edge(graph.flip(a), c);
+    // self edges on either side
+    graph.create_edge(graph.flip(c), c);
+    graph.create_edge(b, b);
+    path_handle_t x = graph.create_path_handle("x");
+    graph.append_occurrence(x, a);
+    graph.append_occurrence(x, b);
+    graph.append_occurrence(x, graph.flip(c));
+
+    stringstream ss;
+    graph.to_gfa(ss);
+    REQUIRE(ss.str() ==
+            "H\tVN:Z:1.0\n"
+            "S\t1\tGAT\n"
+            "L\t1\t+\t2\t+\t0M\n"
+            "L\t1\t-\t3\t+\t0M\n"
+            "S\t2\tTA\n"
+            "L\t2\t+\t3\t-\t0M\n"
+            "L\t2\t+\t2\t+\t0M\n"
+            "S\t3\tCA\n"
+            "L\t3\t-\t3\t+\t0M\n"
+            "P\tx\t1+,2+,3-\t3M,2M,2M\n");
+}
+
+TEST_CASE("GFA output does not depend on the number of threads", "[gfa]") {
+
+    simulate_params_t params;
+    params.length = 50000;
+    params.node_length = 8;
+    params.inversion_rate = 0.001;
+    params.path_count = 4;
+    graph_t graph;
+    simulate_graph(params, graph);
+
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    stringstream serial;
+    graph.to_gfa(serial);
+    omp_set_num_threads(4);
+    stringstream parallel;
+    graph.to_gfa(parallel);
+    omp_set_num_threads(threads);
+    REQUIRE(serial.str() == parallel.str());
+
+    uint64_t segments = 0, links = 0, paths = 0;
+    string line;
+    while (getline(serial, line)) {
+        if (line[0] == 'S') ++segments;
+        if (line[0] == 'L') ++links;
+        if (line[0] == 'P') ++paths;
+    }
+    uint64_t edges = 0;
+    graph.for_each_edge([&](const edge_t& e) { ++edges; return true; });
+    REQUIRE(segments == graph.node_size());
+    REQUIRE(links == edges);
+    REQUIRE(paths == graph.get_path_count());
+}
+
+TEST_CASE("GFA input resolves links and paths given before their segments", "[gfa]") {
+
+    stringstream in("H\tVN:Z:1.0\n"
+                    "P\tx\t1+,2-,3+\t*\n"
+                    "L\t1\t+\t2\t-\t0M\n"
+                    "S\t1\tGAT\tLN:i:3\n"
+                    "L\t2\t-\t3\t+\t0M\r\n"
+                    "P\ty\t1+\t3M\n"
+                    "S\t2\tAT\n"
+                    "# a comment\n"
+                    "S\t3\tTACA");
+    graph_t graph;
+    read_gfa(in, graph);
+    REQUIRE(graph.node_size() == 3);
+    REQUIRE(graph.get_sequence(graph.get_handle(1)) == "GAT");
+    REQUIRE(graph.get_sequence(graph.get_handle(3)) == "TACA");
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(2, true)));
+    REQUIRE(graph.has_edge(graph.get_handle(2, true), graph.get_handle(3)));
+    // the paths keep their order in the file
+    vector<string> names;
+    graph.for_each_path_handle([&](const path_handle_t& p) { names.push_back(graph.get_path_name(p)); });
+    REQUIRE(names == vector<string>({"x", "y"}));
+    string spelled;
+    graph.for_each_occurrence_in_path(graph.get_path_handle("x"), [&](const occurrence_handle_t& occ) {
+            spelled.append(graph.get_sequence(graph.get_occurrence(occ)));
+        });
+    REQUIRE(spelled == "GATATTACA");
+
+    stringstream missing("S\t1\tGAT\nL\t1\t+\t2\t+\t0M\n");
+    graph_t other;
+    REQUIRE_THROWS(read_gfa(missing, other));
+    stringstream named("S\tchr1\tGAT\n");
+    graph_t another;
+    REQUIRE_THROWS(read_gfa(named, another));
+}
+
+TEST_CASE("GFA round trips through plain and gzipped streams", "[gfa]") {
+
+    // a chain of long nodes, so that lines and gzip members run across blocks
+    graph_t graph;
+    string seq;
+    for (uint64_t i = 0; i < 4000; ++i) seq.append("GATTACA");
+    path_handle_t x = graph.create_path_handle("x");
+    handle_t prev;
+    for (id_t id = 1; id <= 120; ++id) {
+        handle_t h = graph.create_handle(seq.substr(id), id);
+        if (id % 5 == 0) h = graph.flip(h);
+        if (id > 1) graph.create_edge(prev, h);
+        graph.append_occurrence(x, h);
+        prev = h;
+    }
+    stringstream out;
+    graph.to_gfa(out);
+    string text = out.str();
+    REQUIRE(text.size() > (3 << 20));
+    auto expected = gfa_lines(graph);
+
+    stringstream plain(text);
+    graph_t from_plain;
+    read_gfa(plain, from_plain);
+    REQUIRE(gfa_lines(from_plain) == expected);
+
+    // two gzip members, split mid-line, as a block-gzipped file would have
+    stringstream zipped(gzip(text.substr(0, text.size() / 3)) + gzip(text.substr(text.size() / 3)));
+    graph_t from_zipped;
+    read_gfa(zipped, from_zipped);
+    REQUIRE(gfa_lines(from_zipped) == expected);
+
+    string truncated = gzip(text);
+    stringstream cut(truncated.substr(0, truncated.size() / 2));
+    graph_t from_cut;
+    REQUIRE_THROWS(read_gfa(cut, from_cut));
+}
+
+TEST_CASE("GFA segment names are translated to dense ids", "[gfa]") {
+
+    segment_names_t names;
+    REQUIRE(names.intern("utg000123l", 10) == 1);
+    REQUIRE(names.intern("utg7", 4) == 2);
+    REQUIRE(names.intern("utg000123l", 10) == 1);
+    REQUIRE(names.get_id("utg7") == 2);
+    REQUIRE(names.get_id("utg8") == 0);
+    // enough names to grow the table a few times
+    for (uint64_t i = 0; i < 5000; ++i) {
+        string name = "n" + to_string(i);
+        REQUIRE(names.intern(name.data(), name.size()) == i + 3);
+    }
+    REQUIRE(names.size() == 5002);
+    REQUIRE(names.get_name(4) == "n1");
+    stringstream table;
+    names.serialize(table);
+    segment_names_t loaded;
+    loaded.load(table);
+    REQUIRE(loaded.size() == names.size());
+    REQUIRE(loaded.get_id("n4999") == 5002);
+    REQUIRE(loaded.get_name(1) == "utg000123l");
+    stringstream bad("a\t1\na\t2\n");
+    REQUIRE_THROWS(loaded.load(bad));
+
+    stringstream in("S\tutg2\tGAT\n"
+                    "L\tutg2\t+\tutg10\t-\t0M\n"
+                    "P\tx\tutg2+,utg10-\t*\n"
+                    "S\tutg10\tTACA\n"
+                    "S\t7\tA\n");
+    segment_names_t gfa_names;
+    graph_t graph;
+    read_gfa(in, graph, &gfa_names);
+    REQUIRE(graph.node_size() == 3);
+    REQUIRE(gfa_names.get_id("utg2") == 1);
+    REQUIRE(gfa_names.get_id("utg10") == 2);
+    // numeric names are translated too
+    REQUIRE(gfa_names.get_id("7") == 3);
+    REQUIRE(graph.get_sequence(graph.get_handle(2)) == "TACA");
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(2, true)));
+    REQUIRE(graph.get_occurrence_count(graph.get_path_handle("x")) == 2);
+
+    stringstream repeated("S\tutg2\tGAT\nS\tutg2\tGAT\n");
+    segment_names_t more_names;
+    graph_t other;
+    REQUIRE_THROWS_WITH(read_gfa(repeated, other, &more_names), Catch::Contains("utg2"));
+}
+
+}
+}
@@ -8,6 +8,8 @@
 #include "handle.hpp"
 //#include "handle_helper.hpp"
 #include "graph.hpp"
+#include "bgraph.hpp"
+#include "simulate.hpp"
 
 #include <iostream>
 #include <limits>
@@ -15,6 +17,7 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <random>
 
 namespace dg {
 namespace unittest {
@@ -2265,5 +2268,137 @@ TEST_CASE("Deletable handle graphs with mutable paths work", "[handle][packed][h
 }
     
 
+/// Build just the nodes and edges of a simulated graph
+template<typename Graph>
+static void simulate_topology(const simulate_params_t& params, Graph& graph) {
+    simulate_graph(params,
+                   [&](uint64_t id, const string& seq) {
+                       graph.create_handle(seq, id);
+                   },
+                   [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                       graph.create_edge(graph.get_handle(from_id, from_rev), graph.get_handle(to_id, to_rev));
+                   },
+                   [&](const string& path_name, uint64_t id, bool is_rev) {});
+}
+
+/// Check that the inlined iteration entry points see exactly what the
+/// virtual ones do, in the same order, and stop when asked to
+template<typename Graph>
+static void check_fast_iteration(const Graph& graph) {
+    vector<handle_t> slow_nodes, fast_nodes;
+    const HandleGraph& base = graph;
+    base.for_each_handle([&](const handle_t& h) {
+            slow_nodes.push_back(h);
+            return true;
+        });
+    graph.for_each_handle_fast([&](const handle_t& h) {
+            fast_nodes.push_back(h);
+        });
+    REQUIRE(fast_nodes == slow_nodes);
+    REQUIRE(fast_nodes.size() == graph.node_size());
+
+    for (auto& h : slow_nodes) {
+        for (handle_t side : {h, graph.flip(h)}) {
+            for (bool go_left : {false, true}) {
+                vector<handle_t> slow, fast;
+                base.follow_edges(side, go_left, [&](const handle_t& next) {
+                        slow.push_back(next);
+                        return true;
+                    });
+                REQUIRE(graph.follow_edges_fast(side, go_left, [&](const handle_t& next) {
+                            fast.push_back(next);
+                        }));
+                REQUIRE(fast == slow);
+                if (!slow.empty()) {
+                    size_t seen = 0;
+                    REQUIRE(!graph.follow_edges_fast(side, go_left, [&](const handle_t& next) {
+                                ++seen;
+                                return false;
+                            }));
+                    REQUIRE(seen == 1);
+                }
+            }
+        }
+    }
+
+    size_t seen = 0;
+    graph.for_each_handle_fast([&](const handle_t& h) {
+            ++seen;
+            return seen < 10;
+        });
+    REQUIRE(seen == min<size_t>(10, graph.node_size()));
+}
+
+TEST_CASE("Inlined iteration matches the virtual interface", "[handle][fast]") {
+
+    simulate_params_t params;
+    params.length = 3000;
+    params.inversion_rate = 0.005;
+    params.path_count = 3;
+
+    SECTION("graph_t") {
+        graph_t graph;
+        simulate_graph(params, graph);
+        check_fast_iteration(graph);
+    }
+
+    SECTION("BGraph") {
+        betagraph::BGraph graph;
+        simulate_topology(params, graph);
+        check_fast_iteration(graph);
+    }
+}
+
+/// Check that batched neighbor queries give each handle what follow_edges
+/// does, whatever order and multiplicity the handles come in
+template<typename Graph>
+static void check_batch_neighbors(const Graph& graph) {
+    vector<handle_t> batch;
+    graph.for_each_handle_fast([&](const handle_t& h) {
+            batch.push_back(h);
+            batch.push_back(graph.flip(h));
+        });
+    // shuffled, with repeats and with runs of neighboring ranks
+    std::mt19937 rng(7);
+    std::shuffle(batch.begin(), batch.end(), rng);
+    batch.insert(batch.end(), batch.begin(), batch.begin() + batch.size() / 3);
+    neighbor_batch_t out;
+    for (bool go_left : {false, true}) {
+        for (size_t n : {(size_t) 0, (size_t) 1, (size_t) 17, batch.size()}) {
+            graph.follow_edges_batch(batch.data(), n, go_left, out);
+            REQUIRE(out.size() == n);
+            for (size_t i = 0; i < n; ++i) {
+                vector<handle_t> expected;
+                graph.follow_edges_fast(batch[i], go_left, [&](const handle_t& next) {
+                        expected.push_back(next);
+                    });
+                vector<handle_t> got(out.handles.begin() + out.offsets[i],
+                                     out.handles.begin() + out.offsets[i+1]);
+                REQUIRE(got == expected);
+                REQUIRE(out.degree(i) == graph.get_degree(batch[i], go_left));
+            }
+        }
+    }
+}
+
+TEST_CASE("Batched neighbor queries match follow_edges", "[handle][batch]") {
+
+    simulate_params_t params;
+    params.length = 3000;
+    params.inversion_rate = 0.005;
+
+    SECTION("graph_t") {
+        graph_t graph;
+        simulate_graph(params, graph);
+        check_batch_neighbors(graph);
+    }
+
+    SECTION("BGraph") {
+        betagraph::BGraph graph;
+        simulate_topology(params, graph);
+        check_batch_neighbors(graph);
+    }
+}
+
 }
 }
@@ -0,0 +1,29 @@
+#ifndef DG_UNITTEST_HELPERS_HPP_INCLUDED
+#define DG_UNITTEST_HELPERS_HPP_INCLUDED
+
+#include <map>
+#include <string>
+#include "graph.hpp"
+
+namespace dg {
+namespace unittest {
+
+/**
+ * Spell out each path of a graph, by name, for checking that an edit of the
+ * graph kept the sequences its paths walk.
+ */
+inline std::map<std::string, std::string> path_sequences(const graph_t& graph) {
+    std::map<std::string, std::string> spelled;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+            auto& seq = spelled[graph.get_path_name(p)];
+            graph.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) {
+                    seq.append(graph.get_sequence(graph.get_occurrence(occ)));
+                });
+        });
+    return spelled;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * \file
+ * unittest/id_index.cpp: test cases for the id to rank index.
+ */
+
+#include "catch.hpp"
+
+#include "id_index.hpp"
+
+#include <sstream>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("The id index switches between dense and sparse storage", "[id_index]") {
+
+    id_index_t index;
+
+    SECTION("Compact ids are stored densely, even when added in descending order") {
+        for (uint64_t id = 100; id > 0; --id) {
+            index.set(id, 100 - id);
+        }
+        REQUIRE(index.is_dense());
+        REQUIRE(index.size() == 100);
+        for (uint64_t id = 1; id <= 100; ++id) {
+            REQUIRE(index.has(id));
+            REQUIRE(index.get(id) == 100 - id);
+        }
+        REQUIRE(!index.has(0));
+        REQUIRE(!index.has(101));
+    }
+
+    SECTION("Scattered ids fall back to the hash map and keep their ranks") {
+        for (uint64_t i = 0; i < 10; ++i) {
+            index.set(1 + i * 1000000, i);
+        }
+        REQUIRE(!index.is_dense());
+        for (uint64_t i = 0; i < 10; ++i) {
+            REQUIRE(index.get(1 + i * 1000000) == i);
+        }
+        index.erase(1000001);
+        REQUIRE(!index.has(1000001));
+        REQUIRE(index.size() == 9);
+    }
+
+    SECTION("Both representations round-trip through serialization") {
+        id_index_t dense, sparse;
+        for (uint64_t i = 1; i <= 50; ++i) {
+            dense.set(i, i * 2);
+            sparse.set(i * 12345, i);
+        }
+        for (id_index_t* original : {&dense, &sparse}) {
+            stringstream out;
+            original->serialize(out);
+            id_index_t loaded;
+            stringstream in(out.str());
+            loaded.load(in);
+            REQUIRE(loaded.is_dense() == original->is_dense());
+            REQUIRE(loaded.size() == original->size());
+            original->for_each([&](uint64_t id, uint64_t rank) {
+                    REQUIRE(loaded.has(id));
+                    REQUIRE(loaded.get(id) == rank);
+                });
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,149 @@
+/**
+ * \file
+ * unittest/kmer.cpp: test cases for enumerating the k-mers of graph walks.
+ */
+
+#include "catch.hpp"
+
+#include "kmer.hpp"
+#include "simulate.hpp"
+#include "dna.hpp"
+
+#include <omp.h>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+typedef tuple<string, id_t, bool, uint64_t> kmer_tuple_t;
+
+/// Every k-mer starting at each offset of each oriented node, found by
+/// spelling out each walk from there in full
+static multiset<kmer_tuple_t> spelled_kmers(const graph_t& graph, uint64_t k, uint64_t max_edges) {
+    multiset<kmer_tuple_t> kmers;
+    function<void(const handle_t&, const string&, uint64_t, const handle_t&, uint64_t)> walk;
+    walk = [&](const handle_t& start, const string& spelled, uint64_t offset,
+               const handle_t& at, uint64_t edges) {
+        if (spelled.size() >= k) {
+            string kmer = spelled.substr(0, k);
+            if (kmer.find('N') == string::npos) {
+                kmers.insert(make_tuple(kmer, graph.get_id(start), graph.get_is_reverse(start), offset));
+            }
+            return;
+        }
+        if (edges == max_edges) return;
+        graph.follow_edges(at, false, [&](const handle_t& next) {
+                walk(start, spelled + graph.get_sequence(next), offset, next, edges + 1);
+                return true;
+            });
+    };
+    graph.for_each_handle([&](const handle_t& h) {
+            for (handle_t start : {h, graph.flip(h)}) {
+                string seq = graph.get_sequence(start);
+                for (uint64_t i = 0; i < seq.size(); ++i) {
+                    walk(start, seq.substr(i), i, start, 0);
+                }
+            }
+        });
+    return kmers;
+}
+
+/// The k-mers reported by the batch enumeration
+static multiset<kmer_tuple_t> enumerated_kmers(const graph_t& graph, const kmer_params_t& params) {
+    multiset<kmer_tuple_t> kmers;
+    for_each_kmer_batch(graph, params, [&](const vector<kmer_pos_t>& batch) {
+            for (auto& kmer : batch) {
+                kmers.insert(make_tuple(kmer_to_string(kmer.kmer, params.k), kmer.id, kmer.is_rev, kmer.offset));
+            }
+        });
+    return kmers;
+}
+
+TEST_CASE("K-mers are enumerated across edges", "[kmer]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATT", 1);
+    handle_t b = graph.create_handle("A", 2);
+    handle_t c = graph.create_handle("C", 3);
+    handle_t d = graph.create_handle("ANCAT", 4);
+    handle_t e = graph.create_handle("GG", 5);
+    graph.create_edge(a, b);
+    graph.create_edge(a, c);
+    graph.create_edge(b, d);
+    graph.create_edge(c, d);
+    graph.create_edge(d, graph.flip(e));
+    graph.create_edge(e, e);
+
+    for (uint64_t k : {1, 3, 5}) {
+        for (uint64_t max_edges : {0, 1, 2, 8}) {
+            kmer_params_t params;
+            params.k = k;
+            params.max_edges = max_edges;
+            REQUIRE(enumerated_kmers(graph, params) == spelled_kmers(graph, k, max_edges));
+        }
+    }
+
+    // the two walks through the bubble each give a k-mer at the same start
+    kmer_params_t params;
+    params.k = 5;
+    auto kmers = enumerated_kmers(graph, params);
+    REQUIRE(kmers.count(make_tuple(string("TTAAN"), id_t(1), false, uint64_t(2))) == 0);
+    REQUIRE(kmers.count(make_tuple(string("ATTAA"), id_t(1), false, uint64_t(1))) == 1);
+    REQUIRE(kmers.count(make_tuple(string("ATTCA"), id_t(1), false, uint64_t(1))) == 1);
+    REQUIRE(kmers.count(make_tuple(string("CATCC"), id_t(4), false, uint64_t(2))) == 1);
+    params.k = 33;
+    REQUIRE_THROWS(enumerated_kmers(graph, params));
+}
+
+TEST_CASE("Canonical k-mers come from one strand and don't depend on the threads", "[kmer]") {
+
+    simulate_params_t sim;
+    sim.length = 5000;
+    sim.node_length = 6;
+    sim.inversion_rate = 0.002;
+    sim.path_count = 3;
+    graph_t graph;
+    simulate_graph(sim, graph);
+
+    kmer_params_t params;
+    params.k = 11;
+    params.max_edges = 4;
+    auto all = enumerated_kmers(graph, params);
+    REQUIRE(all == spelled_kmers(graph, params.k, params.max_edges));
+    // the canonical form is reported only where it's spelled
+    multiset<kmer_tuple_t> lesser;
+    for (auto& kmer : all) {
+        if (get<0>(kmer) <= reverse_complement(get<0>(kmer))) lesser.insert(kmer);
+    }
+    params.canonical = true;
+    vector<kmer_pos_t> serial, parallel;
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    for_each_kmer_batch(graph, params, [&](const vector<kmer_pos_t>& batch) {
+            serial.insert(serial.end(), batch.begin(), batch.end());
+        });
+    omp_set_num_threads(4);
+    for_each_kmer_batch(graph, params, [&](const vector<kmer_pos_t>& batch) {
+            parallel.insert(parallel.end(), batch.begin(), batch.end());
+        });
+    omp_set_num_threads(threads);
+    REQUIRE(serial.size() == parallel.size());
+    multiset<kmer_tuple_t> canonical;
+    for (uint64_t i = 0; i < serial.size(); ++i) {
+        REQUIRE(serial[i].kmer == parallel[i].kmer);
+        REQUIRE(serial[i].id == parallel[i].id);
+        REQUIRE(serial[i].offset == parallel[i].offset);
+        REQUIRE(serial[i].is_rev == parallel[i].is_rev);
+        canonical.insert(make_tuple(kmer_to_string(serial[i].kmer, params.k), serial[i].id,
+                                    serial[i].is_rev, serial[i].offset));
+    }
+    REQUIRE(canonical == lesser);
+}
+
+}
+}
@@ -0,0 +1,92 @@
+/**
+ * \file
+ * unittest/memory_usage.cpp: test cases for graph memory accounting.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "gfa.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Memory usage is broken down by backing structure", "[memory]") {
+
+    graph_t graph;
+    handle_t h1 = graph.create_handle("GATTACA");
+    handle_t h2 = graph.create_handle("CAT");
+    graph.create_edge(h1, h2);
+    path_handle_t p = graph.create_path_handle("x");
+    graph.append_occurrence(p, h1);
+    graph.append_occurrence(p, h2);
+
+    memory_usage_t usage = graph.memory_usage();
+    REQUIRE(usage.children.size() == 4);
+    uint64_t total = 0;
+    for (auto& group : usage.children) {
+        uint64_t group_total = 0;
+        for (auto& child : group.children) {
+            group_total += child.bytes;
+        }
+        REQUIRE(group.bytes == group_total);
+        REQUIRE(group.rates.size() == 1);
+        REQUIRE(group.rates[0].second > 0);
+        total += group.bytes;
+    }
+    REQUIRE(usage.bytes == total);
+    REQUIRE(usage.bytes > 0);
+
+    stringstream json;
+    usage.write_json(json);
+    REQUIRE(json.str().find("\"name\":\"seq_pv\"") != string::npos);
+    REQUIRE(json.str().find("\"bits_per_base\":") != string::npos);
+}
+
+/// Check that two reports measure the same structures at about the same cost
+static void require_similar(const memory_usage_t& built, const memory_usage_t& loaded) {
+    // empty hash tables keep some buckets, so only the sizes of the two are close
+    REQUIRE(built.name == loaded.name);
+    REQUIRE(loaded.bytes <= 2 * built.bytes + 64);
+    REQUIRE(built.bytes <= 2 * loaded.bytes + 64);
+    REQUIRE(built.children.size() == loaded.children.size());
+    for (size_t i = 0; i < built.children.size(); ++i) {
+        require_similar(built.children[i], loaded.children[i]);
+    }
+    REQUIRE(built.rates.size() == loaded.rates.size());
+    for (size_t i = 0; i < built.rates.size(); ++i) {
+        REQUIRE((built.rates[i].second == 0) == (loaded.rates[i].second == 0));
+    }
+}
+
+TEST_CASE("A reloaded index measures like the graph it was built as", "[memory]") {
+
+    stringstream gfa("S\t1\tGATTACA\nS\t2\tCAT\nS\t3\tTTAG\n"
+                     "L\t1\t+\t2\t+\t0M\nL\t2\t+\t3\t-\t0M\n"
+                     "P\tx\t1+,2+,3-\t*\nP\ty\t1+,2+\t*\n");
+    graph_t graph;
+    read_gfa(gfa, graph);
+    stringstream out;
+    graph.serialize(out);
+    graph_t loaded;
+    loaded.load(out);
+    memory_usage_t built_usage = graph.memory_usage();
+    memory_usage_t loaded_usage = loaded.memory_usage();
+    require_similar(built_usage, loaded_usage);
+    // the path structures in particular are all loaded and measured
+    for (auto& group : loaded_usage.children) {
+        if (group.name != "paths") continue;
+        for (auto& child : group.children) {
+            REQUIRE(child.bytes > 0);
+        }
+        REQUIRE(group.rates[0].second > 0);
+    }
+}
+
+}
+}
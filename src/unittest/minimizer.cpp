@@ -0,0 +1,212 @@
+/**
+ * \file
+ * unittest/minimizer.cpp: test cases for the minimizer index of graph walks.
+ */
+
+#include "catch.hpp"
+
+#include "minimizer.hpp"
+#include "simulate.hpp"
+#include "dna.hpp"
+#include "hash_map.hpp"
+
+#include <omp.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// Pack a k-mer 2 bits a base, or return false if it holds an N
+static bool pack_kmer(const string& kmer, uint64_t& packed) {
+    packed = 0;
+    for (char c : kmer) {
+        size_t code = string("ACGT").find(c);
+        if (code == string::npos) return false;
+        packed = packed << 2 | code;
+    }
+    return true;
+}
+
+/// The minimizers of a read, found by scanning each window in full
+static vector<pair<uint64_t, uint64_t>> scanned_minimizers(const string& read, uint64_t k, uint64_t w) {
+    vector<pair<uint64_t, uint64_t>> found;
+    for (uint64_t start = 0; start + k + w - 1 <= read.size(); ++start) {
+        bool any = false;
+        pair<uint64_t, uint64_t> best;
+        for (uint64_t i = start; i < start + w; ++i) {
+            string kmer = read.substr(i, k);
+            string rc = reverse_complement(kmer);
+            uint64_t fwd_packed, rc_packed;
+            if (!pack_kmer(kmer, fwd_packed)) continue;
+            pack_kmer(rc, rc_packed);
+            bool is_fwd = fwd_packed <= rc_packed;
+            uint64_t hash = wang_hash_64(is_fwd ? fwd_packed : rc_packed);
+            if (!any || hash < best.first) {
+                best = make_pair(hash, is_fwd ? pack_minimizer_pos(0, i, false)
+                                 : pack_minimizer_pos(0, read.size() - i - k, true));
+                any = true;
+            }
+        }
+        if (any && (found.empty() || found.back() != best)) found.push_back(best);
+    }
+    return found;
+}
+
+/// Spell a path, with the packed graph position of each base
+static string spell_path(const graph_t& graph, const path_handle_t& path, vector<uint64_t>& positions) {
+    string spelled;
+    positions.clear();
+    occurrence_handle_t occ = graph.get_first_occurrence(path);
+    while (true) {
+        handle_t h = graph.get_occurrence(occ);
+        uint64_t begin = spelled.size();
+        graph.append_sequence(h, spelled);
+        for (uint64_t i = 0; i < spelled.size() - begin; ++i) {
+            positions.push_back(pack_minimizer_pos(handle_helper::unpack_number(h), i,
+                                                   handle_helper::unpack_bit(h)));
+        }
+        if (!graph.has_next_occurrence(occ)) break;
+        occ = graph.get_next_occurrence(occ);
+    }
+    return spelled;
+}
+
+/// The same base read on the other strand of its node
+static uint64_t flip_pos(const graph_t& graph, uint64_t pos) {
+    uint64_t rank = minimizer_pos_rank(pos);
+    uint64_t length = graph.get_length(handle_helper::pack(rank, false));
+    return pack_minimizer_pos(rank, length - 1 - minimizer_pos_offset(pos), !minimizer_pos_is_rev(pos));
+}
+
+TEST_CASE("Read minimizers are the least hashed canonical k-mer of each window", "[minimizer]") {
+
+    string read = "GATTACACATTAGNNGATTACATTTTTTTTTTTTTAAAAGGCCTTACAGGGATNCAGATTACAGA";
+    for (uint64_t k : {1, 3, 7, 15}) {
+        for (uint64_t w : {1, 2, 5, 10}) {
+            minimizer_params_t params;
+            params.k = k;
+            params.w = w;
+            vector<pair<uint64_t, uint64_t>> found;
+            for_each_read_minimizer(read, params, [&](uint64_t hash, uint64_t pos) {
+                    found.push_back(make_pair(hash, pos));
+                });
+            REQUIRE(found == scanned_minimizers(read, k, w));
+        }
+    }
+}
+
+TEST_CASE("Minimizers of path sequences are found at their graph positions", "[minimizer]") {
+
+    simulate_params_t sim;
+    sim.length = 5000;
+    sim.node_length = 6;
+    sim.inversion_rate = 0.002;
+    sim.path_count = 3;
+    graph_t graph;
+    simulate_graph(sim, graph);
+
+    minimizer_params_t params;
+    params.max_edges = params.k + params.w;
+    minimizer_index_t index;
+    index.build(graph, params);
+    REQUIRE(index.size() > 0);
+    REQUIRE(index.hit_count() >= index.size());
+
+    vector<string> reads;
+    vector<vector<uint64_t>> read_positions;
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+            read_positions.emplace_back();
+            reads.push_back(spell_path(graph, path, read_positions.back()));
+        });
+    REQUIRE(reads.size() == sim.path_count);
+    for (uint64_t r = 0; r < reads.size(); ++r) {
+        for_each_read_minimizer(reads[r], params, [&](uint64_t hash, uint64_t pos) {
+                // a reverse read offset counts from the read's end, like a graph offset
+                uint64_t offset = minimizer_pos_offset(pos);
+                uint64_t expected = minimizer_pos_is_rev(pos)
+                    ? flip_pos(graph, read_positions[r][reads[r].size() - 1 - offset])
+                    : read_positions[r][offset];
+                auto range = index.find(hash);
+                REQUIRE(is_sorted(range.first, range.second));
+                REQUIRE(find(range.first, range.second, expected) != range.second);
+            });
+    }
+
+    // the batch finds what single lookups find, in read order
+    vector<vector<minimizer_match_t>> matches;
+    index.find_batch(reads, matches);
+    REQUIRE(matches.size() == reads.size());
+    for (uint64_t r = 0; r < reads.size(); ++r) {
+        vector<minimizer_match_t> expected;
+        for_each_read_minimizer(reads[r], params, [&](uint64_t hash, uint64_t pos) {
+                auto range = index.find(hash);
+                for (const uint64_t* hit = range.first; hit < range.second; ++hit) {
+                    expected.push_back({hash, pos, *hit});
+                }
+            });
+        REQUIRE(matches[r].size() == expected.size());
+        for (uint64_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(matches[r][i].hash == expected[i].hash);
+            REQUIRE(matches[r][i].read_pos == expected[i].read_pos);
+            REQUIRE(matches[r][i].graph_pos == expected[i].graph_pos);
+        }
+    }
+    index.find_batch(reads, matches, 1);
+    for (auto& read_matches : matches) {
+        for (auto& match : read_matches) {
+            auto range = index.find(match.hash);
+            REQUIRE(range.second - range.first == 1);
+        }
+    }
+    REQUIRE(index.find(0).first == index.find(0).second);
+}
+
+TEST_CASE("Minimizer indexes serialize and don't depend on the threads", "[minimizer]") {
+
+    simulate_params_t sim;
+    sim.length = 20000;
+    sim.node_length = 8;
+    sim.path_count = 4;
+    graph_t graph;
+    simulate_graph(sim, graph);
+
+    minimizer_params_t params;
+    params.k = 11;
+    params.w = 7;
+    minimizer_index_t serial, parallel;
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    serial.build(graph, params);
+    omp_set_num_threads(4);
+    parallel.build(graph, params);
+    omp_set_num_threads(threads);
+    stringstream serial_out, parallel_out;
+    uint64_t written = serial.serialize(serial_out);
+    parallel.serialize(parallel_out);
+    REQUIRE(written == serial_out.str().size());
+    REQUIRE(serial_out.str() == parallel_out.str());
+
+    minimizer_index_t loaded;
+    loaded.load(serial_out);
+    REQUIRE(loaded.get_params().k == 11);
+    REQUIRE(loaded.get_params().w == 7);
+    REQUIRE(loaded.size() == serial.size());
+    REQUIRE(loaded.hit_count() == serial.hit_count());
+    stringstream loaded_out;
+    loaded.serialize(loaded_out);
+    REQUIRE(loaded_out.str() == parallel_out.str());
+
+    stringstream garbage("not a minimizer index at all");
+    REQUIRE_THROWS(loaded.load(garbage));
+    params.w = minimizer_max_window + 1;
+    REQUIRE_THROWS(serial.build(graph, params));
+}
+
+}
+}
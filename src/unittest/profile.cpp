@@ -0,0 +1,44 @@
+/**
+ * \file
+ * unittest/profile.cpp: test cases for the primitive operation profiler.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("The profiler reports instrumented primitives only when compiled in", "[profile]") {
+
+    reset_profile();
+    graph_t graph;
+    handle_t h1 = graph.create_handle("GATT");
+    handle_t h2 = graph.create_handle("ACA");
+    graph.create_edge(h1, h2);
+    REQUIRE(graph.get_sequence(graph.get_handle(2)) == "ACA");
+
+    stringstream out;
+    graph_t::dump_profile(out);
+    string report = out.str();
+    if (profile_enabled()) {
+        REQUIRE(report.find("id_lookup") != string::npos);
+        REQUIRE(report.find("seq_decode") != string::npos);
+        REQUIRE(report.find("edge_insert") != string::npos);
+        reset_profile();
+        stringstream empty;
+        graph_t::dump_profile(empty);
+        REQUIRE(empty.str().find("id_lookup") == string::npos);
+    } else {
+        REQUIRE(report.find("not compiled in") != string::npos);
+    }
+}
+
+}
+}
@@ -0,0 +1,112 @@
+/**
+ * \file
+ * unittest/sequence_index.cpp: test cases for the FM-index of node sequences.
+ */
+
+#include "catch.hpp"
+
+#include "sequence_index.hpp"
+#include "simulate.hpp"
+
+#include <omp.h>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// Each oriented node and offset where the pattern starts, found by scanning
+static vector<pair<handle_t, uint64_t>> scanned_hits(const graph_t& graph, const string& pattern) {
+    vector<pair<handle_t, uint64_t>> hits;
+    for (uint64_t i = 0; i < graph.node_size(); ++i) {
+        for (bool is_rev : {false, true}) {
+            handle_t h = handle_helper::pack(i, is_rev);
+            string seq = graph.get_sequence(h);
+            for (size_t at = seq.find(pattern); at != string::npos; at = seq.find(pattern, at + 1)) {
+                hits.push_back(make_pair(h, at));
+            }
+        }
+    }
+    return hits;
+}
+
+TEST_CASE("Sequences are located on both strands of the nodes", "[sequence_index]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GATTACA", 1);
+    handle_t b = graph.create_handle("TGTA", 2);
+    handle_t c = graph.create_handle("ACANA", 3);
+    graph.create_edge(a, b);
+    graph.create_edge(b, c);
+
+    sequence_index_t index;
+    index.build(graph);
+    REQUIRE(index.node_count() == 3);
+
+    auto hits = index.locate("aca");
+    REQUIRE(hits.size() == 3);
+    REQUIRE(hits[0] == make_pair(a, uint64_t(4)));
+    REQUIRE(hits[1] == make_pair(graph.flip(b), uint64_t(1)));
+    REQUIRE(hits[2] == make_pair(c, uint64_t(0)));
+    REQUIRE(index.count("ACA") == 3);
+    REQUIRE(index.locate("TGTAAT") == scanned_hits(graph, "TGTAAT"));
+    REQUIRE(index.locate("TGTAAT").size() == 1);
+    // matches don't run across nodes
+    REQUIRE(index.locate("ACATGTA").empty());
+    REQUIRE(index.locate("A#").empty());
+    REQUIRE(index.locate("").empty());
+    REQUIRE(index.count("") == 0);
+
+    stringstream out;
+    uint64_t written = index.serialize(out);
+    REQUIRE(written == out.str().size());
+    sequence_index_t loaded;
+    loaded.load(out);
+    REQUIRE(loaded.locate("ACA") == hits);
+
+    graph_t empty;
+    sequence_index_t empty_index;
+    empty_index.build(empty);
+    REQUIRE(empty_index.locate("A").empty());
+    stringstream empty_out;
+    empty_index.serialize(empty_out);
+    loaded.load(empty_out);
+    REQUIRE(loaded.node_count() == 0);
+    stringstream garbage("not a sequence index");
+    REQUIRE_THROWS(loaded.load(garbage));
+}
+
+TEST_CASE("Located sequences match a scan of a simulated graph", "[sequence_index]") {
+
+    simulate_params_t sim;
+    sim.length = 5000;
+    sim.node_length = 20;
+    sim.inversion_rate = 0.002;
+    sim.path_count = 3;
+    graph_t graph;
+    simulate_graph(sim, graph);
+
+    sequence_index_t index;
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    index.build(graph);
+    omp_set_num_threads(threads);
+    REQUIRE(index.node_count() == graph.node_size());
+    for (uint64_t i = 0; i < graph.node_size(); i += 7) {
+        string seq = graph.get_sequence(handle_helper::pack(i, i % 2));
+        for (uint64_t length : {1, 4, 9}) {
+            if (seq.size() < length) continue;
+            string pattern = seq.substr(seq.size() - length);
+            auto hits = index.locate(pattern);
+            REQUIRE(hits == scanned_hits(graph, pattern));
+            REQUIRE(index.count(pattern) == hits.size());
+        }
+    }
+}
+
+}
+}
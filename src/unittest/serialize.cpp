@@ -0,0 +1,177 @@
+/**
+ * \file
+ * unittest/serialize.cpp: test cases for the serialized graph format.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Graphs round-trip through the sectioned file format", "[serialize]") {
+
+    graph_t graph;
+    handle_t h1 = graph.create_handle("GATT");
+    handle_t h2 = graph.create_handle("ACA");
+    handle_t h3 = graph.create_handle("CA");
+    graph.create_edge(h1, h2);
+    graph.create_edge(h2, h3);
+    graph.create_edge(h1, graph.flip(h3));
+    path_handle_t p = graph.create_path_handle("x");
+    graph.append_occurrence(p, h1);
+    graph.append_occurrence(p, h2);
+    graph.append_occurrence(p, h3);
+
+    stringstream out;
+    uint64_t written = graph.serialize(out);
+    string bytes = out.str();
+    REQUIRE(written == bytes.size());
+
+    SECTION("Everything is restored by a full load") {
+        graph_t loaded;
+        stringstream in(bytes);
+        loaded.load(in);
+        REQUIRE(loaded.node_size() == 3);
+        REQUIRE(loaded.get_sequence(loaded.get_handle(1)) == "GATT");
+        REQUIRE(loaded.get_sequence(loaded.get_handle(3, true)) == "TG");
+        int degree = 0;
+        loaded.follow_edges(loaded.get_handle(1), false, [&](const handle_t& h) { ++degree; });
+        REQUIRE(degree == 2);
+        REQUIRE(loaded.has_path("x"));
+        path_handle_t q = loaded.get_path_handle("x");
+        vector<id_t> ids;
+        loaded.for_each_occurrence_in_path(q, [&](const occurrence_handle_t& occ) {
+                ids.push_back(loaded.get_id(loaded.get_occurrence(occ)));
+            });
+        REQUIRE(ids == vector<id_t>({1, 2, 3}));
+    }
+
+    SECTION("Components left out of the mask are not materialized") {
+        graph_t loaded;
+        stringstream in(bytes);
+        loaded.load(in, COMPONENT_SEQUENCE);
+        REQUIRE(loaded.get_path_count() == 1);
+        REQUIRE(loaded.get_length(handle_helper::pack(1, false)) == 3);
+        REQUIRE(!loaded.has_path("x"));
+    }
+
+    SECTION("Corrupted sections are detected") {
+        // flip a bit in the last byte, which belongs to the final section
+        bytes[bytes.size()-1] ^= 1;
+        graph_t loaded;
+        stringstream in(bytes);
+        REQUIRE_THROWS(loaded.load(in));
+    }
+
+    SECTION("Sections placed inside the header are rejected") {
+        // the first section record follows 10 header words; point its offset at the file start
+        uint64_t offset = 0;
+        bytes.replace(10 * sizeof(uint64_t) + offsetof(graph_section_t, offset), sizeof(offset),
+                      (char*)&offset, sizeof(offset));
+        graph_t loaded;
+        stringstream in(bytes);
+        REQUIRE_THROWS(loaded.load(in));
+    }
+
+    SECTION("Compressed sequence and path sections load back identically") {
+        stringstream zout;
+        graph.serialize(zout, true);
+        graph_t loaded;
+        stringstream in(zout.str());
+        loaded.load(in);
+        REQUIRE(loaded.get_sequence(loaded.get_handle(2)) == "ACA");
+        REQUIRE(loaded.get_occurrence_count(loaded.get_path_handle("x")) == 3);
+    }
+
+    SECTION("Scattered ids and long path names load back from their bulk arrays") {
+        graph.create_handle("T", 5000000);
+        string long_name(1 << 20, 'n');
+        path_handle_t q = graph.create_path_handle(long_name);
+        graph.append_occurrence(q, graph.get_handle(5000000));
+        stringstream sout;
+        graph.serialize(sout);
+        graph_t loaded;
+        stringstream in(sout.str());
+        loaded.load(in);
+        REQUIRE(loaded.get_sequence(loaded.get_handle(5000000)) == "T");
+        REQUIRE(loaded.get_sequence(loaded.get_handle(2)) == "ACA");
+        REQUIRE(loaded.has_path(long_name));
+        REQUIRE(loaded.get_path_name(loaded.get_path_handle(long_name)) == long_name);
+        REQUIRE(loaded.get_occurrence_count(loaded.get_path_handle("x")) == 3);
+    }
+
+    SECTION("Streams that are not graphs are rejected") {
+        graph_t loaded;
+        stringstream in("not a graph at all");
+        REQUIRE_THROWS(loaded.load(in));
+    }
+}
+
+TEST_CASE("Version 3 graphs load with one entry per reversing self edge", "[serialize]") {
+
+    // version 3 stored each reversing self edge twice in the same record,
+    // which creating it twice reproduces
+    graph_t graph;
+    handle_t a = graph.create_handle("GATT", 1);
+    handle_t b = graph.create_handle("ACA", 2);
+    graph.create_edge(a, b);
+    graph.create_edge(a, graph.flip(a));
+    graph.create_edge(a, graph.flip(a));
+    graph.create_edge(graph.flip(b), b);
+    graph.create_edge(graph.flip(b), b);
+    stringstream out;
+    graph.serialize(out);
+    string bytes = out.str();
+    uint64_t version = 3;
+    bytes.replace(sizeof(uint64_t), sizeof(version), (char*)&version, sizeof(version));
+
+    graph_t loaded;
+    stringstream in(bytes);
+    loaded.load(in);
+    REQUIRE(loaded.get_degree(loaded.get_handle(1), false) == 2);
+    REQUIRE(loaded.get_degree(loaded.get_handle(2), true) == 2);
+    REQUIRE(loaded.has_edge(loaded.get_handle(1), loaded.get_handle(1, true)));
+    loaded.destroy_edge(loaded.get_handle(1), loaded.get_handle(1, true));
+    REQUIRE(!loaded.has_edge(loaded.get_handle(1), loaded.get_handle(1, true)));
+    REQUIRE(loaded.get_degree(loaded.get_handle(1), false) == 1);
+
+    // versions before 3 and after the current one are refused
+    for (uint64_t other : {graph_format_min_version - 1, graph_format_version + 1}) {
+        bytes.replace(sizeof(uint64_t), sizeof(other), (char*)&other, sizeof(other));
+        graph_t refused;
+        stringstream refused_in(bytes);
+        REQUIRE_THROWS(refused.load(refused_in));
+    }
+}
+
+TEST_CASE("Block compression round-trips across block boundaries", "[serialize]") {
+    string raw;
+    for (size_t i = 0; i < 10000; ++i) {
+        raw.push_back("ACGT"[(i * 7 + i / 13) % 4]);
+    }
+    for (uint64_t block_size : {1, 100, 4096, 10000, 1 << 20}) {
+        string stored = compress_blocks(raw, block_size);
+        REQUIRE(decompress_blocks(stored) == raw);
+    }
+    REQUIRE(decompress_blocks(compress_blocks("")) == "");
+    string stored = compress_blocks(raw, 100);
+    stored.resize(stored.size()-1);
+    REQUIRE_THROWS(decompress_blocks(stored));
+    // a header claiming empty blocks is rejected before it's divided by
+    string zero = compress_blocks(raw, 100);
+    uint64_t block_size = 0;
+    zero.replace(sizeof(uint64_t), sizeof(block_size), (char*)&block_size, sizeof(block_size));
+    REQUIRE_THROWS(decompress_blocks(zero));
+}
+
+}
+}
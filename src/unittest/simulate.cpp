@@ -0,0 +1,83 @@
+/**
+ * \file
+ * unittest/simulate.cpp: test cases for the synthetic graph generator.
+ */
+
+#include "catch.hpp"
+
+#include "simulate.hpp"
+
+#include <sstream>
+#include <string>
+#include <set>
+#include <tuple>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Simulated graphs are reproducible and their paths follow edges", "[simulate]") {
+
+    simulate_params_t params;
+    params.length = 5000;
+    params.node_length = 8;
+    params.snp_rate = 0.01;
+    params.indel_rate = 0.005;
+    params.inversion_rate = 0.002;
+    params.path_count = 5;
+
+    SECTION("The same seed gives the same GFA and a different seed does not") {
+        stringstream a, b, c;
+        simulate_gfa(params, a);
+        simulate_gfa(params, b);
+        params.seed += 1;
+        simulate_gfa(params, c);
+        REQUIRE(a.str() == b.str());
+        REQUIRE(a.str() != c.str());
+    }
+
+    SECTION("Every path step crosses an edge of the graph") {
+        set<tuple<uint64_t, bool, uint64_t, bool>> edges;
+        uint64_t bases = 0, nodes = 0;
+        set<string> paths;
+        string curr;
+        uint64_t prev_id = 0;
+        bool prev_rev = false;
+        bool ok = true;
+        simulate_graph(params,
+                       [&](uint64_t id, const string& seq) {
+                           bases += seq.size();
+                           ++nodes;
+                       },
+                       [&](uint64_t from_id, bool from_rev, uint64_t to_id, bool to_rev) {
+                           edges.insert(make_tuple(from_id, from_rev, to_id, to_rev));
+                       },
+                       [&](const string& name, uint64_t id, bool is_rev) {
+                           if (name != curr) {
+                               paths.insert(name);
+                               curr = name;
+                           } else if (!edges.count(make_tuple(prev_id, prev_rev, id, is_rev))) {
+                               ok = false;
+                           }
+                           prev_id = id;
+                           prev_rev = is_rev;
+                       });
+        REQUIRE(ok);
+        REQUIRE(paths.size() == 5);
+        REQUIRE(bases >= params.length);
+        REQUIRE(nodes > params.length / params.node_length);
+    }
+
+    SECTION("Graphs can be built directly") {
+        params.length = 500;
+        graph_t graph;
+        simulate_graph(params, graph);
+        REQUIRE(graph.get_path_count() == 5);
+        REQUIRE(graph.has_path("hap0"));
+        REQUIRE(graph.get_occurrence_count(graph.get_path_handle("hap4")) > 0);
+    }
+}
+
+}
+}
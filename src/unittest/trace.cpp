@@ -0,0 +1,75 @@
+/**
+ * \file
+ * unittest/trace.cpp: test cases for operation tracing and replay.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "trace.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Traced operations replay into an identical graph", "[trace]") {
+
+    graph_t original;
+    stringstream log;
+    {
+        trace_writer_t writer(log);
+        traced_graph_t traced(original, writer);
+        handle_t h1 = traced.create_handle("GATT", 1);
+        handle_t h2 = traced.create_handle("ACA", 2);
+        handle_t h3 = traced.create_handle("CA", 300);
+        traced.create_edge(h1, h2);
+        traced.create_edge(h2, traced.flip(h3));
+        path_handle_t p = traced.create_path_handle("x");
+        traced.append_occurrence(p, h1);
+        traced.append_occurrence(p, h2);
+        traced.append_occurrence(p, traced.flip(h3));
+        traced.follow_edges(h2, true, [&](const handle_t& h) { });
+        REQUIRE(traced.get_sequence(traced.get_handle(300, true)) == "TG");
+        traced.for_each_occurrence_in_path(p, [&](const occurrence_handle_t& occ) { });
+    }
+
+    graph_t replayed;
+    stringstream in(log.str());
+    vector<bench_result_t> results = replay_trace(in, replayed);
+
+    REQUIRE(replayed.node_size() == 3);
+    REQUIRE(replayed.get_sequence(replayed.get_handle(300)) == "CA");
+    int degree = 0;
+    replayed.follow_edges(replayed.get_handle(2), false, [&](const handle_t& h) {
+            REQUIRE(h == replayed.get_handle(300, true));
+            ++degree;
+        });
+    REQUIRE(degree == 1);
+    REQUIRE(replayed.get_occurrence_count(replayed.get_path_handle("x")) == 3);
+
+    uint64_t creates = 0, walks = 0;
+    for (auto& r : results) {
+        if (r.name == "create_handle") creates = r.ops;
+        if (r.name == "walk_path") walks = r.ops;
+    }
+    REQUIRE(creates == 3);
+    REQUIRE(walks == 1);
+
+    SECTION("Truncated and foreign traces are rejected") {
+        string bytes = log.str();
+        bytes.resize(bytes.size() - 1);
+        graph_t g;
+        stringstream truncated(bytes);
+        REQUIRE_THROWS(replay_trace(truncated, g));
+        stringstream foreign("definitely not a trace");
+        REQUIRE_THROWS(replay_trace(foreign, g));
+    }
+}
+
+}
+}
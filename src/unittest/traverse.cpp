@@ -0,0 +1,209 @@
+/**
+ * \file
+ * unittest/traverse.cpp: test cases for the graph traversals.
+ */
+
+#include "catch.hpp"
+
+#include "traverse.hpp"
+#include "simulate.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include <unordered_map>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// Distances in steps from the seeds, the slow way
+static unordered_map<uint64_t, uint64_t> reference_distances(const graph_t& graph, const vector<handle_t>& seeds) {
+    unordered_map<uint64_t, uint64_t> dist;
+    vector<handle_t> queue;
+    for (auto& seed : seeds) {
+        handle_t h = graph.get_handle(graph.get_id(seed));
+        if (dist.count(graph.get_id(h))) continue;
+        dist[graph.get_id(h)] = 0;
+        queue.push_back(h);
+    }
+    for (size_t i = 0; i < queue.size(); ++i) {
+        uint64_t d = dist[graph.get_id(queue[i])];
+        for (bool go_left : {false, true}) {
+            graph.follow_edges(queue[i], go_left, [&](const handle_t& next) {
+                    if (!dist.count(graph.get_id(next))) {
+                        dist[graph.get_id(next)] = d + 1;
+                        queue.push_back(graph.get_handle(graph.get_id(next)));
+                    }
+                });
+        }
+    }
+    return dist;
+}
+
+TEST_CASE("Traversals visit what a naive search does", "[traverse]") {
+
+    simulate_params_t params;
+    params.length = 5000;
+    params.node_length = 8;
+    params.inversion_rate = 0.002;
+    params.path_count = 1;
+    graph_t graph;
+    simulate_graph(params, graph);
+    vector<handle_t> all;
+    graph.for_each_handle([&](const handle_t& h) { all.push_back(h); });
+
+    SECTION("Breadth-first levels match the distances from the seeds") {
+        // one seed keeps the frontier small; many seeds make the search go bottom-up
+        for (size_t stride : {all.size(), (size_t) 7}) {
+            vector<handle_t> seeds;
+            for (size_t i = 0; i < all.size(); i += stride) {
+                seeds.push_back(all[i]);
+            }
+            auto dist = reference_distances(graph, seeds);
+            bfs_levels_t levels = bfs(graph, seeds);
+            REQUIRE(levels.nodes.size() == dist.size());
+            for (uint64_t d = 0; d < levels.level_count(); ++d) {
+                for (uint64_t i = levels.level_offsets[d]; i < levels.level_offsets[d+1]; ++i) {
+                    REQUIRE(!graph.get_is_reverse(levels.nodes[i]));
+                    REQUIRE(dist[graph.get_id(levels.nodes[i])] == d);
+                }
+            }
+            bfs_levels_t bounded = bfs(graph, seeds, 3);
+            REQUIRE(bounded.level_count() <= 4);
+            REQUIRE(bounded.level_offsets.back() == levels.level_offsets[bounded.level_count()]);
+        }
+    }
+
+    SECTION("Contexts by steps hold the nodes within that many steps") {
+        context_params_t bounds;
+        bounds.max_steps = 4;
+        context_scratch_t scratch;
+        vector<handle_t> nodes;
+        for (size_t i = 0; i < all.size(); i += 97) {
+            auto dist = reference_distances(graph, {all[i]});
+            expand_context(graph, all[i], bounds, scratch, nodes);
+            REQUIRE(nodes.front() == all[i]);
+            set<uint64_t> got, expected;
+            for (auto& h : nodes) got.insert(graph.get_id(h));
+            for (auto& d : dist) {
+                if (d.second <= bounds.max_steps) expected.insert(d.first);
+            }
+            REQUIRE(got == expected);
+            REQUIRE(got.size() == nodes.size());
+            // the scratch space is left clear for the next seed
+            REQUIRE(scratch.visited.count() == 0);
+        }
+    }
+
+    SECTION("Contexts expanded in parallel match those expanded one at a time") {
+        context_params_t bounds;
+        bounds.max_bp = 20;
+        vector<handle_t> seeds(all.begin(), all.begin() + min<size_t>(all.size(), 500));
+        vector<vector<handle_t>> contexts(seeds.size());
+        for_each_context(graph, seeds, bounds, [&](uint64_t i, const vector<handle_t>& nodes) {
+                contexts[i] = nodes;
+            });
+        auto as_set = [](const vector<handle_t>& handles) {
+            set<uint64_t> result;
+            for (auto& h : handles) result.insert(as_integer(h));
+            return result;
+        };
+        context_scratch_t scratch;
+        vector<handle_t> nodes;
+        for (size_t i = 0; i < seeds.size(); ++i) {
+            expand_context(graph, seeds[i], bounds, scratch, nodes);
+            REQUIRE(as_set(nodes) == as_set(contexts[i]));
+        }
+    }
+}
+
+TEST_CASE("Contexts can be bounded in bases", "[traverse]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GAT", 1);
+    handle_t b = graph.create_handle("TACA", 2);
+    handle_t c = graph.create_handle("CATTA", 3);
+    handle_t d = graph.create_handle("GATTAC", 4);
+    handle_t e = graph.create_handle("A", 5);
+    graph.create_edge(a, b);
+    graph.create_edge(b, c);
+    graph.create_edge(c, d);
+    // a short way round to d through e, entered from its other side
+    graph.create_edge(a, e);
+    graph.create_edge(e, graph.flip(d));
+
+    context_params_t bounds;
+    context_scratch_t scratch;
+    vector<handle_t> nodes;
+    auto ids = [&]() {
+        vector<id_t> result;
+        for (auto& h : nodes) result.push_back(graph.get_id(h));
+        return result;
+    };
+
+    bounds.max_bp = 3;
+    expand_context(graph, b, bounds, scratch, nodes);
+    REQUIRE(ids() == vector<id_t>({2, 1, 3, 5}));
+    bounds.max_bp = 1;
+    expand_context(graph, a, bounds, scratch, nodes);
+    REQUIRE(ids() == vector<id_t>({1, 2, 5, 4}));
+    // d is two steps from b but more than 3 bases from it
+    bounds.max_bp = 3;
+    bounds.max_steps = 2;
+    expand_context(graph, b, bounds, scratch, nodes);
+    REQUIRE(ids() == vector<id_t>({2, 1, 3, 5, 4}));
+    REQUIRE(scratch.visited.count() == 0);
+    REQUIRE(scratch.stepped.count() == 0);
+    bounds.max_bp = 0;
+    bounds.max_steps = 0;
+    expand_context(graph, c, bounds, scratch, nodes);
+    REQUIRE(ids() == vector<id_t>({3}));
+}
+
+TEST_CASE("Depth-first search enters each node once and finishes children first", "[traverse]") {
+
+    graph_t graph;
+    vector<handle_t> h;
+    for (id_t id = 1; id <= 6; ++id) {
+        h.push_back(graph.create_handle("A", id));
+    }
+    // a DAG in the forward orientation, with a reversing edge off to node 6
+    graph.create_edge(h[0], h[1]);
+    graph.create_edge(h[0], h[2]);
+    graph.create_edge(h[1], h[3]);
+    graph.create_edge(h[2], h[3]);
+    graph.create_edge(h[3], h[4]);
+    graph.create_edge(h[4], graph.flip(h[5]));
+
+    vector<handle_t> pre, post;
+    dfs(graph, {h[0], h[2]}, [&](const handle_t& x) { pre.push_back(x); },
+        [&](const handle_t& x) { post.push_back(x); });
+    REQUIRE(pre.size() == 6);
+    REQUIRE(post.size() == 6);
+    REQUIRE(pre.front() == h[0]);
+    REQUIRE(post.back() == h[0]);
+    REQUIRE(find(pre.begin(), pre.end(), graph.flip(h[5])) != pre.end());
+    // every edge goes from a node finished later to one finished earlier
+    map<uint64_t, size_t> finished;
+    for (size_t i = 0; i < post.size(); ++i) {
+        finished[as_integer(post[i])] = i;
+    }
+    graph.for_each_edge([&](const edge_t& edge) {
+            handle_t from = edge.first, to = edge.second;
+            if (!finished.count(as_integer(from))) {
+                from = graph.flip(edge.second);
+                to = graph.flip(edge.first);
+            }
+            REQUIRE(finished[as_integer(from)] > finished[as_integer(to)]);
+            return true;
+        });
+
+    // the same search without callbacks does nothing visible
+    dfs(graph, {h[5]}, nullptr, nullptr);
+}
+
+}
+}
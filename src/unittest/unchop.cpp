@@ -0,0 +1,133 @@
+/**
+ * \file
+ * unittest/unchop.cpp: test cases for merging chains of nodes.
+ */
+
+#include "catch.hpp"
+
+#include "graph.hpp"
+#include "simulate.hpp"
+#include "helpers.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace unittest {
+
+using namespace std;
+
+/// The ids and orientations of the steps of a path
+static vector<pair<id_t, bool>> path_steps(const graph_t& graph, const string& name) {
+    vector<pair<id_t, bool>> steps;
+    graph.for_each_occurrence_in_path(graph.get_path_handle(name), [&](const occurrence_handle_t& occ) {
+            handle_t h = graph.get_occurrence(occ);
+            steps.push_back(make_pair(graph.get_id(h), graph.get_is_reverse(h)));
+        });
+    return steps;
+}
+
+TEST_CASE("Unchop merges the chains that paths go straight through", "[unchop]") {
+
+    graph_t graph;
+    vector<handle_t> h;
+    vector<string> seqs = {"GA", "CCA", "TT", "A", "C", "GAT", "TACA", "G"};
+    for (id_t id = 1; id <= seqs.size(); ++id) {
+        h.push_back(graph.create_handle(seqs[id-1], id));
+    }
+    graph.create_edge(h[0], graph.flip(h[1]));
+    graph.create_edge(graph.flip(h[1]), h[2]);
+    graph.create_edge(h[2], h[3]);
+    graph.create_edge(h[2], h[4]);
+    graph.create_edge(h[3], h[5]);
+    graph.create_edge(h[4], h[5]);
+    graph.create_edge(h[5], h[6]);
+    graph.create_edge(h[6], h[7]);
+    auto make_path = [&](const string& name, const vector<handle_t>& steps) {
+        path_handle_t p = graph.create_path_handle(name);
+        for (auto& s : steps) graph.append_occurrence(p, s);
+    };
+    make_path("x", {h[0], graph.flip(h[1]), h[2], h[3], h[5], h[6], h[7]});
+    // ends on 7, so 7 and 8 stay apart
+    make_path("y", {h[0], graph.flip(h[1]), h[2], h[4], h[5], h[6]});
+    auto before = path_sequences(graph);
+
+    graph.unchop();
+    REQUIRE(graph.node_size() == 5);
+    REQUIRE(graph.get_sequence(graph.get_handle(1)) == "GATGGTT");
+    REQUIRE(graph.get_sequence(graph.get_handle(6)) == "GATTACA");
+    for (id_t id : {2, 3, 7}) {
+        REQUIRE(!graph.has_node(id));
+    }
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(4)));
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(5)));
+    REQUIRE(graph.has_edge(graph.get_handle(4), graph.get_handle(6)));
+    REQUIRE(graph.has_edge(graph.get_handle(5), graph.get_handle(6)));
+    REQUIRE(graph.has_edge(graph.get_handle(6), graph.get_handle(8)));
+    uint64_t edge_count = 0;
+    graph.for_each_edge([&](const edge_t& e) { ++edge_count; return true; });
+    REQUIRE(edge_count == 5);
+    REQUIRE(path_steps(graph, "x") == vector<pair<id_t, bool>>({{1, false}, {4, false}, {6, false}, {8, false}}));
+    REQUIRE(path_steps(graph, "y") == vector<pair<id_t, bool>>({{1, false}, {5, false}, {6, false}}));
+    REQUIRE(path_sequences(graph) == before);
+}
+
+TEST_CASE("Unchop closes a cycle of nodes with a self edge", "[unchop]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GAT", 1);
+    handle_t b = graph.create_handle("TA", 2);
+    handle_t c = graph.create_handle("CA", 3);
+    graph.create_edge(a, b);
+    graph.create_edge(b, c);
+    graph.create_edge(c, a);
+
+    graph.unchop();
+    REQUIRE(graph.node_size() == 1);
+    handle_t merged = graph.get_handle(1);
+    REQUIRE(graph.get_sequence(merged) == "GATTACA");
+    REQUIRE(graph.has_edge(merged, merged));
+    REQUIRE(graph.get_degree(merged, false) == 1);
+    REQUIRE(graph.get_degree(merged, true) == 1);
+}
+
+TEST_CASE("Unchop keeps hidden nodes hidden", "[unchop]") {
+
+    graph_t graph;
+    handle_t a = graph.create_handle("GAT", 1);
+    handle_t b = graph.create_handle("TACA", 2);
+    graph.create_edge(a, b);
+    handle_t h = graph.create_hidden_handle("CAT");
+    REQUIRE(graph.get_id(h) == 3);
+
+    graph.unchop();
+    REQUIRE(graph.node_size() == 2);
+    REQUIRE(graph.has_node(1));
+    REQUIRE(!graph.has_node(3));
+    REQUIRE(graph.get_sequence(graph.get_handle(3)) == "CAT");
+}
+
+TEST_CASE("Unchop keeps the sequences of simulated paths", "[unchop]") {
+
+    simulate_params_t params;
+    params.length = 20000;
+    params.node_length = 4;
+    params.inversion_rate = 0.002;
+    params.path_count = 3;
+    graph_t graph;
+    simulate_graph(params, graph);
+    auto before = path_sequences(graph);
+    uint64_t nodes_before = graph.node_size();
+
+    graph.unchop();
+    REQUIRE(graph.node_size() < nodes_before);
+    REQUIRE(path_sequences(graph) == before);
+    // nothing is left to merge
+    uint64_t nodes_after = graph.node_size();
+    graph.unchop();
+    REQUIRE(graph.node_size() == nodes_after);
+}
+
+}
+}